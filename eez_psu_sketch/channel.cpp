@@ -41,6 +41,12 @@
 #include "list.h"
 #include "trigger.h"
 #include "io_pins.h"
+#include "stream.h"
+#include "threshold.h"
+#include "sequencer.h"
+#if OPTION_SD_CARD
+#include "dlog.h"
+#endif
 
 namespace eez {
 namespace psu {
@@ -98,52 +104,67 @@ void Channel::Value::init(float set_, float step_, float limit_) {
 
 void Channel::Value::resetMonValues() {
     mon_adc = 0;
-    mon = 0;
     mon_last = 0;
-    mon_dac = 0;
 
-    mon_index = -1;
-    mon_dac_index = -1;
+    mon_average.reset();
+    mon_dac_average.reset();
 
     mon_measured = false;
 }
 
-void Channel::Value::addMonValue(float value) {
+void Channel::Value::addMonValue(int16_t adc_data, float value) {
     mon_last = value;
+    mon_average.add(adc_data);
+    mon_measured = true;
+}
 
-    if (mon_index == -1) {
-        mon_index = 0;
-        for (int i = 0; i < NUM_ADC_AVERAGING_VALUES; ++i) {
-            mon_arr[i] = value;
-        }
-        mon_total = NUM_ADC_AVERAGING_VALUES * value;
-        mon = value;
-    } else {
-        mon_total -= mon_arr[mon_index]; 
-        mon_total += value;
-        mon_arr[mon_index] = value;
-        mon_index = (mon_index + 1) % NUM_ADC_AVERAGING_VALUES;
-        mon = mon_total / NUM_ADC_AVERAGING_VALUES;
-    }
+void Channel::Value::addMonDacValue(int16_t adc_data) {
+    mon_dac_average.add(adc_data);
+}
 
-    mon_measured = true;
+////////////////////////////////////////////////////////////////////////////////
+
+void Channel::AdcAverage::setup(AveragingType type_, uint16_t count_) {
+    type = type_;
+    count = count_;
+    reset();
+}
+
+void Channel::AdcAverage::reset() {
+    empty = true;
 }
 
-void Channel::Value::addMonDacValue(float value) {
-    if (mon_dac_index == -1) {
-        mon_dac_index = 0;
-        for (int i = 0; i < NUM_ADC_AVERAGING_VALUES; ++i) {
-            mon_dac_arr[i] = value;
+void Channel::AdcAverage::add(int16_t adc_data) {
+    if (type == AVERAGING_TYPE_EXPONENTIAL) {
+        if (empty) {
+            total = (int32_t)adc_data << 8;
+            empty = false;
+        } else {
+            total += (((int32_t)adc_data << 8) - total) / count;
         }
-        mon_dac_total = NUM_ADC_AVERAGING_VALUES * value;
-        mon_dac = value;
     } else {
-        mon_dac_total -= mon_dac_arr[mon_dac_index]; 
-        mon_dac_total += value;
-        mon_dac_arr[mon_dac_index] = value;
-        mon_dac_index = (mon_dac_index + 1) % NUM_ADC_AVERAGING_VALUES;
-        mon_dac = mon_dac_total / NUM_ADC_AVERAGING_VALUES;
+        if (empty) {
+            for (int i = 0; i < count; ++i) {
+                arr[i] = adc_data;
+            }
+            total = (int32_t)count * adc_data;
+            index = 0;
+            empty = false;
+        } else {
+            total += adc_data - arr[index];
+            arr[index] = adc_data;
+            if (++index == count) {
+                index = 0;
+            }
+        }
+    }
+}
+
+float Channel::AdcAverage::get() const {
+    if (type == AVERAGING_TYPE_EXPONENTIAL) {
+        return total / 256.0f;
     }
+    return (float)total / count;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -345,6 +366,8 @@ Channel::Channel(
     uBeforeBalancing = NAN;
     iBeforeBalancing = NAN;
 
+    setAveraging(AVERAGING_TYPE_MOVING, ADC_AVERAGING_COUNT_DEF);
+
     flags.currentCurrentRange = CURRENT_RANGE_HIGH;
     flags.currentRangeSelectionMode = CURRENT_RANGE_SELECTION_USE_BOTH;
     flags.autoSelectCurrentRange = 1;
@@ -540,6 +563,10 @@ void Channel::reset() {
     u.init(U_MIN, U_DEF_STEP, u.max);
     i.init(I_MIN, I_DEF_STEP, i.max);
 
+    // SENS:AVER:TCON MOV
+    // SENS:AVER:COUN 30
+    setAveraging(AVERAGING_TYPE_MOVING, ADC_AVERAGING_COUNT_DEF);
+
     maxCurrentLimitCause = MAX_CURRENT_LIMIT_CAUSE_NONE;
     p_limit = PTOT;
 
@@ -779,12 +806,12 @@ void Channel::tick(uint32_t tick_usec) {
     doAutoSelectCurrentRange(tick_usec);
 }
 
-float Channel::remapAdcDataToVoltage(int16_t adc_data) {
-    return util::remap((float)adc_data, (float)AnalogDigitalConverter::ADC_MIN, U_MIN, (float)AnalogDigitalConverter::ADC_MAX, U_MAX_CONF);
+float Channel::remapAdcDataToVoltage(float adc_data) const {
+    return util::remap(adc_data, (float)AnalogDigitalConverter::ADC_MIN, U_MIN, (float)AnalogDigitalConverter::ADC_MAX, U_MAX_CONF);
 }
 
-float Channel::remapAdcDataToCurrent(int16_t adc_data) {
-    return util::remap((float)adc_data, (float)AnalogDigitalConverter::ADC_MIN, I_MIN, (float)AnalogDigitalConverter::ADC_MAX, getDualRangeMax());
+float Channel::remapAdcDataToCurrent(float adc_data) const {
+    return util::remap(adc_data, (float)AnalogDigitalConverter::ADC_MIN, I_MIN, (float)AnalogDigitalConverter::ADC_MAX, getDualRangeMax());
 }
 
 int16_t Channel::remapVoltageToAdcData(float value) {
@@ -797,6 +824,80 @@ int16_t Channel::remapCurrentToAdcData(float value) {
     return (int16_t)util::clamp(adc_value, (float)(-AnalogDigitalConverter::ADC_MAX - 1), (float)AnalogDigitalConverter::ADC_MAX);
 }
 
+float Channel::getVoltageFromAdcData(float adc_data) const {
+    float value = remapAdcDataToVoltage(adc_data);
+
+#if !defined(EEZ_PSU_SIMULATOR)
+    value -= VOLTAGE_GND_OFFSET;
+#endif
+
+    if (isVoltageCalibrationEnabled()) {
+        value = util::remap(value, cal_conf.u.min.adc, cal_conf.u.min.val, cal_conf.u.max.adc, cal_conf.u.max.val);
+    }
+
+    return value;
+}
+
+float Channel::getCurrentFromAdcData(float adc_data, uint8_t currentRange) const {
+    float value = util::remap(adc_data, (float)AnalogDigitalConverter::ADC_MIN, I_MIN, (float)AnalogDigitalConverter::ADC_MAX, getDualRangeMax(currentRange));
+
+    value -= getDualRangeGndOffset(currentRange);
+
+    if (isCurrentCalibrationEnabled(currentRange)) {
+        value = util::remap(value,
+            cal_conf.i[currentRange].min.adc,
+            cal_conf.i[currentRange].min.val,
+            cal_conf.i[currentRange].max.adc,
+            cal_conf.i[currentRange].max.val);
+    }
+
+    return value;
+}
+
+float Channel::getUMon() const {
+    if (u.mon_average.empty) {
+        return u.mon_last;
+    }
+    return getVoltageFromAdcData(u.mon_average.get());
+}
+
+float Channel::getIMon() const {
+    if (i.mon_average.empty) {
+        return i.mon_last;
+    }
+    return getCurrentFromAdcData(i.mon_average.get(), flags.currentCurrentRange);
+}
+
+float Channel::getUMonDac() const {
+    if (u.mon_dac_average.empty) {
+        return 0;
+    }
+
+    float value = remapAdcDataToVoltage(u.mon_dac_average.get());
+
+#if !defined(EEZ_PSU_SIMULATOR)
+    if (!flags.rprogEnabled) {
+        value -= VOLTAGE_GND_OFFSET;
+    }
+#endif
+
+    return value;
+}
+
+float Channel::getIMonDac() const {
+    if (i.mon_dac_average.empty) {
+        return 0;
+    }
+    return remapAdcDataToCurrent(i.mon_dac_average.get()) - getDualRangeGndOffset();
+}
+
+void Channel::setAveraging(AveragingType type, uint16_t count) {
+    u.mon_average.setup(type, count);
+    u.mon_dac_average.setup(type, count);
+    i.mon_average.setup(type, count);
+    i.mon_dac_average.setup(type, count);
+}
+
 void Channel::adcDataIsReady(int16_t data, bool startAgain) {
     uint8_t nextStartReg0 = 0;
 
@@ -819,26 +920,15 @@ void Channel::adcDataIsReady(int16_t data, bool startAgain) {
         //}
         u.mon_adc = data;
 
-        float value;
-        if (isVoltageCalibrationEnabled()) {
+        u.addMonValue(data, getVoltageFromAdcData(data));
 
-            value = remapAdcDataToVoltage(data);
+        threshold::onMonValue(*this, threshold::FUNCTION_VOLTAGE);
+        sequencer::onMonValue(*this, threshold::FUNCTION_VOLTAGE);
 
-#if !defined(EEZ_PSU_SIMULATOR)
-            value -= VOLTAGE_GND_OFFSET;
+#if OPTION_SD_CARD
+        dlog::onAdcData(index - 1, dlog::ADC_DATA_U_MON, data);
 #endif
 
-            value = util::remap(value, cal_conf.u.min.adc, cal_conf.u.min.val, cal_conf.u.max.adc, cal_conf.u.max.val);
-        } else {
-            value = remapAdcDataToVoltage(data);
-
-#if !defined(EEZ_PSU_SIMULATOR)
-            value -= VOLTAGE_GND_OFFSET;
-#endif
-        }
-
-        u.addMonValue(value);
-
         nextStartReg0 = AnalogDigitalConverter::ADC_REG0_READ_I_MON;
     }
     break;
@@ -854,17 +944,18 @@ void Channel::adcDataIsReady(int16_t data, bool startAgain) {
         //}
         i.mon_adc = data;
 
-        float value = remapAdcDataToCurrent(data) - getDualRangeGndOffset();
+        i.addMonValue(data, getCurrentFromAdcData(data, flags.currentCurrentRange));
 
-        if (isCurrentCalibrationEnabled()) {
-            value = util::remap(value,
-                cal_conf.i[flags.currentCurrentRange].min.adc,
-                cal_conf.i[flags.currentCurrentRange].min.val,
-                cal_conf.i[flags.currentCurrentRange].max.adc,
-                cal_conf.i[flags.currentCurrentRange].max.val);
-        }
+        threshold::onMonValue(*this, threshold::FUNCTION_CURRENT);
+        sequencer::onMonValue(*this, threshold::FUNCTION_CURRENT);
+
+#if OPTION_SD_CARD
+        dlog::onAdcData(index - 1,
+            flags.currentCurrentRange == CURRENT_RANGE_LOW ? dlog::ADC_DATA_I_MON_RANGE_LOW : dlog::ADC_DATA_I_MON_RANGE_HIGH,
+            data);
+#endif
 
-        i.addMonValue(value);
+        stream::onMonValues(*this);
 
         if (isOutputEnabled()) {
             if (isRemoteProgrammingEnabled()) {
@@ -878,6 +969,9 @@ void Channel::adcDataIsReady(int16_t data, bool startAgain) {
             u.resetMonValues();
             i.resetMonValues();
 
+            threshold::resetState(*this);
+            sequencer::resetThresholdState(*this);
+
             nextStartReg0 = AnalogDigitalConverter::ADC_REG0_READ_U_SET;
         }
     }
@@ -889,21 +983,7 @@ void Channel::adcDataIsReady(int16_t data, bool startAgain) {
         debug::g_uMonDac[index - 1].set(data);
 #endif
 
-        float value = remapAdcDataToVoltage(data);
-
-#if !defined(EEZ_PSU_SIMULATOR)
-        if (!flags.rprogEnabled) {
-            value -= VOLTAGE_GND_OFFSET;
-        }
-#endif
-
-        //if (isVoltageCalibrationEnabled()) {
-        //    u.mon_dac = util::remap(value, cal_conf.u.min.adc, cal_conf.u.min.val, cal_conf.u.max.adc, cal_conf.u.max.val);
-        //} else {
-        //    u.mon_dac = value;
-        //}
-
-        u.addMonDacValue(value);
+        u.addMonDacValue(data);
 
         if (isOutputEnabled() && isRemoteProgrammingEnabled()) {
             nextStartReg0 = AnalogDigitalConverter::ADC_REG0_READ_U_MON;
@@ -920,19 +1000,7 @@ void Channel::adcDataIsReady(int16_t data, bool startAgain) {
         debug::g_iMonDac[index - 1].set(data);
 #endif
 
-        float value = remapAdcDataToCurrent(data) - getDualRangeGndOffset();
-
-        //if (isCurrentCalibrationEnabled()) {
-        //    i.mon_dac = util::remap(value,
-        //        cal_conf.i[flags.currentCurrentRange].min.adc,
-        //        cal_conf.i[flags.currentCurrentRange].min.val,
-        //        cal_conf.i[flags.currentCurrentRange].max.adc,
-        //        cal_conf.i[flags.currentCurrentRange].max.val);
-        //} else {
-        //    i.mon_dac = value;
-        //}
-
-        i.addMonDacValue(value);
+        i.addMonDacValue(data);
 
         if (isOutputEnabled()) {
             nextStartReg0 = AnalogDigitalConverter::ADC_REG0_READ_U_MON;
@@ -1346,14 +1414,18 @@ bool Channel::isCalibrationEnabled() {
     return flags._calEnabled;
 }
 
-bool Channel::isVoltageCalibrationEnabled() {
+bool Channel::isVoltageCalibrationEnabled() const {
     return flags._calEnabled && cal_conf.flags.u_cal_params_exists;
 }
 
-bool Channel::isCurrentCalibrationEnabled() {
+bool Channel::isCurrentCalibrationEnabled() const {
+    return isCurrentCalibrationEnabled(flags.currentCurrentRange);
+}
+
+bool Channel::isCurrentCalibrationEnabled(uint8_t currentRange) const {
     return flags._calEnabled && (
-        flags.currentCurrentRange == CURRENT_RANGE_HIGH && cal_conf.flags.i_cal_params_exists_range_high ||
-        flags.currentCurrentRange == CURRENT_RANGE_LOW && cal_conf.flags.i_cal_params_exists_range_low
+        currentRange == CURRENT_RANGE_HIGH && cal_conf.flags.i_cal_params_exists_range_high ||
+        currentRange == CURRENT_RANGE_LOW && cal_conf.flags.i_cal_params_exists_range_low
     );
 }
 
@@ -1511,14 +1583,7 @@ bool Channel::isLowRippleAutoEnabled() {
     return flags.lrippleAutoEnabled;
 }
 
-void Channel::doSetVoltage(float value) {
-    u.set = value;
-    u.mon_dac = 0;
-
-    if (prot_conf.u_level < u.set) {
-        prot_conf.u_level = u.set;
-    }
-
+uint16_t Channel::getVoltageDacCode(float value) {
     if (U_MAX != U_MAX_CONF) {
         value = util::remap(value, 0, 0, U_MAX_CONF, U_MAX);
     }
@@ -1531,11 +1596,30 @@ void Channel::doSetVoltage(float value) {
     value += VOLTAGE_GND_OFFSET;
 #endif
 
-    dac.set_voltage(value);
+    return dac.getVoltageCode(value);
+}
+
+void Channel::doSetVoltage(float value) {
+    doSetVoltage(value, getVoltageDacCode(value));
+}
+
+void Channel::doSetVoltage(float value, uint16_t dacCode) {
+    u.set = value;
+    u.mon_dac_average.reset();
+
+    if (prot_conf.u_level < u.set) {
+        prot_conf.u_level = u.set;
+    }
+
+    dac.set_voltage(dacCode);
 }
 
 void Channel::setVoltage(float value) {
-    doSetVoltage(value);
+    setVoltage(value, getVoltageDacCode(value));
+}
+
+void Channel::setVoltage(float value, uint16_t dacCode) {
+    doSetVoltage(value, dacCode);
 
     uBeforeBalancing = NAN;
     restoreCurrentToValueBeforeBalancing();
@@ -1543,43 +1627,63 @@ void Channel::setVoltage(float value) {
     profile::save();
 }
 
-void Channel::doSetCurrent(float value) {
+uint8_t Channel::getCurrentRangeForValue(float value) {
     if (hasSupportForCurrentDualRange()) {
         if (dac.isTesting()) {
-            setCurrentRange(CURRENT_RANGE_HIGH);
+            return CURRENT_RANGE_HIGH;
         } else if (!calibration::isEnabled()) {
             if (flags.currentRangeSelectionMode == CURRENT_RANGE_SELECTION_USE_BOTH) {
-                setCurrentRange(util::greater(value, 0.5, getPrecision(VALUE_TYPE_FLOAT_AMPER)) ? CURRENT_RANGE_HIGH : CURRENT_RANGE_LOW);
+                return util::greater(value, 0.5, getPrecision(VALUE_TYPE_FLOAT_AMPER)) ? CURRENT_RANGE_HIGH : CURRENT_RANGE_LOW;
             } else if (flags.currentRangeSelectionMode == CURRENT_RANGE_SELECTION_ALWAYS_HIGH) {
-                setCurrentRange(CURRENT_RANGE_HIGH);
+                return CURRENT_RANGE_HIGH;
             } else {
-                setCurrentRange(CURRENT_RANGE_LOW);
+                return CURRENT_RANGE_LOW;
             }
         }
     }
 
-    i.set = value;
-    i.mon_dac = 0;
+    return flags.currentCurrentRange;
+}
 
+uint16_t Channel::getCurrentDacCode(float value, uint8_t currentRange) {
     if (I_MAX != I_MAX_CONF) {
         value = util::remap(value, 0, 0, I_MAX_CONF, I_MAX);
     }
 
-    if (isCurrentCalibrationEnabled()) {
+    if (isCurrentCalibrationEnabled(currentRange)) {
         value = util::remap(value,
-            cal_conf.i[flags.currentCurrentRange].min.val,
-            cal_conf.i[flags.currentCurrentRange].min.dac,
-            cal_conf.i[flags.currentCurrentRange].max.val,
-            cal_conf.i[flags.currentCurrentRange].max.dac);
+            cal_conf.i[currentRange].min.val,
+            cal_conf.i[currentRange].min.dac,
+            cal_conf.i[currentRange].max.val,
+            cal_conf.i[currentRange].max.dac);
     }
 
-    value += getDualRangeGndOffset();
+    value += getDualRangeGndOffset(currentRange);
+
+    return dac.getCurrentCode(value, currentRange);
+}
+
+void Channel::doSetCurrent(float value) {
+    uint8_t currentRange = getCurrentRangeForValue(value);
+    doSetCurrent(value, currentRange, getCurrentDacCode(value, currentRange));
+}
 
-    dac.set_current(value);
+void Channel::doSetCurrent(float value, uint8_t currentRange, uint16_t dacCode) {
+    setCurrentRange(currentRange);
+
+    i.set = value;
+    i.mon_dac_average.reset();
+
+    dac.set_current(dacCode);
 }
 
 void Channel::setCurrent(float value) {
-    doSetCurrent(value);
+    uint8_t currentRange = getCurrentRangeForValue(value);
+    setCurrent(value, currentRange, getCurrentDacCode(value, currentRange));
+}
+
+void Channel::setCurrent(float value, uint8_t currentRange, uint16_t dacCode) {
+    doSetCurrent(value, currentRange, dacCode);
 
     iBeforeBalancing = NAN;
     restoreVoltageToValueBeforeBalancing();
@@ -1645,7 +1749,9 @@ void Channel::setQuesBits(int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == psu::TEST_OK) {
-        reg_set_ques_isum_bit(&ethernet::g_scpiContext, this, bit_mask, on);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            reg_set_ques_isum_bit(&ethernet::g_scpiContext[i], this, bit_mask, on);
+        }
     }
 #endif
 }
@@ -1656,7 +1762,9 @@ void Channel::setOperBits(int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == psu::TEST_OK) {
-        reg_set_oper_isum_bit(&ethernet::g_scpiContext, this, bit_mask, on);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            reg_set_oper_isum_bit(&ethernet::g_scpiContext[i], this, bit_mask, on);
+        }
     }
 #endif
 }
@@ -1805,11 +1913,15 @@ void Channel::setTriggerOnListStop(TriggerOnListStop value) {
     flags.triggerOnListStop = value;
 }
 
-float Channel::getDualRangeGndOffset() {
+float Channel::getDualRangeGndOffset() const {
+    return getDualRangeGndOffset(flags.currentCurrentRange);
+}
+
+float Channel::getDualRangeGndOffset(uint8_t currentRange) const {
 #ifdef EEZ_PSU_SIMULATOR
     return 0;
 #else
-    return flags.currentCurrentRange == CURRENT_RANGE_LOW ? (CURRENT_GND_OFFSET / 10) : CURRENT_GND_OFFSET;
+    return currentRange == CURRENT_RANGE_LOW ? (CURRENT_GND_OFFSET / 10) : CURRENT_GND_OFFSET;
 #endif
 }
 
@@ -1843,8 +1955,12 @@ bool Channel::isCurrentLowRangeAllowed() {
     return hasSupportForCurrentDualRange() && flags.currentRangeSelectionMode != CURRENT_RANGE_SELECTION_ALWAYS_HIGH;
 }
 
-float Channel::getDualRangeMax() {
-    return flags.currentCurrentRange == CURRENT_RANGE_LOW ? (I_MAX / 10) : I_MAX;
+float Channel::getDualRangeMax() const {
+    return getDualRangeMax(flags.currentCurrentRange);
+}
+
+float Channel::getDualRangeMax(uint8_t currentRange) const {
+    return currentRange == CURRENT_RANGE_LOW ? (I_MAX / 10) : I_MAX;
 }
 
 //void Channel::calculateNegligibleAdcDiffForCurrent() {
@@ -1882,6 +1998,9 @@ void Channel::setCurrentRange(uint8_t currentCurrentRange) {
         if (currentCurrentRange != flags.currentCurrentRange) {
             flags.currentCurrentRange = currentCurrentRange;
             doSetCurrentRange();
+            // averages are kept as the raw ADC codes which depend on the current range
+            i.mon_average.reset();
+            i.mon_dac_average.reset();
             if (isOutputEnabled()) {
                 adc.start(AnalogDigitalConverter::ADC_REG0_READ_U_MON);
             }
@@ -77,6 +77,13 @@ enum CurrentRange {
     CURRENT_RANGE_LOW
 };
 
+enum AveragingType {
+    /// Average of the last N values.
+    AVERAGING_TYPE_MOVING,
+    /// Exponential (IIR) average, each new value has the weight of 1/N.
+    AVERAGING_TYPE_EXPONENTIAL
+};
+
 /// PSU channel.
 class Channel {
     friend class DigitalAnalogConverter;
@@ -197,6 +204,24 @@ public:
         unsigned currentCurrentRange: 1; // 0: 5A, 1:0.5A
     };
 
+    /// Average of the raw ADC codes. Calibration is applied only when
+    /// the average is read (see getUMon, getIMon, getUMonDac and getIMonDac).
+    struct AdcAverage {
+        int16_t arr[ADC_AVERAGING_COUNT_MAX];
+        /// Sum of the last count codes for the AVERAGING_TYPE_MOVING,
+        /// average in 1/256 of the code for the AVERAGING_TYPE_EXPONENTIAL.
+        int32_t total;
+        uint16_t index;
+        uint16_t count;
+        uint8_t type;
+        bool empty;
+
+        void setup(AveragingType type_, uint16_t count_);
+        void reset();
+        void add(int16_t adc_data);
+        float get() const;
+    };
+
     /// Voltage and current data set and measured during runtime.
     struct Value {
         float set;
@@ -205,16 +230,10 @@ public:
 
         bool mon_measured;
 
-        float mon;
         float mon_last;
-        int8_t mon_index;
-        float mon_arr[NUM_ADC_AVERAGING_VALUES];
-        float mon_total;
+        AdcAverage mon_average;
 
-        float mon_dac;
-        int8_t mon_dac_index;
-        float mon_dac_arr[NUM_ADC_AVERAGING_VALUES];
-        float mon_dac_total;
+        AdcAverage mon_dac_average;
 
         float step;
         float limit;
@@ -225,8 +244,8 @@ public:
 
         void init(float set_, float step_, float limit_);
         void resetMonValues();
-        void addMonDacValue(float value);
-        void addMonValue(float value);
+        void addMonDacValue(int16_t adc_data);
+        void addMonValue(int16_t adc_data, float value);
     };
 
     /// Runtime protection binary flags (alarmed, tripped)
@@ -484,9 +503,21 @@ public:
 
     /// Set channel voltage level.
     void setVoltage(float voltage);
+    /// Set channel voltage level, DAC code is precomputed by getVoltageDacCode.
+    void setVoltage(float voltage, uint16_t dacCode);
 
     /// Set channel current level
     void setCurrent(float current);
+    /// Set channel current level, current range and DAC code are precomputed
+    /// by getCurrentRangeForValue and getCurrentDacCode.
+    void setCurrent(float current, uint8_t currentRange, uint16_t dacCode);
+
+    /// DAC code for the voltage level.
+    uint16_t getVoltageDacCode(float voltage);
+    /// Current range selected for the current level.
+    uint8_t getCurrentRangeForValue(float current);
+    /// DAC code for the current level in the given current range.
+    uint16_t getCurrentDacCode(float current, uint8_t currentRange);
 
     /// Is channel calibrated, both voltage and current?
     bool isCalibrationExists();
@@ -516,10 +547,17 @@ public:
     char *getCvModeStr();
 
     /// Remap ADC data value to actual voltage value
-    float remapAdcDataToVoltage(int16_t adc_data);
+    float remapAdcDataToVoltage(float adc_data) const;
 
     /// Remap ADC data value to actual current value (use calibration if configured).
-    float remapAdcDataToCurrent(int16_t adc_data);
+    float remapAdcDataToCurrent(float adc_data) const;
+
+    /// Converts U_MON ADC data value to the measured voltage (use calibration if configured).
+    float getVoltageFromAdcData(float adc_data) const;
+
+    /// Converts I_MON ADC data value, taken in the given current range,
+    /// to the measured current (use calibration if configured).
+    float getCurrentFromAdcData(float adc_data, uint8_t currentRange) const;
 
     /// Remap voltage value to ADC data value (use calibration if configured).
     int16_t remapVoltageToAdcData(float value);
@@ -581,6 +619,20 @@ public:
     float getUMonHistory(int position) const { return uHistory[position]; }
     float getIMonHistory(int position) const { return iHistory[position]; }
 
+    /// Averaged measured voltage and current.
+    float getUMon() const;
+    float getIMon() const;
+
+    /// Averaged voltage and current set values measured by the ADC.
+    float getUMonDac() const;
+    float getIMonDac() const;
+
+    /// Set the type and the number of values used for averaging of all
+    /// the measured values, restarts the averaging.
+    void setAveraging(AveragingType type, uint16_t count);
+    AveragingType getAveragingType() const { return (AveragingType)u.mon_average.type; }
+    uint16_t getAveragingCount() const { return u.mon_average.count; }
+
     void resetHistory();
 
     TriggerMode getVoltageTriggerMode();
@@ -601,7 +653,8 @@ public:
     void enableAutoSelectCurrentRange(bool enable);
     bool isAutoSelectCurrentRangeEnabled() { return flags.autoSelectCurrentRange ? true : false; }
     bool isCurrentLowRangeAllowed();
-    float getDualRangeMax();
+    float getDualRangeMax() const;
+    float getDualRangeMax(uint8_t currentRange) const;
     void setCurrentRange(uint8_t currentRange);
 
 private:
@@ -646,8 +699,9 @@ private:
     void doCalibrationEnable(bool enable);
     void calibrationFindVoltageRange(float minDac, float minVal, float minAdc, float maxDac, float maxVal, float maxAdc, float *min, float *max);
     void calibrationFindCurrentRange(float minDac, float minVal, float minAdc, float maxDac, float maxVal, float maxAdc, float *min, float *max);
-    bool isVoltageCalibrationEnabled();
-    bool isCurrentCalibrationEnabled();
+    bool isVoltageCalibrationEnabled() const;
+    bool isCurrentCalibrationEnabled() const;
+    bool isCurrentCalibrationEnabled(uint8_t currentRange) const;
 
     void adcDataIsReady(int16_t data, bool startAgain);
     
@@ -658,7 +712,9 @@ private:
     void restoreCurrentToValueBeforeBalancing();
 
     void doSetVoltage(float value);
+    void doSetVoltage(float value, uint16_t dacCode);
     void doSetCurrent(float value);
+    void doSetCurrent(float value, uint8_t currentRange, uint16_t dacCode);
 
     void setCcMode(bool cc_mode);
     void setCvMode(bool cv_mode);
@@ -680,7 +736,8 @@ private:
     void testPwrgood(uint8_t gpio);
 #endif
 
-    float getDualRangeGndOffset();
+    float getDualRangeGndOffset() const;
+    float getDualRangeGndOffset(uint8_t currentRange) const;
     //void calculateNegligibleAdcDiffForCurrent();
 
     uint32_t autoRangeCheckLastTickCount;
@@ -190,9 +190,9 @@ float getUSetUnbalanced(const Channel &channel) {
 
 float getUMon(const Channel &channel) { 
     if (isSeries()) {
-        return Channel::get(0).u.mon + Channel::get(1).u.mon;
+        return Channel::get(0).getUMon() + Channel::get(1).getUMon();
     }
-    return channel.u.mon; 
+    return channel.getUMon();
 }
 
 float getUMonLast(const Channel &channel) {
@@ -211,9 +211,9 @@ float getUMonHistory(const Channel &channel, int position) {
 
 float getUMonDac(const Channel &channel) { 
     if (isSeries()) {
-        return Channel::get(0).u.mon_dac + Channel::get(1).u.mon_dac;
+        return Channel::get(0).getUMonDac() + Channel::get(1).getUMonDac();
     }
-    return channel.u.mon_dac; 
+    return channel.getUMonDac();
 }
 
 float getULimit(const Channel &channel) {
@@ -350,9 +350,9 @@ float getISetUnbalanced(const Channel &channel) {
 
 float getIMon(const Channel &channel) { 
     if (isParallel()) {
-        return Channel::get(0).i.mon + Channel::get(1).i.mon;
+        return Channel::get(0).getIMon() + Channel::get(1).getIMon();
     }
-    return channel.i.mon; 
+    return channel.getIMon();
 }
 
 float getIMonLast(const Channel &channel) {
@@ -371,9 +371,9 @@ float getIMonHistory(const Channel &channel, int position) {
 
 float getIMonDac(const Channel &channel) { 
     if (isParallel()) {
-        return Channel::get(0).i.mon_dac + Channel::get(1).i.mon_dac;
+        return Channel::get(0).getIMonDac() + Channel::get(1).getIMonDac();
     }
-    return channel.i.mon_dac; 
+    return channel.getIMonDac();
 }
 
 float getILimit(const Channel &channel) {
@@ -820,6 +820,15 @@ void setTriggerOnListStop(Channel& channel, TriggerOnListStop value) {
     }
 }
 
+void setAveraging(Channel& channel, AveragingType type, uint16_t count) {
+    if (isCoupled() || isTracked()) {
+        Channel::get(0).setAveraging(type, count);
+        Channel::get(1).setAveraging(type, count);
+    } else {
+        channel.setAveraging(type, count);
+    }
+}
+
 float getTriggerVoltage(Channel& channel) {
     if (isCoupled() || isTracked()) {
         return trigger::getVoltage(Channel::get(0));
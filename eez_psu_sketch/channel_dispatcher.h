@@ -131,6 +131,8 @@ void setTriggerOutputState(Channel& channel, bool enable);
 TriggerOnListStop getTriggerOnListStop(Channel& channel);
 void setTriggerOnListStop(Channel& channel, TriggerOnListStop value);
 
+void setAveraging(Channel& channel, AveragingType type, uint16_t count);
+
 float getTriggerVoltage(Channel& channel);
 void setTriggerVoltage(Channel& channel, float value);
 
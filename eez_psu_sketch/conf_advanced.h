@@ -142,6 +142,14 @@
 #define SCPI_PARSER_INPUT_BUFFER_LENGTH 2048
 #endif
 
+/// Size in number characters of SCPI output buffer. Response is accumulated
+/// in the buffer and written at once at the end of the program message.
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R1B9
+#define SCPI_PARSER_OUTPUT_BUFFER_LENGTH 64
+#elif EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+#define SCPI_PARSER_OUTPUT_BUFFER_LENGTH 1024
+#endif
+
 /// Size of SCPI parser error queue.
 #define SCPI_PARSER_ERROR_QUEUE_SIZE 20
 
@@ -243,6 +251,22 @@
 /// until we declare ethernet initialization failure.
 #define ETHERNET_DHCP_TIMEOUT 15
 
+/// Max. number of concurrent SCPI over TCP connections. Each connection
+/// has its own SCPI parser context with input and output buffers.
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R1B9
+#define ETHERNET_MAX_CLIENTS 1
+#elif EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+#define ETHERNET_MAX_CLIENTS 2
+#endif
+
+/// Number of the measurement stream frames captured at the ADC rate
+/// and waiting to be sent (see stream.h). Must be less than 256.
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R1B9
+#define STREAM_FRAME_BUFFER_SIZE 4
+#elif EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+#define STREAM_FRAME_BUFFER_SIZE 32
+#endif
+
 /// Output power is monitored and if its go below DP_NEG_LEV
 /// that is negative value in Watts (default -1 W),
 /// and that condition lasts more then DP_NEG_DELAY seconds (default 5 s),
@@ -269,12 +293,38 @@
 
 #define MAX_LIST_LENGTH 256
 
+/// Number of steps in each of the two windows through which the list
+/// longer than MAX_LIST_LENGTH is executed from the file.
+#define CONF_LIST_STREAM_WINDOW_SIZE 32
+
+/// Is list timer mode, i.e. list steps are set from the hardware timer
+/// interrupt instead of from the main loop, supported (see LIST:TIMer)?
+#if defined(EEZ_PSU_ARDUINO_DUE)
+#define CONF_LIST_TIMER 1
+#else
+#define CONF_LIST_TIMER 0
+#endif
+
 #define LIST_DWELL_MIN 0.0001f 
 #define LIST_DWELL_MAX 65535.0f
 #define LIST_DWELL_DEF 0.01f
 
 #define MAX_LIST_COUNT 65535
 
+#define LIST_FUNCTION_POINTS_MIN 2
+#define LIST_FUNCTION_POINTS_MAX 1000000
+#define LIST_FUNCTION_POINTS_DEF 100
+
+#define LIST_FUNCTION_PERIOD_MIN (2 * LIST_DWELL_MIN)
+#define LIST_FUNCTION_PERIOD_MAX LIST_DWELL_MAX
+#define LIST_FUNCTION_PERIOD_DEF 1.0f
+
+/// Number of levels of the staircase function, from the low to the high level.
+#define LIST_FUNCTION_STAIR_STEPS 5
+
+/// Number of steps in the trigger sequencer table.
+#define MAX_SEQUENCER_STEPS 16
+
 #define PATH_SEPARATOR "/"
 #define LISTS_DIR PATH_SEPARATOR "LISTS"
 #define PROFILES_DIR PATH_SEPARATOR "PROFILES"
@@ -308,8 +358,12 @@
 #define DISPLAY_BACKGROUND_COLOR_G 128
 #define DISPLAY_BACKGROUND_COLOR_B 255
 
-/// Number of values used for ADC averaging
-#define NUM_ADC_AVERAGING_VALUES 30
+/// Number of values used for ADC averaging (see SENSe:AVERage:COUNt),
+/// moving average keeps the ADC_AVERAGING_COUNT_MAX raw codes for each
+/// of the U_MON, I_MON, U_SET and I_SET of the channel.
+#define ADC_AVERAGING_COUNT_MIN 1
+#define ADC_AVERAGING_COUNT_MAX 256
+#define ADC_AVERAGING_COUNT_DEF 30
 
 /// Width of the trigger output pulse, in milliseconds.
 #define CONF_TOUTPUT_PULSE_WIDTH_MS 100
@@ -337,5 +391,28 @@
 /// During data logging call file.sync every N seconds
 #define CONF_DLOG_SYNC_FILE_TIME 10 // 10 seconds
 
+/// Size of each of the two data logging RAM buffers, must be multiple of
+/// the SD card sector size (512 bytes). While samples are added to one
+/// buffer, the other is written to the file.
+#define CONF_DLOG_BUFFER_SIZE 1024
+
+/// Max. number of bytes written to the data logging file in one dlog::tick
+#define CONF_DLOG_WRITE_SLICE_SIZE 512
+
+/// Number of ADC readings, captured in the ADC data logging mode,
+/// waiting to be written to the data logging buffer.
+#define CONF_DLOG_ADC_BUFFER_SIZE 256
+
+/// Size in bytes of the RAM buffer for the data log index overview, from
+/// which the coarser index tiers are built (see dlog_index.h). Each entry
+/// takes 8 bytes plus 16 bytes per logged column, buffer must hold at least
+/// two entries with all the columns (see dlog::MAX_COLUMNS).
+#define CONF_DLOG_INDEX_OVERVIEW_BUFFER_SIZE 1024
+
+/// Number of values (4 bytes each) in the RAM buffer for the samples logged
+/// before the trigger. Max. number of pre-trigger samples is this divided
+/// by the number of logged columns.
+#define CONF_DLOG_PRE_TRIGGER_BUFFER_SIZE 1024
+
 /// Size of serial port output buffer
 #define CONF_SERIAL_BUFFER_SIZE 64
@@ -57,10 +57,6 @@ void DigitalAnalogConverter::set_value(uint8_t buffer, uint16_t value) {
     SPI_endTransaction();
 }
 
-void DigitalAnalogConverter::set_value(uint8_t buffer, float value) {
-    set_value(buffer, (uint16_t)util::clamp(round(value), DAC_MIN, DAC_MAX));
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 
 void DigitalAnalogConverter::init() {
@@ -107,7 +103,7 @@ bool DigitalAnalogConverter::test() {
 
     channel.adcReadMonDac();
 
-    float u_mon = channel.u.mon_dac;
+    float u_mon = channel.getUMonDac();
     float u_diff = u_mon - u_set;
     if (fabsf(u_diff) > u_set * DAC_TEST_TOLERANCE / 100) {
         g_testResult = psu::TEST_FAILED;
@@ -119,7 +115,7 @@ bool DigitalAnalogConverter::test() {
             (int)(u_diff * 100));
     }
 
-    float i_mon = channel.i.mon_dac;
+    float i_mon = channel.getIMonDac();
     float i_diff = i_mon - i_set;
     if (fabsf(i_diff) > i_set * DAC_TEST_TOLERANCE / 100) {
         g_testResult = psu::TEST_FAILED;
@@ -162,11 +158,11 @@ bool DigitalAnalogConverter::test() {
 ////////////////////////////////////////////////////////////////////////////////
 
 void DigitalAnalogConverter::set_voltage(float value) {
-    set_value(DATA_BUFFER_A, util::remap(value, channel.U_MIN, (float)DAC_MIN, channel.U_MAX, (float)DAC_MAX));
+    set_value(DATA_BUFFER_A, getVoltageCode(value));
 }
 
 void DigitalAnalogConverter::set_current(float value) {
-    set_value(DATA_BUFFER_B, util::remap(value, channel.I_MIN, (float)DAC_MIN, channel.getDualRangeMax(), (float)DAC_MAX));
+    set_value(DATA_BUFFER_B, getCurrentCode(value, channel.flags.currentCurrentRange));
 }
 
 void DigitalAnalogConverter::set_voltage(uint16_t voltage) {
@@ -177,5 +173,15 @@ void DigitalAnalogConverter::set_current(uint16_t current) {
     set_value(DATA_BUFFER_B, current);
 }
 
+uint16_t DigitalAnalogConverter::getVoltageCode(float value) {
+    value = util::remap(value, channel.U_MIN, (float)DAC_MIN, channel.U_MAX, (float)DAC_MAX);
+    return (uint16_t)util::clamp(round(value), DAC_MIN, DAC_MAX);
+}
+
+uint16_t DigitalAnalogConverter::getCurrentCode(float value, uint8_t currentRange) {
+    value = util::remap(value, channel.I_MIN, (float)DAC_MIN, channel.getDualRangeMax(currentRange), (float)DAC_MAX);
+    return (uint16_t)util::clamp(round(value), DAC_MIN, DAC_MAX);
+}
+
 }
 } // namespace eez::psu
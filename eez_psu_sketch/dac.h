@@ -43,6 +43,11 @@ public:
     void set_voltage(uint16_t voltage);
     void set_current(uint16_t current);
 
+    /// DAC code for the voltage value (already remapped by the calibration).
+    uint16_t getVoltageCode(float voltage);
+    /// DAC code for the current value (already remapped by the calibration) in the given current range.
+    uint16_t getCurrentCode(float current, uint8_t currentRange);
+
     bool isTesting() { return m_testing; }
 
 private:
@@ -50,7 +55,6 @@ private:
     bool m_testing;
 
     void set_value(uint8_t buffer, uint16_t value);
-    void set_value(uint8_t buffer, float value);
 };
 
 }
@@ -28,6 +28,7 @@
 #include "watchdog.h"
 #endif
 #include "dlog.h"
+#include "dlog_index.h"
 
 namespace eez {
 namespace psu {
@@ -39,6 +40,9 @@ bool g_logPower[CH_NUM];
 float g_period = PERIOD_DEFAULT;
 float g_time = TIME_DEFAULT;
 trigger::Source g_triggerSource = trigger::SOURCE_IMMEDIATE;
+Mode g_mode = MODE_PERIODIC;
+bool g_compression;
+uint32_t g_preTriggerSamples;
 char g_filePath[MAX_PATH_LENGTH + 1];
 
 enum State {
@@ -90,6 +94,8 @@ int checkDlogParameters() {
 	return 0;
 }
 
+static int startPreTrigger();
+
 bool isIdle() {
 	return g_state == STATE_IDLE;
 }
@@ -107,6 +113,9 @@ int initiate(const char *filePath) {
 		error = startImmediately();
 	} else {
 		error = checkDlogParameters();
+		if (!error) {
+			error = startPreTrigger();
+		}
 		if (!error) {
 			setState(STATE_INITIATED);
 		}
@@ -133,9 +142,107 @@ void triggerGenerated(bool startImmediatelly) {
 #define MAGIC1  0x2D5A4545L
 #define MAGIC2  0x474F4C44L
 #define VERSION 0x00000001L
+#define VERSION_COMPRESSED 0x00000002L
+
+// header flags
+#define FLAG_JITTER   0x0001
+#define FLAG_ADC_DATA 0x0002
+#define FLAG_PRE_TRIGGER 0x0004
+
+// In MODE_ADC, header is followed by:
+// - for each channel with any column in the header columns, scale and offset (as floats) which convert ADC data
+//   to the value (value = scale * data + offset), first for U_MON,
+//   then for I_MON in high and low current range,
+// - uint32 micros() at the start of logging
+// and then by 8 bytes records for each U_MON and I_MON ADC reading:
+// uint32 micros(), int16 ADC data, uint8 channel index, uint8 AdcDataType.
+
+// With FLAG_PRE_TRIGGER, header is followed by uint32 number of pre-trigger
+// samples and float time (in seconds, negative) of the first pre-trigger
+// sample, relative to the trigger. Pre-trigger samples are g_period apart
+// and are followed by the samples logged after the trigger from time 0.
+
+// Samples are appended to one of the two buffers while the other one, when
+// full, is written to the file in CONF_DLOG_WRITE_SLICE_SIZE slices from tick.
+// File header is also written through the buffer, so all the writes to the
+// file, except the last one, are sector aligned.
+static uint8_t g_buffers[2][CONF_DLOG_BUFFER_SIZE];
+static uint8_t g_fillBuffer;
+static uint16_t g_fillPosition;
+static bool g_drainPending;
+static uint16_t g_drainPosition;
+static bool g_writeError;
+// number of bytes written to the file, including the buffered ones
+static uint32_t g_fileSize;
+
+static void writeToFile(const uint8_t *data, size_t size) {
+	if (g_writeError) {
+		return;
+	}
+
+#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
+	watchdog::disable();
+#endif
+
+	if (g_file.write(data, size) != size) {
+		g_writeError = true;
+	}
+
+#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
+	watchdog::enable();
+#endif
+}
+
+/// Writes at most maxSize bytes of the full buffer to the file.
+static void drain(uint16_t maxSize) {
+	uint16_t size = CONF_DLOG_BUFFER_SIZE - g_drainPosition;
+	if (size > maxSize) {
+		size = maxSize;
+	}
+
+	writeToFile(g_buffers[g_fillBuffer ^ 1] + g_drainPosition, size);
+
+	g_drainPosition += size;
+	if (g_drainPosition == CONF_DLOG_BUFFER_SIZE) {
+		g_drainPending = false;
+	}
+}
+
+static void resetBuffers() {
+	g_fillBuffer = 0;
+	g_fillPosition = 0;
+	g_drainPending = false;
+	g_drainPosition = 0;
+	g_writeError = false;
+	g_fileSize = 0;
+}
+
+static void flushBuffers() {
+	if (g_drainPending) {
+		drain(CONF_DLOG_BUFFER_SIZE);
+	}
+
+	if (g_fillPosition > 0) {
+		writeToFile(g_buffers[g_fillBuffer], g_fillPosition);
+		g_fillPosition = 0;
+	}
+}
 
 void writeUint8(uint8_t value) {
-	g_file.write((const uint8_t *)&value, 1);
+	if (g_fillPosition == CONF_DLOG_BUFFER_SIZE) {
+		if (g_drainPending) {
+			// SD card can't keep up, the previous buffer must be written now
+			drain(CONF_DLOG_BUFFER_SIZE);
+		}
+
+		g_fillBuffer ^= 1;
+		g_fillPosition = 0;
+		g_drainPending = true;
+		g_drainPosition = 0;
+	}
+
+	g_buffers[g_fillBuffer][g_fillPosition++] = value;
+	++g_fileSize;
 }
 
 void writeUint16(uint16_t value) {
@@ -154,6 +261,347 @@ void writeFloat(float value) {
 	writeUint32(*((uint32_t *)&value));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Version 2 (compressed) file has the same header as version 1. Samples are
+// grouped in blocks of COMPRESSED_BLOCK_SIZE samples. Each sample starts with
+// the bit mask (one byte per 8 columns, bit 0 is the first column) of the
+// columns which changed from the previous sample, followed, for each changed
+// column, by the difference between the bit patterns (as int32) of this and
+// previous float value, in zigzag varint encoding (7 bits per byte, LSB
+// first). Previous values are reset to 0 at the start of each block, so each
+// block can be decoded independently from the rest of the file.
+
+#define COMPRESSED_BLOCK_SIZE 256
+
+static bool g_compressed;
+static uint32_t g_previousValues[MAX_COLUMNS];
+static uint16_t g_blockSampleIndex;
+
+static void writeVarUint32(uint32_t value) {
+	while (value >= 0x80) {
+		writeUint8((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	writeUint8((uint8_t)value);
+}
+
+static void writeSample(const float *values, int numValues) {
+	index::addSample(g_fileSize, values);
+
+	if (!g_compressed) {
+		for (int i = 0; i < numValues; ++i) {
+			writeFloat(values[i]);
+		}
+		return;
+	}
+
+	if (g_blockSampleIndex == 0) {
+		for (int i = 0; i < MAX_COLUMNS; ++i) {
+			g_previousValues[i] = 0;
+		}
+	}
+
+	uint32_t bits[MAX_COLUMNS];
+	uint8_t changed[(MAX_COLUMNS + 7) / 8] = { 0 };
+	for (int i = 0; i < numValues; ++i) {
+		memcpy(&bits[i], &values[i], sizeof(uint32_t));
+		if (bits[i] != g_previousValues[i]) {
+			changed[i / 8] |= 1 << (i % 8);
+		}
+	}
+
+	for (int i = 0; i < (numValues + 7) / 8; ++i) {
+		writeUint8(changed[i]);
+	}
+
+	for (int i = 0; i < numValues; ++i) {
+		if (changed[i / 8] & (1 << (i % 8))) {
+			int32_t delta = (int32_t)(bits[i] - g_previousValues[i]);
+			writeVarUint32(((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+			g_previousValues[i] = bits[i];
+		}
+	}
+
+	g_blockSampleIndex = (g_blockSampleIndex + 1) % COMPRESSED_BLOCK_SIZE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct AdcRecord {
+	uint32_t time;
+	int16_t data;
+	uint8_t channelIndex;
+	uint8_t type;
+};
+
+// single producer (ADC) single consumer (tick) ring buffer,
+// head is changed only by the producer and tail only by the consumer
+static AdcRecord g_adcRecords[CONF_DLOG_ADC_BUFFER_SIZE];
+static volatile uint16_t g_adcHead;
+static volatile uint16_t g_adcTail;
+static volatile bool g_adcCaptureEnabled;
+static uint8_t g_adcVoltageChannels;
+static uint8_t g_adcCurrentChannels;
+// changed only by the producer
+static volatile uint32_t g_adcNumLost;
+// changed only by the consumer
+static uint32_t g_adcNumLostLogged;
+
+void onAdcData(int channelIndex, AdcDataType type, int16_t data) {
+	if (!g_adcCaptureEnabled) {
+		return;
+	}
+
+	uint8_t channels = type == ADC_DATA_U_MON ? g_adcVoltageChannels : g_adcCurrentChannels;
+	if (!(channels & (1 << channelIndex))) {
+		return;
+	}
+
+	uint16_t head = g_adcHead;
+	uint16_t next = (head + 1) % CONF_DLOG_ADC_BUFFER_SIZE;
+	if (next == g_adcTail) {
+		++g_adcNumLost;
+		return;
+	}
+
+	AdcRecord &record = g_adcRecords[head];
+	record.time = micros();
+	record.data = data;
+	record.channelIndex = (uint8_t)channelIndex;
+	record.type = (uint8_t)type;
+
+	g_adcHead = next;
+}
+
+static void writeAdcRecord(uint32_t time, int16_t data, uint8_t channelIndex, uint8_t type) {
+	writeUint32(time);
+	writeUint16((uint16_t)data);
+	writeUint8(channelIndex);
+	writeUint8(type);
+}
+
+/// Moves all the captured ADC records to the file buffer.
+static void writeAdcRecords(uint32_t tickCount) {
+	uint32_t numLost = g_adcNumLost - g_adcNumLostLogged;
+	if (numLost > 0) {
+		if (numLost > 0x7FFF) {
+			numLost = 0x7FFF;
+		}
+		writeAdcRecord(tickCount, (int16_t)numLost, 0, ADC_DATA_GAP);
+		g_adcNumLostLogged += numLost;
+	}
+
+	while (g_adcTail != g_adcHead) {
+		AdcRecord &record = g_adcRecords[g_adcTail];
+		writeAdcRecord(record.time, record.data, record.channelIndex, record.type);
+		g_adcTail = (g_adcTail + 1) % CONF_DLOG_ADC_BUFFER_SIZE;
+	}
+}
+
+static void writeAdcDataConversion(float min, float max) {
+	float scale = (max - min) / (AnalogDigitalConverter::ADC_MAX - AnalogDigitalConverter::ADC_MIN);
+	writeFloat(scale);
+	writeFloat(min - scale * AnalogDigitalConverter::ADC_MIN);
+}
+
+static void startAdcCapture(uint32_t tickCount) {
+	g_adcVoltageChannels = 0;
+	g_adcCurrentChannels = 0;
+
+	for (int i = 0; i < CH_NUM; ++i) {
+		if (!g_logVoltage[i] && !g_logCurrent[i] && !g_logPower[i]) {
+			continue;
+		}
+
+		Channel &channel = Channel::get(i);
+
+		writeAdcDataConversion(
+			channel.getVoltageFromAdcData(AnalogDigitalConverter::ADC_MIN),
+			channel.getVoltageFromAdcData(AnalogDigitalConverter::ADC_MAX));
+
+		for (uint8_t currentRange = CURRENT_RANGE_HIGH; currentRange <= CURRENT_RANGE_LOW; ++currentRange) {
+			writeAdcDataConversion(
+				channel.getCurrentFromAdcData(AnalogDigitalConverter::ADC_MIN, currentRange),
+				channel.getCurrentFromAdcData(AnalogDigitalConverter::ADC_MAX, currentRange));
+		}
+
+		if (g_logVoltage[i] || g_logPower[i]) {
+			g_adcVoltageChannels |= 1 << i;
+		}
+		if (g_logCurrent[i] || g_logPower[i]) {
+			g_adcCurrentChannels |= 1 << i;
+		}
+	}
+
+	writeUint32(tickCount);
+
+	g_adcTail = g_adcHead;
+	g_adcNumLostLogged = g_adcNumLost;
+	g_adcCaptureEnabled = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int getMissedSampleValues(float *values) {
+	int numValues = 0;
+#ifdef DLOG_JITTER
+	values[numValues++] = NAN;
+#endif
+	for (int i = 0; i < CH_NUM; ++i) {
+		if (g_logVoltage[i]) {
+			values[numValues++] = NAN;
+		}
+		if (g_logCurrent[i]) {
+			values[numValues++] = NAN;
+		}
+		if (g_logPower[i]) {
+			values[numValues++] = NAN;
+		}
+	}
+	return numValues;
+}
+
+static int getSampleValues(float *values, float dt) {
+	int numValues = 0;
+#ifdef DLOG_JITTER
+	values[numValues++] = dt;
+#endif
+	for (int i = 0; i < CH_NUM; ++i) {
+		Channel &channel = Channel::get(i);
+
+		float uMon;
+		float iMon;
+
+		if (g_logVoltage[i]) {
+			uMon = channel_dispatcher::getUMonLast(channel);
+			values[numValues++] = uMon;
+		}
+
+		if (g_logCurrent[i]) {
+			iMon = channel_dispatcher::getIMonLast(channel);
+			values[numValues++] = iMon;
+		}
+
+		if (g_logPower[i]) {
+			if (!g_logVoltage[i]) {
+				uMon = channel_dispatcher::getUMonLast(channel);
+			}
+			if (!g_logCurrent[i]) {
+				iMon = channel_dispatcher::getIMonLast(channel);
+			}
+			values[numValues++] = uMon * iMon;
+		}
+	}
+	return numValues;
+}
+
+static int getNumColumns() {
+	int numColumns = 0;
+#ifdef DLOG_JITTER
+	++numColumns;
+#endif
+	for (int i = 0; i < CH_NUM; ++i) {
+		if (g_logVoltage[i]) {
+			++numColumns;
+		}
+		if (g_logCurrent[i]) {
+			++numColumns;
+		}
+		if (g_logPower[i]) {
+			++numColumns;
+		}
+	}
+	return numColumns;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Ring buffer of the last g_preTriggerMaxSamples samples, logged from tick
+// while initiated, with g_preTriggerNumColumns values in each sample.
+static float g_preTriggerBuffer[CONF_DLOG_PRE_TRIGGER_BUFFER_SIZE];
+static uint32_t g_preTriggerMaxSamples;
+static int g_preTriggerNumColumns;
+static uint32_t g_preTriggerFirst;
+static uint32_t g_preTriggerCount;
+static uint32_t g_preTriggerPeriodUs;
+static uint32_t g_preTriggerNextTickCount;
+
+static int startPreTrigger() {
+	g_preTriggerMaxSamples = 0;
+	g_preTriggerFirst = 0;
+	g_preTriggerCount = 0;
+
+	if (g_mode != MODE_PERIODIC || g_preTriggerSamples == 0) {
+		return 0;
+	}
+
+	g_preTriggerNumColumns = getNumColumns();
+	if (g_preTriggerSamples * g_preTriggerNumColumns > CONF_DLOG_PRE_TRIGGER_BUFFER_SIZE) {
+		return SCPI_ERROR_DATA_OUT_OF_RANGE;
+	}
+
+	g_preTriggerMaxSamples = g_preTriggerSamples;
+	g_preTriggerPeriodUs = (uint32_t)(g_period * 1000000L);
+	g_preTriggerNextTickCount = micros();
+
+	return 0;
+}
+
+static void addPreTriggerSample(const float *values) {
+	uint32_t i;
+	if (g_preTriggerCount < g_preTriggerMaxSamples) {
+		i = (g_preTriggerFirst + g_preTriggerCount++) % g_preTriggerMaxSamples;
+	} else {
+		// buffer is full, the oldest sample is overwritten
+		i = g_preTriggerFirst;
+		g_preTriggerFirst = (g_preTriggerFirst + 1) % g_preTriggerMaxSamples;
+	}
+
+	memcpy(g_preTriggerBuffer + i * g_preTriggerNumColumns, values, g_preTriggerNumColumns * sizeof(float));
+}
+
+static void logPreTrigger(uint32_t tickCount) {
+	if (g_preTriggerMaxSamples == 0 || (int32_t)(tickCount - g_preTriggerNextTickCount) < 0) {
+		return;
+	}
+
+	float values[MAX_COLUMNS];
+
+	while (1) {
+		float dt = (tickCount - g_preTriggerNextTickCount) * 1E-6f;
+		g_preTriggerNextTickCount += g_preTriggerPeriodUs;
+		if ((int32_t)(tickCount - g_preTriggerNextTickCount) < 0) {
+			getSampleValues(values, dt);
+			addPreTriggerSample(values);
+			break;
+		}
+
+		// we missed a sample, write NAN
+		getMissedSampleValues(values);
+		addPreTriggerSample(values);
+	}
+}
+
+/// Writes pre-trigger samples, tickCount is the trigger time.
+static void writePreTriggerSamples(uint32_t tickCount) {
+	// time from the last pre-trigger sample to the trigger
+	uint32_t lastSampleTickCount = g_preTriggerNextTickCount - g_preTriggerPeriodUs;
+	float firstSampleTime = -((tickCount - lastSampleTickCount) * 1E-6f + (g_preTriggerCount - 1) * g_period);
+
+	writeUint32(g_preTriggerCount);
+	writeFloat(firstSampleTime);
+
+	for (uint32_t i = 0; i < g_preTriggerCount; ++i) {
+		uint32_t j = (g_preTriggerFirst + i) % g_preTriggerMaxSamples;
+		writeSample(g_preTriggerBuffer + j * g_preTriggerNumColumns, g_preTriggerNumColumns);
+	}
+
+	g_preTriggerCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 int startImmediately() {
 	int err = checkDlogParameters();
 	if (err) {
@@ -169,18 +617,35 @@ int startImmediately() {
 		return SCPI_ERROR_MASS_STORAGE_ERROR;
 	}
 
+	uint32_t tickCount = micros();
+
+	// samples logged while initiated, if trigger came before any sample is logged there is nothing to write
+	bool preTrigger = (g_state == STATE_INITIATED || g_state == STATE_TRIGGERED) && g_preTriggerCount > 0;
+
 	setState(STATE_EXECUTING);
 
+	resetBuffers();
+
 	writeUint32(MAGIC1);
 	writeUint32(MAGIC2);
 	
-	writeUint16(VERSION);
+	// ADC data records are not compressed
+	g_compressed = g_compression && g_mode == MODE_PERIODIC;
+	g_blockSampleIndex = 0;
+
+	writeUint16(g_compressed ? VERSION_COMPRESSED : VERSION);
 	
+	uint16_t flags = 0;
 	if (CONF_DLOG_JITTER) {
-		writeUint16(1);
-	} else {
-		writeUint16(0);
+		flags |= FLAG_JITTER;
+	}
+	if (g_mode == MODE_ADC) {
+		flags |= FLAG_ADC_DATA;
 	}
+	if (preTrigger) {
+		flags |= FLAG_PRE_TRIGGER;
+	}
+	writeUint16(flags);
 	
 	uint32_t columns = 0;
 	for (int iChannel = 0; iChannel < CH_NUM; ++iChannel) {
@@ -196,11 +661,12 @@ int startImmediately() {
 	}
 	writeUint32(columns);
 
-	writeFloat(g_period);
+	// there is no fixed period in MODE_ADC
+	writeFloat(g_mode == MODE_ADC ? 0 : g_period);
 	writeFloat(g_time);
 	writeUint32(datetime::nowUtc());
 
-	g_lastTickCount = micros();
+	g_lastTickCount = tickCount;
 	g_seconds = 0;
 	g_micros = 0;
 	g_iSample = 0;
@@ -208,14 +674,32 @@ int startImmediately() {
 	g_nextTime = 0;
 	g_lastSyncTickCount = g_lastTickCount;
 
-	log(g_lastTickCount);
+	if (g_mode == MODE_ADC) {
+		startAdcCapture(g_lastTickCount);
+	} else {
+		// index chunks are the same as compressed blocks, so each chunk can be decoded on its own
+		index::start(g_filePath, getNumColumns(), COMPRESSED_BLOCK_SIZE);
+		if (preTrigger) {
+			writePreTriggerSamples(tickCount);
+		}
+		log(g_lastTickCount);
+	}
 
 	return SCPI_RES_OK;
 }
 
 void finishLogging() {
 	setState(STATE_IDLE);
+	if (g_adcCaptureEnabled) {
+		g_adcCaptureEnabled = false;
+		writeAdcRecords(micros());
+	}
+	flushBuffers();
 	g_file.close();
+	bool indexOk = index::finish();
+	if (g_writeError || !indexOk) {
+		generateError(SCPI_ERROR_MASS_STORAGE_ERROR);
+	}
 	for (int i = 0; i < CH_NUM; ++i) {
 		g_logVoltage[i] = 0;
 		g_logCurrent[i] = 0;
@@ -231,7 +715,7 @@ void abort() {
 	}
 }
 
-void log(uint32_t tickCount) {
+static void updateCurrentTime(uint32_t tickCount) {
 	g_micros += tickCount - g_lastTickCount;
 	g_lastTickCount = tickCount;
 
@@ -241,12 +725,37 @@ void log(uint32_t tickCount) {
 	}
 
 	g_currentTime = g_seconds + g_micros * 1E-6;
+}
 
-	if (g_currentTime >= g_nextTime) {
+static void syncFile(uint32_t tickCount) {
+	int32_t diff = tickCount - g_lastSyncTickCount;
+	if (diff > CONF_DLOG_SYNC_FILE_TIME * 1000000L) {
+		g_lastSyncTickCount = tickCount;
 #if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
 		watchdog::disable();
 #endif
+		g_file.sync();
+#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
+		watchdog::enable();
+#endif
+	}
+}
+
+static void logAdcData(uint32_t tickCount) {
+	updateCurrentTime(tickCount);
 
+	if (g_currentTime >= g_time) {
+		finishLogging();
+	} else {
+		writeAdcRecords(tickCount);
+		syncFile(tickCount);
+	}
+}
+
+void log(uint32_t tickCount) {
+	updateCurrentTime(tickCount);
+
+	if (g_currentTime >= g_nextTime) {
 		float dt = (float)(g_currentTime - g_nextTime);
 
 		while (1) {
@@ -256,80 +765,47 @@ void log(uint32_t tickCount) {
 			}
 
 			// we missed a sample, write NAN
-#ifdef DLOG_JITTER
-			writeFloat(NAN);
-#endif
-			for (int i = 0; i < CH_NUM; ++i) {
-				Channel &channel = Channel::get(i);
-				if (g_logVoltage[i]) {
-					writeFloat(NAN);
-				}
-				if (g_logCurrent[i]) {
-					writeFloat(NAN);
-				}
-				if (g_logPower[i]) {
-					writeFloat(NAN);
-				}
-			}
+			float values[MAX_COLUMNS];
+			int numValues = getMissedSampleValues(values);
+			writeSample(values, numValues);
 		}
 
-
 		// write sample
-#ifdef DLOG_JITTER
-		writeFloat(dt);
-#endif
-		for (int i = 0; i < CH_NUM; ++i) {
-			Channel &channel = Channel::get(i);
-
-			float uMon;
-			float iMon;
-
-			if (g_logVoltage[i]) {
-				uMon = channel_dispatcher::getUMonLast(channel);
-				writeFloat(uMon);
-			}
-
-			if (g_logCurrent[i]) {
-				iMon = channel_dispatcher::getIMonLast(channel);
-				writeFloat(iMon);
-			}
-
-			if (g_logPower[i]) {
-				if (!g_logVoltage[i]) {
-					uMon = channel_dispatcher::getUMonLast(channel);
-				}
-				if (!g_logCurrent[i]) {
-					iMon = channel_dispatcher::getIMonLast(channel);
-				}
-				writeFloat(uMon * iMon);
-			}
-		}
+		float values[MAX_COLUMNS];
+		int numValues = getSampleValues(values, dt);
+		writeSample(values, numValues);
 
 		if (g_nextTime > g_time) {
 			finishLogging();
 		}
 		else {
-			int32_t diff = tickCount - g_lastSyncTickCount;
-			if (diff > CONF_DLOG_SYNC_FILE_TIME * 1000000L) {
-				g_lastSyncTickCount = tickCount;
-				g_file.sync();
-			}
+			syncFile(tickCount);
 		}
-
-#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
-		watchdog::enable();
-#endif
 	}
 }
 
 void tick(uint32_t tickCount) {
-	if (g_state == STATE_TRIGGERED) {
+	if (g_state == STATE_INITIATED) {
+		logPreTrigger(tickCount);
+	} else if (g_state == STATE_TRIGGERED) {
 		int err = startImmediately();
 		if (err != SCPI_RES_OK) {
 			generateError(err);
 		}
 	} else if (g_state == STATE_EXECUTING) {
-		log(tickCount);
+		if (g_mode == MODE_ADC) {
+			logAdcData(tickCount);
+		} else {
+			log(tickCount);
+		}
+
+		if (g_state == STATE_EXECUTING && g_drainPending) {
+			drain(CONF_DLOG_WRITE_SLICE_SIZE);
+		}
+
+		if (g_writeError || index::isError()) {
+			finishLogging();
+		}
 	}
 }
 
@@ -345,6 +821,9 @@ void reset() {
 	g_period = PERIOD_DEFAULT;
 	g_time = TIME_DEFAULT;
 	g_triggerSource = trigger::SOURCE_IMMEDIATE;
+	g_mode = MODE_PERIODIC;
+	g_compression = false;
+	g_preTriggerSamples = 0;
 	g_filePath[0] = 0;
 }
 
@@ -40,6 +40,37 @@ extern float g_time;
 
 extern trigger::Source g_triggerSource;
 
+/// Max. number of columns in the sample (U, I and P for each channel and jitter).
+static const int MAX_COLUMNS = CH_MAX * 3 + 1;
+
+enum Mode {
+	/// Last measured values are logged every g_period seconds.
+	MODE_PERIODIC,
+	/// Every U_MON and I_MON ADC reading is logged as raw ADC data, with the
+	/// time stamp, and converted to the voltage or current when decoded.
+	MODE_ADC
+};
+extern Mode g_mode;
+
+/// Write samples in the compressed (version 2) file format.
+/// Used only in MODE_PERIODIC.
+extern bool g_compression;
+
+/// Number of samples, logged while waiting for the trigger, which are written
+/// to the file ahead of the samples after the trigger. Used only in MODE_PERIODIC.
+/// Also limited to CONF_DLOG_PRE_TRIGGER_BUFFER_SIZE / number of columns.
+static const uint32_t PRE_TRIGGER_MAX = CONF_DLOG_PRE_TRIGGER_BUFFER_SIZE;
+extern uint32_t g_preTriggerSamples;
+
+/// Type of the ADC reading in the MODE_ADC record.
+enum AdcDataType {
+	ADC_DATA_U_MON,
+	ADC_DATA_I_MON_RANGE_HIGH,
+	ADC_DATA_I_MON_RANGE_LOW,
+	/// Records were lost because SD card was too slow, data is number of lost records.
+	ADC_DATA_GAP = 0xFF
+};
+
 extern double g_currentTime;
 
 bool isIdle();
@@ -49,6 +80,9 @@ void triggerGenerated(bool startImmediatelly = true);
 int startImmediately();
 void abort();
 
+/// Called from Channel::adcDataIsReady, it could be called from the interrupt.
+void onAdcData(int channelIndex, AdcDataType type, int16_t data);
+
 void tick(uint32_t tick_usec);
 void reset();
 
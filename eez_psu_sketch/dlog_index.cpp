@@ -0,0 +1,366 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "psu.h"
+
+#if OPTION_SD_CARD
+
+#include "sd_card.h"
+#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
+#include "watchdog.h"
+#endif
+#include "dlog.h"
+#include "dlog_index.h"
+
+#define INDEX_MAGIC1  0x2D5A4545L
+#define INDEX_MAGIC2  0x58444944L
+#define INDEX_VERSION 1
+
+#define INDEX_HEADER_SIZE 16
+
+/// Each coarser tier has this many times less entries.
+#define TIER_REDUCTION 4
+
+#define MAX_TIERS 8
+
+namespace eez {
+namespace psu {
+namespace dlog {
+namespace index {
+
+struct ColumnStats {
+	float min;
+	float max;
+	float sum;
+	uint32_t count;
+};
+
+struct Entry {
+	uint32_t fileOffset;
+	uint32_t numSamples;
+	ColumnStats columns[MAX_COLUMNS];
+};
+
+static File g_file;
+static bool g_isStarted;
+static bool g_isOpen;
+static bool g_error;
+static int g_numColumns;
+static uint32_t g_chunkSize;
+static uint32_t g_numChunks;
+
+static Entry g_chunk;
+
+// Fixed size overview of the whole log, kept in RAM. When it is full,
+// neighbouring entries are merged and each entry then covers twice as
+// many chunks. Coarser tiers are built from it in finish. Entries only
+// have the stats of the logged columns, so the max. number of entries
+// depends on the number of columns.
+static uint32_t g_overviewBuffer[CONF_DLOG_INDEX_OVERVIEW_BUFFER_SIZE / 4];
+static size_t g_overviewEntrySize;
+static int g_maxOverviewEntries;
+static int g_numOverviewEntries;
+static uint32_t g_chunksPerOverviewEntry;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void write(const uint8_t *data, size_t size) {
+#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
+	watchdog::disable();
+#endif
+
+	if (!g_error && g_file.write(data, size) != size) {
+		g_error = true;
+	}
+
+#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
+	watchdog::enable();
+#endif
+}
+
+static uint8_t *putUint16(uint8_t *p, uint16_t value) {
+	*p++ = (uint8_t)value;
+	*p++ = (uint8_t)(value >> 8);
+	return p;
+}
+
+static uint8_t *putUint32(uint8_t *p, uint32_t value) {
+	p = putUint16(p, (uint16_t)value);
+	return putUint16(p, (uint16_t)(value >> 16));
+}
+
+static uint8_t *putFloat(uint8_t *p, float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return putUint32(p, bits);
+}
+
+static Entry &getOverviewEntry(int i) {
+	return *(Entry *)((uint8_t *)g_overviewBuffer + i * g_overviewEntrySize);
+}
+
+static void copyEntry(Entry &entry, const Entry &other) {
+	entry.fileOffset = other.fileOffset;
+	entry.numSamples = other.numSamples;
+	for (int i = 0; i < g_numColumns; ++i) {
+		entry.columns[i] = other.columns[i];
+	}
+}
+
+static void resetEntry(Entry &entry) {
+	entry.fileOffset = 0;
+	entry.numSamples = 0;
+	for (int i = 0; i < g_numColumns; ++i) {
+		entry.columns[i].min = NAN;
+		entry.columns[i].max = NAN;
+		entry.columns[i].sum = 0;
+		entry.columns[i].count = 0;
+	}
+}
+
+static void mergeEntry(Entry &entry, const Entry &other) {
+	if (entry.numSamples == 0) {
+		entry.fileOffset = other.fileOffset;
+	}
+	entry.numSamples += other.numSamples;
+
+	for (int i = 0; i < g_numColumns; ++i) {
+		ColumnStats &stats = entry.columns[i];
+		const ColumnStats &otherStats = other.columns[i];
+		if (otherStats.count > 0) {
+			if (stats.count == 0) {
+				stats.min = otherStats.min;
+				stats.max = otherStats.max;
+			} else {
+				if (otherStats.min < stats.min) {
+					stats.min = otherStats.min;
+				}
+				if (otherStats.max > stats.max) {
+					stats.max = otherStats.max;
+				}
+			}
+			stats.sum += otherStats.sum;
+			stats.count += otherStats.count;
+		}
+	}
+}
+
+static void writeEntry(const Entry &entry) {
+	uint8_t buffer[8 + MAX_COLUMNS * 12];
+
+	uint8_t *p = buffer;
+	p = putUint32(p, entry.fileOffset);
+	p = putUint32(p, entry.numSamples);
+	for (int i = 0; i < g_numColumns; ++i) {
+		const ColumnStats &stats = entry.columns[i];
+		p = putFloat(p, stats.min);
+		p = putFloat(p, stats.max);
+		p = putFloat(p, stats.count > 0 ? stats.sum / stats.count : NAN);
+	}
+
+	write(buffer, p - buffer);
+}
+
+static void addToOverview(const Entry &entry) {
+	if (g_numOverviewEntries > 0) {
+		Entry &last = getOverviewEntry(g_numOverviewEntries - 1);
+		if (last.numSamples < g_chunksPerOverviewEntry * g_chunkSize) {
+			mergeEntry(last, entry);
+			return;
+		}
+	}
+
+	if (g_numOverviewEntries == g_maxOverviewEntries) {
+		for (int i = 0; i < g_maxOverviewEntries / 2; ++i) {
+			copyEntry(getOverviewEntry(i), getOverviewEntry(2 * i));
+			mergeEntry(getOverviewEntry(i), getOverviewEntry(2 * i + 1));
+		}
+		g_numOverviewEntries = g_maxOverviewEntries / 2;
+		g_chunksPerOverviewEntry *= 2;
+	}
+
+	copyEntry(getOverviewEntry(g_numOverviewEntries++), entry);
+}
+
+static void finishChunk() {
+	writeEntry(g_chunk);
+	addToOverview(g_chunk);
+	++g_numChunks;
+	resetEntry(g_chunk);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void start(const char *filePath, int numColumns, uint32_t chunkSize) {
+	char indexFilePath[MAX_PATH_LENGTH + 5];
+	strcpy(indexFilePath, filePath);
+	strcat(indexFilePath, ".idx");
+
+	g_isStarted = true;
+	g_error = false;
+
+	g_file = SD.open(indexFilePath, FILE_WRITE);
+	g_isOpen = g_file && g_file.truncate(0);
+	if (!g_isOpen) {
+		g_error = true;
+		return;
+	}
+
+	g_numColumns = numColumns;
+	// entry in the overview buffer has only the stats of the logged columns,
+	// number of entries must be even
+	g_overviewEntrySize = offsetof(Entry, columns) + numColumns * sizeof(ColumnStats);
+	g_maxOverviewEntries = (CONF_DLOG_INDEX_OVERVIEW_BUFFER_SIZE / g_overviewEntrySize) & ~1;
+	g_chunkSize = chunkSize;
+	g_numChunks = 0;
+	resetEntry(g_chunk);
+	g_numOverviewEntries = 0;
+	g_chunksPerOverviewEntry = 1;
+
+	uint8_t header[INDEX_HEADER_SIZE];
+	uint8_t *p = header;
+	p = putUint32(p, INDEX_MAGIC1);
+	p = putUint32(p, INDEX_MAGIC2);
+	p = putUint16(p, INDEX_VERSION);
+	p = putUint16(p, (uint16_t)numColumns);
+	p = putUint32(p, chunkSize);
+	write(header, p - header);
+}
+
+void addSample(uint32_t fileOffset, const float *values) {
+	if (!g_isOpen) {
+		return;
+	}
+
+	if (g_chunk.numSamples == 0) {
+		g_chunk.fileOffset = fileOffset;
+	}
+	++g_chunk.numSamples;
+
+	for (int i = 0; i < g_numColumns; ++i) {
+		float value = values[i];
+		if (!util::isNaN(value)) {
+			ColumnStats &stats = g_chunk.columns[i];
+			if (stats.count == 0) {
+				stats.min = value;
+				stats.max = value;
+			} else {
+				if (value < stats.min) {
+					stats.min = value;
+				}
+				if (value > stats.max) {
+					stats.max = value;
+				}
+			}
+			stats.sum += value;
+			++stats.count;
+		}
+	}
+
+	if (g_chunk.numSamples == g_chunkSize) {
+		finishChunk();
+	}
+}
+
+bool isError() {
+	return g_isStarted && g_error;
+}
+
+bool finish() {
+	if (!g_isStarted) {
+		return true;
+	}
+	g_isStarted = false;
+
+	if (!g_isOpen) {
+		return false;
+	}
+
+	if (g_chunk.numSamples > 0) {
+		finishChunk();
+	}
+
+	uint32_t entrySize = 8 + g_numColumns * 12;
+
+	uint32_t tiers[MAX_TIERS][3];
+	int numTiers = 0;
+
+	tiers[numTiers][0] = INDEX_HEADER_SIZE;
+	tiers[numTiers][1] = g_numChunks;
+	tiers[numTiers][2] = g_chunkSize;
+	uint32_t offset = INDEX_HEADER_SIZE + g_numChunks * entrySize;
+	++numTiers;
+
+	uint32_t samplesPerEntry = g_chunksPerOverviewEntry * g_chunkSize;
+
+	// if there was no merge, overview is the same as tier 0
+	bool writeOverview = g_chunksPerOverviewEntry > 1;
+
+	while (numTiers < MAX_TIERS) {
+		if (writeOverview) {
+			for (int i = 0; i < g_numOverviewEntries; ++i) {
+				writeEntry(getOverviewEntry(i));
+			}
+
+			tiers[numTiers][0] = offset;
+			tiers[numTiers][1] = g_numOverviewEntries;
+			tiers[numTiers][2] = samplesPerEntry;
+			offset += g_numOverviewEntries * entrySize;
+			++numTiers;
+		}
+
+		if (g_numOverviewEntries <= 1) {
+			break;
+		}
+
+		// reduce
+		int numEntries = (g_numOverviewEntries + TIER_REDUCTION - 1) / TIER_REDUCTION;
+		for (int i = 0; i < numEntries; ++i) {
+			copyEntry(getOverviewEntry(i), getOverviewEntry(i * TIER_REDUCTION));
+			for (int j = i * TIER_REDUCTION + 1; j < (i + 1) * TIER_REDUCTION && j < g_numOverviewEntries; ++j) {
+				mergeEntry(getOverviewEntry(i), getOverviewEntry(j));
+			}
+		}
+		g_numOverviewEntries = numEntries;
+		samplesPerEntry *= TIER_REDUCTION;
+		writeOverview = true;
+	}
+
+	uint8_t buffer[MAX_TIERS * 12 + 8];
+	uint8_t *p = buffer;
+	for (int i = 0; i < numTiers; ++i) {
+		p = putUint32(p, tiers[i][0]);
+		p = putUint32(p, tiers[i][1]);
+		p = putUint32(p, tiers[i][2]);
+	}
+	p = putUint32(p, numTiers);
+	p = putUint32(p, INDEX_MAGIC2);
+	write(buffer, p - buffer);
+
+	g_file.close();
+	g_isOpen = false;
+
+	return !g_error;
+}
+
+}
+}
+}
+} // namespace eez::psu::dlog::index
+
+#endif // OPTION_SD_CARD
@@ -0,0 +1,63 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace eez {
+namespace psu {
+namespace dlog {
+/// Index of the periodic data log, written to the sidecar file with the
+/// ".idx" appended to the data log file name.
+///
+/// All the values are little endian. File starts with the header:
+///
+///     uint32_t magic1;          "EEZ-", same as in the data log file
+///     uint32_t magic2;          "DIDX"
+///     uint16_t version;         1
+///     uint16_t numColumns;
+///     uint32_t chunkSize;       number of samples in the chunk
+///
+/// followed by the tiers of the entries. Each entry is:
+///
+///     uint32_t fileOffset;      of the first sample in the data log file
+///     uint32_t numSamples;
+///     float min, max, mean;     for each column, NaN samples are skipped
+///
+/// Tier 0 has one entry for each chunk. Coarser tiers are built by the
+/// reduction of the finer ones. The file ends with the tier table:
+///
+///     uint32_t offset, numEntries, samplesPerEntry;   for each tier
+///     uint32_t numTiers;
+///     uint32_t magic2;
+namespace index {
+
+/// Starts the index for the given data log file, chunk is chunkSize samples.
+void start(const char *filePath, int numColumns, uint32_t chunkSize);
+/// Adds the sample, fileOffset is the position of the sample in the data log file.
+void addSample(uint32_t fileOffset, const float *values);
+/// Returns true if the index file couldn't be created or written,
+/// then the data logging should be stopped with the mass storage error.
+bool isError();
+/// Writes the last chunk and the coarser tiers and closes the index file.
+/// Returns false if the index is not complete because of the error.
+bool finish();
+
+}
+}
+}
+} // namespace eez::psu::dlog::index
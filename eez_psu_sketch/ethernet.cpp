@@ -22,6 +22,7 @@
 #include "serial_psu.h"
 #include "event_queue.h"
 #include "watchdog.h"
+#include "stream.h"
 
 #if OPTION_ETHERNET
 
@@ -50,8 +51,10 @@ psu::TestResult g_testResult = psu::TEST_FAILED;
 
 static EthernetServer *server;
 
-static bool g_isConnected = false;
-static EthernetClient g_activeClient;
+static bool g_isConnected[ETHERNET_MAX_CLIENTS];
+static EthernetClient g_clients[ETHERNET_MAX_CLIENTS];
+// connection which is serviced first in the next tick
+static int g_nextClient;
 //static uint32_t g_lastCheckDhcpLeaseTime;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -70,19 +73,27 @@ size_t ethernet_client_write_str(EthernetClient &client, const char *str) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static size_t writeClient(scpi_t *context, const char *data, size_t len) {
+    return ethernet_client_write(g_clients[context - g_scpiContext], data, len);
+}
+
 size_t SCPI_Write(scpi_t *context, const char * data, size_t len) {
-    return ethernet_client_write(g_activeClient, data, len);
+    return writeBuffered(*context, data, len, writeClient);
 }
 
 scpi_result_t SCPI_Flush(scpi_t * context) {
+    flushBuffered(*context, writeClient);
     return SCPI_RES_OK;
 }
 
 int SCPI_Error(scpi_t *context, int_fast16_t err) {
     if (err != 0) {
+        // keep the order of the output
+        flushBuffered(*context, writeClient);
+
         char errorOutputBuffer[256];
         sprintf_P(errorOutputBuffer, PSTR("**ERROR: %d,\"%s\"\r\n"), (int16_t)err, SCPI_ErrorTranslate(err));
-        ethernet_client_write(g_activeClient, errorOutputBuffer, strlen(errorOutputBuffer));
+        writeClient(context, errorOutputBuffer, strlen(errorOutputBuffer));
 
 		if (err == SCPI_ERROR_INPUT_BUFFER_OVERRUN) {
 			scpi::onBufferOverrun(*context);
@@ -93,6 +104,8 @@ int SCPI_Error(scpi_t *context, int_fast16_t err) {
 }
 
 scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val) {
+    flushBuffered(*context, writeClient);
+
     char outputBuffer[256];
     if (SCPI_CTRL_SRQ == ctrl) {
         sprintf_P(outputBuffer, PSTR("**SRQ: 0x%X (%d)\r\n"), val, val);
@@ -100,23 +113,25 @@ scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_
         sprintf_P(outputBuffer, PSTR("**CTRL %02x: 0x%X (%d)\r\n"), ctrl, val, val);
     }
 
-    ethernet_client_write(g_activeClient, outputBuffer, strlen(outputBuffer));
+    writeClient(context, outputBuffer, strlen(outputBuffer));
 
     return SCPI_RES_OK;
 }
 
 scpi_result_t SCPI_Reset(scpi_t *context) {
+    flushBuffered(*context, writeClient);
+
     char errorOutputBuffer[256];
     strcpy_P(errorOutputBuffer, PSTR("**Reset\r\n"));
-    ethernet_client_write(g_activeClient, errorOutputBuffer, strlen(errorOutputBuffer));
+    writeClient(context, errorOutputBuffer, strlen(errorOutputBuffer));
 
     return psu::reset() ? SCPI_RES_OK : SCPI_RES_ERR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static scpi_reg_val_t g_scpiPsuRegs[SCPI_PSU_REG_COUNT];
-static scpi_psu_t g_scpiPsuContext = { g_scpiPsuRegs };
+static scpi_reg_val_t g_scpiPsuRegs[ETHERNET_MAX_CLIENTS][SCPI_PSU_REG_COUNT];
+static scpi_psu_t g_scpiPsuContext[ETHERNET_MAX_CLIENTS];
 
 static scpi_interface_t g_scpiInterface = {
     SCPI_Error,
@@ -126,10 +141,11 @@ static scpi_interface_t g_scpiInterface = {
     SCPI_Reset,
 };
 
-static char g_scpiInputBuffer[SCPI_PARSER_INPUT_BUFFER_LENGTH];
-static int16_t g_errorQueueData[SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
+static char g_scpiInputBuffer[ETHERNET_MAX_CLIENTS][SCPI_PARSER_INPUT_BUFFER_LENGTH];
+static char g_scpiOutputBuffer[ETHERNET_MAX_CLIENTS][SCPI_PARSER_OUTPUT_BUFFER_LENGTH];
+static int16_t g_errorQueueData[ETHERNET_MAX_CLIENTS][SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
 
-scpi_t g_scpiContext;
+scpi_t g_scpiContext[ETHERNET_MAX_CLIENTS];
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -204,11 +220,16 @@ void init() {
 #endif
 #endif
 
-    scpi::init(g_scpiContext,
-        g_scpiPsuContext,
-        &g_scpiInterface,
-        g_scpiInputBuffer, SCPI_PARSER_INPUT_BUFFER_LENGTH,
-        g_errorQueueData, SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+    for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+        g_scpiPsuContext[i].registers = g_scpiPsuRegs[i];
+
+        scpi::init(g_scpiContext[i],
+            g_scpiPsuContext[i],
+            &g_scpiInterface,
+            g_scpiInputBuffer[i], SCPI_PARSER_INPUT_BUFFER_LENGTH,
+            g_scpiOutputBuffer[i], SCPI_PARSER_OUTPUT_BUFFER_LENGTH,
+            g_errorQueueData[i], SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+    }
 
     //g_lastCheckDhcpLeaseTime = micros();
 }
@@ -244,44 +265,70 @@ void tick(uint32_t tick_usec) {
 
     SPI_beginTransaction(ETHERNET_SPI);
 
-    if (g_isConnected) {
-        if (!g_activeClient.connected()) {
-            g_isConnected = false;
-            g_activeClient = EthernetClient();
+    for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+        if (g_isConnected[i] && !g_clients[i].connected()) {
+            g_isConnected[i] = false;
+            g_clients[i] = EthernetClient();
+            stream::stop(g_scpiContext[i]);
             DebugTrace("Ethernet client lost!");
         }
     }
 
+    // server returns new client or some connected client with the data available
     EthernetClient client = server->available();
-
     if (client) {
-        if (!g_isConnected) {
-            client.flush();
-            g_activeClient = client;
-            g_isConnected = true;
-			scpi::emptyBuffer(g_scpiContext);
-            DebugTrace("A new ethernet client detected!");
+        int i;
+        for (i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            if (g_isConnected[i] && client == g_clients[i]) {
+                break;
+            }
         }
 
-        size_t size;
-        while ((size = client.available()) > 0) {
-            uint8_t* msg = (uint8_t*)malloc(size);
-            size = client.read(msg, size);
-            if (client == g_activeClient) {
-                SPI_endTransaction();
-                input(g_scpiContext, (const char *)msg, size);
-                SPI_beginTransaction(ETHERNET_SPI);
+        if (i == ETHERNET_MAX_CLIENTS) {
+            for (i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+                if (!g_isConnected[i]) {
+                    client.flush();
+                    g_clients[i] = client;
+                    g_isConnected[i] = true;
+                    // slot context is reused, new client shouldn't see anything from the previous one
+                    scpi::resetConnection(g_scpiContext[i]);
+                    DebugTrace("A new ethernet client detected!");
+                    break;
+                }
             }
-            else {
+
+            if (i == ETHERNET_MAX_CLIENTS) {
                 SPI_endTransaction();
-                ethernet_client_write_str(client, "**ERROR: another client already connected\r\n");
+                ethernet_client_write_str(client, "**ERROR: too many clients connected\r\n");
                 SPI_beginTransaction(ETHERNET_SPI);
-                DebugTrace("Another client detected and ignored!");
+                client.stop();
+                DebugTrace("Too many clients, new client rejected!");
             }
-            free(msg);
         }
     }
 
+    // round robin, each connection gets at most one chunk of input per tick
+    for (int k = 0; k < ETHERNET_MAX_CLIENTS; ++k) {
+        int i = (g_nextClient + k) % ETHERNET_MAX_CLIENTS;
+        if (!g_isConnected[i]) {
+            continue;
+        }
+
+        size_t size = g_clients[i].available();
+        if (size > 0) {
+            char buffer[SCPI_PARSER_INPUT_BUFFER_LENGTH / 2];
+            if (size > sizeof(buffer)) {
+                size = sizeof(buffer);
+            }
+            size = g_clients[i].read((uint8_t *)buffer, size);
+
+            SPI_endTransaction();
+            input(g_scpiContext[i], buffer, size);
+            SPI_beginTransaction(ETHERNET_SPI);
+        }
+    }
+    g_nextClient = (g_nextClient + 1) % ETHERNET_MAX_CLIENTS;
+
     SPI_endTransaction();
 }
 
@@ -290,16 +337,24 @@ uint32_t getIpAddress() {
 }
 
 bool isConnected() {
-    return g_isConnected;
+    for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+        if (g_isConnected[i]) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void update() {
-    if (g_isConnected) {
-        if (g_activeClient.connected()) {
-            g_activeClient.stop();
-            g_activeClient = EthernetClient();
+    for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+        if (g_isConnected[i]) {
+            if (g_clients[i].connected()) {
+                g_clients[i].stop();
+                g_clients[i] = EthernetClient();
+            }
+            g_isConnected[i] = false;
+            stream::stop(g_scpiContext[i]);
         }
-        g_isConnected = false;
     }
 
     g_testResult = psu::TEST_WARNING;
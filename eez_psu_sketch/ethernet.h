@@ -25,7 +25,8 @@ namespace psu {
 namespace ethernet {
 
 extern TestResult g_testResult;
-extern scpi_t g_scpiContext;
+/// SCPI parser context for each of the connections.
+extern scpi_t g_scpiContext[ETHERNET_MAX_CLIENTS];
 
 void init();
 bool test();
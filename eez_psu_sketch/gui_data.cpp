@@ -88,6 +88,7 @@ data::EnumItem g_triggerSourceEnumDefinition[] = {
     {trigger::SOURCE_IMMEDIATE, PSTR("Immediate")},
     {trigger::SOURCE_MANUAL, PSTR("Manual")},
     {trigger::SOURCE_PIN1, PSTR("Pin1")},
+    {trigger::SOURCE_THRESHOLD, PSTR("Threshold")},
     {0, 0}
 };
 
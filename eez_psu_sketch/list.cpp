@@ -20,10 +20,14 @@
 #include "list.h"
 #include "trigger.h"
 #include "channel_dispatcher.h"
+#include "calibration.h"
 #if OPTION_SD_CARD
 #include "sd_card.h"
 #endif
 #include "io_pins.h"
+#if CONF_LIST_TIMER && defined(EEZ_PSU_SIMULATOR)
+#include "simulator_timer.h"
+#endif
 
 #define CONF_COUNTER_THRESHOLD_IN_SECONDS 5
 
@@ -43,26 +47,477 @@ static struct {
 
     uint16_t count;
 
+    bool timerMode;
+
+    Function function;
+
     bool changed;
 } g_channelsLists[CH_MAX];
 
 static struct {
     int32_t counter;
-    int16_t it;
+    int32_t it;
     uint32_t nextPointTime;
     int32_t currentRemainingDwellTime;
     float currentTotalDwellTime;
     uint32_t lastTickCount;
+
+    // DAC codes of the steps are precomputed (see compile)
+    bool compiled;
+
+    // steps are set from the timer interrupt (see onTimer)
+    bool timerMode;
+    // next step is scheduled on the timer, while this is set
+    // execution state is changed only by the interrupt handler
+    volatile bool timerArmed;
+
+    // how late the steps were set, in microseconds
+    uint32_t jitterMax;
+    uint64_t jitterSum;
+    uint32_t jitterCount;
+    uint32_t jitterHistogram[JITTER_HISTOGRAM_SIZE];
 } g_execution[CH_MAX];
 
+// DAC codes of the list step, precomputed at the start of the execution.
+struct DacCodes {
+    uint16_t voltage;
+    uint16_t current;
+    uint8_t currentRange;
+};
+
+static DacCodes g_compiledSteps[CH_MAX][MAX_LIST_LENGTH];
+
+// Function points, precomputed at the start of the execution. In the function
+// mode the DAC code of the target value in g_compiledSteps is the code of the
+// function point and the other code is the code of the other list value.
+static float g_functionValues[CH_MAX][MAX_LIST_LENGTH];
+
 static bool g_active;
 
+static bool g_synchronized;
+
+// inter-channel skew of the synchronized execution, in microseconds
+static struct {
+    uint32_t max;
+    uint64_t sum;
+    uint32_t count;
+} g_skew;
+
+#if OPTION_SD_CARD
+
+// Binary list file starts with the header: uint32 magic1 ("EEZ-"),
+// uint32 magic2 ("LIST"), uint32 number of steps, followed by the steps:
+// float dwell, voltage and current. All values are little endian.
+#define BINARY_LIST_MAGIC1 0x2D5A4545L
+#define BINARY_LIST_MAGIC2 0x5453494CL
+#define BINARY_LIST_HEADER_SIZE 12
+#define BINARY_LIST_STEP_SIZE 12
+
+struct Step {
+    float dwell;
+    float voltage;
+    float current;
+    // valid only if list execution is compiled
+    DacCodes codes;
+};
+
+// Lists longer than MAX_LIST_LENGTH are not loaded into RAM, but executed
+// directly from the file through two windows of CONF_LIST_STREAM_WINDOW_SIZE
+// steps. While the steps from one window are executed, the other one is
+// refilled with the following steps from fillStreams. File is read only from
+// the normal priority task: before the execution both windows are prefilled
+// with the first steps and if the step is not in the windows when needed,
+// execution is aborted with the stream underrun error.
+static struct {
+    // number of steps, 0 if list is not streamed
+    uint32_t length;
+    char filePath[MAX_PATH_LENGTH + 1];
+    bool binary;
+    // value of the CSV file column which has only one value
+    Step constValues;
+
+    File file;
+    // step which is read next from the file
+    uint32_t nextStep;
+
+    Step windows[2][CONF_LIST_STREAM_WINDOW_SIZE];
+    uint32_t windowStart[2];
+    uint16_t windowLength[2];
+    uint8_t currentWindow;
+    bool fillPending;
+    // windows have the first steps, execution can start
+    bool prefilled;
+
+    // error of the step at which the last filled window was ended
+    int error;
+    uint32_t errorStep;
+} g_streams[CH_MAX];
+
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void init() {
     reset();
 }
 
+static int checkStepLimits(Channel &channel, float voltage, float current) {
+	if (util::greater(voltage, channel_dispatcher::getULimit(channel), getPrecision(VALUE_TYPE_FLOAT_VOLT))) {
+        return SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
+	}
+
+    if (util::greater(current, channel_dispatcher::getILimit(channel), getPrecision(VALUE_TYPE_FLOAT_AMPER))) {
+        return SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
+	}
+
+	if (util::greater(voltage * current, channel_dispatcher::getPowerLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
+        return SCPI_ERROR_POWER_LIMIT_EXCEEDED;
+    }
+
+    return 0;
+}
+
+/// Checks the step limits and precomputes the DAC codes of the step.
+static int compileStep(Channel &channel, float voltage, float current, DacCodes &codes) {
+    int err = checkStepLimits(channel, voltage, current);
+    if (err) {
+        return err;
+    }
+
+    codes.voltage = channel.getVoltageDacCode(voltage);
+    codes.currentRange = channel.getCurrentRangeForValue(current);
+    codes.current = channel.getCurrentDacCode(current, codes.currentRange);
+
+    return 0;
+}
+
+#if OPTION_SD_CARD
+
+/// Reads one row from the CSV list file. Column value is NaN if there is
+/// LIST_CSV_FILE_NO_VALUE_CHAR instead of the value.
+/// Returns 1 if row is read, 0 at the end of file and -1 on parse error.
+static int readCsvRow(File &file, Step &step) {
+    sd_card::matchZeroOrMoreSpaces(file);
+    if (!file.available()) {
+        return 0;
+    }
+
+    float *values = &step.dwell;
+    for (int j = 0; j < 3; ++j) {
+        if (j > 0) {
+            sd_card::match(file, CSV_SEPARATOR);
+        }
+
+        if (sd_card::match(file, LIST_CSV_FILE_NO_VALUE_CHAR)) {
+            values[j] = NAN;
+        } else if (!sd_card::match(file, values[j])) {
+            return -1;
+        }
+    }
+
+    return 1;
+}
+
+static bool readBinaryStep(File &file, Step &step) {
+    uint8_t buffer[BINARY_LIST_STEP_SIZE];
+    if (file.read(buffer, BINARY_LIST_STEP_SIZE) != BINARY_LIST_STEP_SIZE) {
+        return false;
+    }
+    step.dwell = util::getFloatLE(buffer);
+    step.voltage = util::getFloatLE(buffer + 4);
+    step.current = util::getFloatLE(buffer + 8);
+    return true;
+}
+
+static uint32_t getUint32LE(const uint8_t *data) {
+    return data[0] | (data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/// Returns true and the number of steps if this is the binary list file,
+/// otherwise rewinds the file.
+static bool readBinaryListHeader(File &file, uint32_t &length) {
+    uint8_t header[BINARY_LIST_HEADER_SIZE];
+    if (file.read(header, BINARY_LIST_HEADER_SIZE) == BINARY_LIST_HEADER_SIZE &&
+        getUint32LE(header) == BINARY_LIST_MAGIC1 && getUint32LE(header + 4) == BINARY_LIST_MAGIC2) {
+        length = getUint32LE(header + 8);
+        return true;
+    }
+
+    file.seek(0);
+    return false;
+}
+
+static void closeStream(int i) {
+    if (g_streams[i].file) {
+        g_streams[i].file.close();
+    }
+}
+
+static void stopStreaming(int i) {
+    closeStream(i);
+    g_streams[i].length = 0;
+}
+
+/// Positions the stream file at the given step.
+static bool seekStep(int i, uint32_t step) {
+    if (!g_streams[i].file) {
+        g_streams[i].file = SD.open(g_streams[i].filePath, FILE_READ);
+        if (!g_streams[i].file) {
+            return false;
+        }
+        g_streams[i].nextStep = UINT32_MAX;
+    }
+
+    if (g_streams[i].nextStep == step) {
+        return true;
+    }
+
+    if (g_streams[i].binary) {
+        if (!g_streams[i].file.seek(BINARY_LIST_HEADER_SIZE + step * BINARY_LIST_STEP_SIZE)) {
+            return false;
+        }
+    } else {
+        // rows are not of the fixed size, so skip all the rows before this step
+        if (step < g_streams[i].nextStep) {
+            if (!g_streams[i].file.seek(0)) {
+                return false;
+            }
+            g_streams[i].nextStep = 0;
+        }
+
+        while (g_streams[i].nextStep < step) {
+            Step skipped;
+            if (readCsvRow(g_streams[i].file, skipped) != 1) {
+                return false;
+            }
+            ++g_streams[i].nextStep;
+        }
+    }
+
+    g_streams[i].nextStep = step;
+    return true;
+}
+
+static int checkStreamStep(int i, Step &step, bool compiled) {
+    if (!(step.dwell >= LIST_DWELL_MIN && step.dwell <= LIST_DWELL_MAX)) {
+        return SCPI_ERROR_DATA_OUT_OF_RANGE;
+    }
+
+    if (compiled) {
+        return compileStep(Channel::get(i), step.voltage, step.current, step.codes);
+    }
+
+    return 0;
+}
+
+/// Reads the steps starting from the given one into the window,
+/// until the window is full or the end of the list. Window ends before
+/// the first step with the dwell out of range or, if compiled, before
+/// the first step which exceeds the limits. DAC codes of the compiled
+/// steps are also computed.
+/// Returns 0 or the error of the first step which is not read, the error
+/// is also remembered and reported when that step is needed.
+static int fillWindow(int i, uint8_t window, uint32_t start, bool compiled) {
+    g_streams[i].windowLength[window] = 0;
+
+    int err = 0;
+
+    uint16_t length = 0;
+    if (!seekStep(i, start)) {
+        err = SCPI_ERROR_MASS_STORAGE_ERROR;
+    }
+
+    while (!err && length < CONF_LIST_STREAM_WINDOW_SIZE && start + length < g_streams[i].length) {
+        Step &step = g_streams[i].windows[window][length];
+
+        if (g_streams[i].binary) {
+            if (!readBinaryStep(g_streams[i].file, step)) {
+                err = SCPI_ERROR_MASS_STORAGE_ERROR;
+                break;
+            }
+        } else {
+            if (readCsvRow(g_streams[i].file, step) != 1) {
+                err = SCPI_ERROR_MASS_STORAGE_ERROR;
+                break;
+            }
+
+            if (util::isNaN(step.dwell)) {
+                step.dwell = g_streams[i].constValues.dwell;
+            }
+            if (util::isNaN(step.voltage)) {
+                step.voltage = g_streams[i].constValues.voltage;
+            }
+            if (util::isNaN(step.current)) {
+                step.current = g_streams[i].constValues.current;
+            }
+        }
+
+        ++g_streams[i].nextStep;
+
+        err = checkStreamStep(i, step, compiled);
+        if (err) {
+            break;
+        }
+
+        ++length;
+    }
+
+    g_streams[i].windowStart[window] = start;
+    g_streams[i].windowLength[window] = length;
+
+    if (err) {
+        g_streams[i].error = err;
+        g_streams[i].errorStep = start + length;
+    }
+
+    return err;
+}
+
+/// Finds the step in the windows, without reading from the file.
+static bool findStreamStep(int i, uint32_t it, Step &step) {
+    for (int j = 0; j < 2; ++j) {
+        uint8_t window = g_streams[i].currentWindow ^ j;
+        if (it >= g_streams[i].windowStart[window] && it - g_streams[i].windowStart[window] < g_streams[i].windowLength[window]) {
+            if (window != g_streams[i].currentWindow) {
+                // moved to the next window, previous one can be refilled
+                g_streams[i].currentWindow = window;
+                g_streams[i].fillPending = true;
+            }
+            step = g_streams[i].windows[window][it - g_streams[i].windowStart[window]];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int getStreamStep(int i, uint32_t it, Step &step) {
+    if (findStreamStep(i, it, step)) {
+        return 0;
+    }
+
+    // this is executed from the critical list task, so the file is never
+    // read here, windows are filled only from fillStreams
+    if (g_streams[i].error && it == g_streams[i].errorStep) {
+        return g_streams[i].error;
+    }
+    return SCPI_ERROR_LIST_STREAM_UNDERRUN;
+}
+
+/// Fills both windows with the first steps. Steps are compiled
+/// at the start of the execution, when the limits are known (see compile).
+static void prefill(int i) {
+    g_streams[i].error = 0;
+    g_streams[i].currentWindow = 0;
+    g_streams[i].fillPending = false;
+    g_streams[i].windowLength[1] = 0;
+    if (fillWindow(i, 0, 0, false) == 0) {
+        uint32_t start = g_streams[i].windowLength[0];
+        if (start < g_streams[i].length) {
+            fillWindow(i, 1, start, false);
+        }
+    }
+    g_streams[i].prefilled = true;
+}
+
+void fillStreams(uint32_t tick_usec) {
+    for (int i = 0; i < CH_NUM; ++i) {
+        if (g_streams[i].length > 0 && !g_streams[i].prefilled && g_execution[i].counter < 0) {
+            prefill(i);
+        } else if (g_streams[i].length > 0 && g_streams[i].fillPending) {
+            // window can be changed from the timer interrupt
+            noInterrupts();
+            g_streams[i].fillPending = false;
+            uint8_t current = g_streams[i].currentWindow;
+            interrupts();
+            uint32_t start = g_streams[i].windowStart[current] + g_streams[i].windowLength[current];
+            if (start == g_streams[i].length) {
+                // next repetition of the list
+                start = 0;
+            }
+
+            // on error, window ends before the step and error is reported when that step is needed
+            fillWindow(i, current ^ 1, start, g_execution[i].compiled);
+        }
+    }
+}
+
+#endif
+
+static bool isFunction(int i) {
+    return g_channelsLists[i].function.shape != FUNCTION_NONE;
+}
+
+/// Returns the function point and, if codes is not NULL, the point and
+/// the DAC codes precomputed by compile. Otherwise the point is computed here.
+static bool getFunctionStep(int i, int32_t it, float &dwell, float &voltage, float &current, DacCodes *codes) {
+    const Function &function = g_channelsLists[i].function;
+
+    dwell = function.period / function.points;
+
+    float value;
+    if (codes) {
+        value = g_functionValues[i][it];
+        *codes = g_compiledSteps[i][it];
+    } else {
+        value = getFunctionValue(function, it);
+    }
+
+    if (function.target == FUNCTION_TARGET_VOLTAGE) {
+        voltage = value;
+        current = g_channelsLists[i].currentList[it % g_channelsLists[i].currentListLength];
+        if (codes) {
+            const DacCodes &otherCodes = g_compiledSteps[i][it % g_channelsLists[i].currentListLength];
+            codes->currentRange = otherCodes.currentRange;
+            codes->current = otherCodes.current;
+        }
+    } else {
+        voltage = g_channelsLists[i].voltageList[it % g_channelsLists[i].voltageListLength];
+        current = value;
+        if (codes) {
+            codes->voltage = g_compiledSteps[i][it % g_channelsLists[i].voltageListLength].voltage;
+        }
+    }
+
+    return true;
+}
+
+/// Returns the step values and, if codes is not NULL, the step DAC codes
+/// precomputed by compile.
+static bool getStep(int i, int32_t it, float &dwell, float &voltage, float &current, DacCodes *codes, int *err) {
+    if (isFunction(i)) {
+        return getFunctionStep(i, it, dwell, voltage, current, codes);
+    }
+
+#if OPTION_SD_CARD
+    if (g_streams[i].length > 0) {
+        Step step;
+        int stepErr = getStreamStep(i, it, step);
+        if (stepErr) {
+            if (err) {
+                *err = stepErr;
+            }
+            return false;
+        }
+        dwell = step.dwell;
+        voltage = step.voltage;
+        current = step.current;
+        if (codes) {
+            *codes = step.codes;
+        }
+        return true;
+    }
+#endif
+
+    dwell = g_channelsLists[i].dwellList[it % g_channelsLists[i].dwellListLength];
+    voltage = g_channelsLists[i].voltageList[it % g_channelsLists[i].voltageListLength];
+    current = g_channelsLists[i].currentList[it % g_channelsLists[i].currentListLength];
+    if (codes) {
+        *codes = g_compiledSteps[i][it];
+    }
+    return true;
+}
+
 void resetChannelList(Channel &channel) {
     int i = channel.index - 1;
 
@@ -74,16 +529,34 @@ void resetChannelList(Channel &channel) {
 
     g_channelsLists[i].count = 1;
 
+    g_channelsLists[i].timerMode = false;
+
+    g_channelsLists[i].function.shape = FUNCTION_NONE;
+    g_channelsLists[i].function.target = FUNCTION_TARGET_VOLTAGE;
+    g_channelsLists[i].function.amplitude = 1.0f;
+    g_channelsLists[i].function.offset = 1.0f;
+    g_channelsLists[i].function.period = LIST_FUNCTION_PERIOD_DEF;
+    g_channelsLists[i].function.points = LIST_FUNCTION_POINTS_DEF;
+
     g_execution[i].counter = -1;
+
+#if OPTION_SD_CARD
+    stopStreaming(i);
+#endif
 }
 
 void reset() {
     for (int i = 0; i < CH_NUM; ++i) {
         resetChannelList(Channel::get(i));
     }
+
+    g_synchronized = false;
 }
 
 void setDwellList(Channel &channel, float *list, uint16_t listLength) {
+#if OPTION_SD_CARD
+    stopStreaming(channel.index - 1);
+#endif
     memcpy(g_channelsLists[channel.index - 1].dwellList, list, listLength * sizeof(float));
     g_channelsLists[channel.index - 1].dwellListLength = listLength;
     g_channelsLists[channel.index - 1].changed = true;
@@ -95,6 +568,9 @@ float *getDwellList(Channel &channel, uint16_t *listLength) {
 }
 
 void setVoltageList(Channel &channel, float *list, uint16_t listLength) {
+#if OPTION_SD_CARD
+    stopStreaming(channel.index - 1);
+#endif
     memcpy(g_channelsLists[channel.index - 1].voltageList, list, listLength * sizeof(float));
     g_channelsLists[channel.index - 1].voltageListLength = listLength;
     g_channelsLists[channel.index - 1].changed = true;
@@ -106,6 +582,9 @@ float *getVoltageList(Channel &channel, uint16_t *listLength) {
 }
 
 void setCurrentList(Channel &channel, float *list, uint16_t listLength) {
+#if OPTION_SD_CARD
+    stopStreaming(channel.index - 1);
+#endif
     memcpy(g_channelsLists[channel.index - 1].currentList, list, listLength * sizeof(float));
     g_channelsLists[channel.index - 1].currentListLength = listLength;
     g_channelsLists[channel.index - 1].changed = true;
@@ -116,6 +595,39 @@ float *getCurrentList(Channel &channel, uint16_t *listLength) {
     return g_channelsLists[channel.index - 1].currentList;
 }
 
+static void decodeBlock(float *list, const uint8_t *block, uint16_t listLength, bool bigEndian) {
+    for (uint16_t i = 0; i < listLength; ++i) {
+        list[i] = util::getFloat(block + i * sizeof(float), bigEndian);
+    }
+}
+
+void setDwellListFromBlock(Channel &channel, const uint8_t *block, uint16_t listLength, bool bigEndian) {
+#if OPTION_SD_CARD
+    stopStreaming(channel.index - 1);
+#endif
+    decodeBlock(g_channelsLists[channel.index - 1].dwellList, block, listLength, bigEndian);
+    g_channelsLists[channel.index - 1].dwellListLength = listLength;
+    g_channelsLists[channel.index - 1].changed = true;
+}
+
+void setVoltageListFromBlock(Channel &channel, const uint8_t *block, uint16_t listLength, bool bigEndian) {
+#if OPTION_SD_CARD
+    stopStreaming(channel.index - 1);
+#endif
+    decodeBlock(g_channelsLists[channel.index - 1].voltageList, block, listLength, bigEndian);
+    g_channelsLists[channel.index - 1].voltageListLength = listLength;
+    g_channelsLists[channel.index - 1].changed = true;
+}
+
+void setCurrentListFromBlock(Channel &channel, const uint8_t *block, uint16_t listLength, bool bigEndian) {
+#if OPTION_SD_CARD
+    stopStreaming(channel.index - 1);
+#endif
+    decodeBlock(g_channelsLists[channel.index - 1].currentList, block, listLength, bigEndian);
+    g_channelsLists[channel.index - 1].currentListLength = listLength;
+    g_channelsLists[channel.index - 1].changed = true;
+}
+
 bool getListsChanged(Channel &channel) {
     return g_channelsLists[channel.index - 1].changed;
 }
@@ -124,6 +636,77 @@ void setListsChanged(Channel &channel, bool changed) {
     g_channelsLists[channel.index - 1].changed = changed;
 }
 
+void setTimerMode(Channel &channel, bool enable) {
+    g_channelsLists[channel.index - 1].timerMode = enable;
+}
+
+bool getTimerMode(Channel &channel) {
+    return g_channelsLists[channel.index - 1].timerMode;
+}
+
+void setFunction(Channel &channel, const Function &function) {
+    int i = channel.index - 1;
+
+#if OPTION_SD_CARD
+    if (function.shape != FUNCTION_NONE) {
+        stopStreaming(i);
+    }
+#endif
+
+    g_channelsLists[i].function = function;
+}
+
+void getFunction(Channel &channel, Function &function) {
+    function = g_channelsLists[channel.index - 1].function;
+}
+
+float getFunctionValue(const Function &function, uint32_t point) {
+    point %= function.points;
+
+    // x goes from 0 to 1 (excluded) for the periodic shapes
+    // and from 0 to 1 (included) for the ramp and exponential
+    float x = 1.0f * point / function.points;
+    float xEnd = 1.0f * point / (function.points - 1);
+
+    float y;
+    switch (function.shape) {
+    case FUNCTION_SINE:
+        y = sinf(2 * 3.14159265f * x);
+        break;
+    case FUNCTION_SQUARE:
+        y = x < 0.5f ? 1.0f : -1.0f;
+        break;
+    case FUNCTION_RAMP:
+        y = 2 * xEnd - 1;
+        break;
+    case FUNCTION_STAIR:
+        {
+            // triangle from 0 to 1 and back, quantized to the stair levels
+            int level = (int)((1 - fabsf(2 * x - 1)) * LIST_FUNCTION_STAIR_STEPS);
+            if (level > LIST_FUNCTION_STAIR_STEPS - 1) {
+                level = LIST_FUNCTION_STAIR_STEPS - 1;
+            }
+            y = -1 + 2.0f * level / (LIST_FUNCTION_STAIR_STEPS - 1);
+        }
+        break;
+    case FUNCTION_EXPONENTIAL:
+        y = -1 + 2 * (1 - expf(-5 * xEnd)) / (1 - expf(-5));
+        break;
+    default:
+        y = 0;
+    }
+
+    return function.offset + function.amplitude * y;
+}
+
+void setSynchronized(bool enable) {
+    g_synchronized = enable;
+}
+
+bool isSynchronized() {
+    return g_synchronized;
+}
+
 uint16_t getListCount(Channel &channel) {
     return g_channelsLists[channel.index - 1].count;
 }
@@ -132,7 +715,22 @@ void setListCount(Channel &channel, uint16_t value) {
     g_channelsLists[channel.index - 1].count = value;
 }
 
+/// In the function mode only the list of the other (not target) value is used.
+static uint16_t getFunctionOtherListLength(int i) {
+    return g_channelsLists[i].function.target == FUNCTION_TARGET_VOLTAGE ?
+        g_channelsLists[i].currentListLength : g_channelsLists[i].voltageListLength;
+}
+
 bool isListEmpty(Channel &channel) {
+    if (isFunction(channel.index - 1)) {
+        return getFunctionOtherListLength(channel.index - 1) == 0;
+    }
+
+#if OPTION_SD_CARD
+    if (g_streams[channel.index - 1].length > 0) {
+        return false;
+    }
+#endif
     return g_channelsLists[channel.index - 1].dwellListLength == 0 &&
         g_channelsLists[channel.index - 1].voltageListLength == 0 &&
         g_channelsLists[channel.index - 1].currentListLength == 0;
@@ -149,6 +747,18 @@ bool areListLengthsEquivalent(uint16_t size1, uint16_t size2, uint16_t size3) {
 }
 
 bool areListLengthsEquivalent(Channel &channel) {
+    int i = channel.index - 1;
+    if (isFunction(i)) {
+        uint16_t otherListLength = getFunctionOtherListLength(i);
+        return otherListLength == 1 || otherListLength == g_channelsLists[i].function.points;
+    }
+
+#if OPTION_SD_CARD
+    if (g_streams[channel.index - 1].length > 0) {
+        // checked when list is loaded
+        return true;
+    }
+#endif
     return list::areListLengthsEquivalent(
         g_channelsLists[channel.index - 1].dwellListLength,
         g_channelsLists[channel.index - 1].voltageListLength,
@@ -168,138 +778,227 @@ bool areVoltageAndCurrentListLengthsEquivalent(Channel &channel) {
     return areListLengthsEquivalent(g_channelsLists[channel.index - 1].voltageListLength, g_channelsLists[channel.index - 1].currentListLength);
 }
 
-int checkLimits(int iChannel) {
+static int checkFunctionLimits(int iChannel) {
     Channel &channel = Channel::get(iChannel);
+    const Function &function = g_channelsLists[iChannel].function;
 
-    uint16_t voltageListLength = g_channelsLists[iChannel].voltageListLength;
-    uint16_t currentListLength = g_channelsLists[iChannel].currentListLength;
+    if (function.offset - function.amplitude < 0) {
+        return SCPI_ERROR_DATA_OUT_OF_RANGE;
+    }
 
-    for (int j = 0; j < voltageListLength || j < currentListLength; ++j) {
-        float voltage = g_channelsLists[iChannel].voltageList[j % voltageListLength];
-	    if (util::greater(voltage, channel_dispatcher::getULimit(channel), getPrecision(VALUE_TYPE_FLOAT_VOLT))) {
-            return SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
-	    }
+    float dwell = function.period / function.points;
+    if (dwell < LIST_DWELL_MIN || dwell > LIST_DWELL_MAX) {
+        return SCPI_ERROR_DATA_OUT_OF_RANGE;
+    }
 
-        float current = g_channelsLists[iChannel].currentList[j % currentListLength];
-        if (util::greater(current, channel_dispatcher::getILimit(channel), getPrecision(VALUE_TYPE_FLOAT_AMPER))) {
-            return SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
-	    }
+    // all the shapes reach offset + amplitude
+    float maxValue = function.offset + function.amplitude;
 
-	    if (util::greater(voltage * current, channel_dispatcher::getPowerLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
-            return SCPI_ERROR_POWER_LIMIT_EXCEEDED;
+    uint16_t otherListLength = getFunctionOtherListLength(iChannel);
+    for (int j = 0; j < otherListLength; ++j) {
+        int err;
+        if (function.target == FUNCTION_TARGET_VOLTAGE) {
+            err = checkStepLimits(channel, maxValue, g_channelsLists[iChannel].currentList[j]);
+        } else {
+            err = checkStepLimits(channel, g_channelsLists[iChannel].voltageList[j], maxValue);
+        }
+        if (err) {
+            return err;
         }
     }
 
     return 0;
 }
 
-bool loadList(Channel &channel, const char *filePath, int *err) {
+int checkLimits(int iChannel) {
+    Channel &channel = Channel::get(iChannel);
+
+    if (isFunction(iChannel)) {
+        return checkFunctionLimits(iChannel);
+    }
+
 #if OPTION_SD_CARD
-    if (sd_card::g_testResult != TEST_OK) {
-        *err = SCPI_ERROR_MASS_STORAGE_ERROR;
-        return false;
+    if (g_streams[iChannel].length > 0) {
+        // streamed list is too long to be checked in advance,
+        // each step is checked when it is set (see setListValue)
+        return 0;
     }
+#endif
 
-    if (!sd_card::exists(filePath, NULL)) {
+    uint16_t voltageListLength = g_channelsLists[iChannel].voltageListLength;
+    uint16_t currentListLength = g_channelsLists[iChannel].currentListLength;
+
+    for (int j = 0; j < voltageListLength || j < currentListLength; ++j) {
+        int err = checkStepLimits(channel,
+            g_channelsLists[iChannel].voltageList[j % voltageListLength],
+            g_channelsLists[iChannel].currentList[j % currentListLength]);
         if (err) {
-            *err = SCPI_ERROR_LIST_NOT_FOUND;
+            return err;
         }
-        return false;
     }
 
-    File file = SD.open(filePath, FILE_READ);
+    return 0;
+}
 
-    if (!file) {
-        if (err) {
-            *err = SCPI_ERROR_EXECUTION_ERROR;
-        }
+#if OPTION_SD_CARD
+
+static bool loadBinaryList(Channel &channel, File &file, uint32_t length) {
+    int i = channel.index - 1;
+
+    if (length == 0 || file.size() != BINARY_LIST_HEADER_SIZE + length * BINARY_LIST_STEP_SIZE) {
         return false;
     }
 
-    float dwellList[MAX_LIST_LENGTH];
-    uint16_t dwellListLength = 0;
+    if (length > MAX_LIST_LENGTH) {
+        g_streams[i].binary = true;
+        g_streams[i].length = length;
+        return true;
+    }
 
+    float dwellList[MAX_LIST_LENGTH];
     float voltageList[MAX_LIST_LENGTH];
-    uint16_t voltageListLength = 0;
+    float currentList[MAX_LIST_LENGTH];
+
+    for (uint32_t j = 0; j < length; ++j) {
+        Step step;
+        if (!readBinaryStep(file, step)) {
+            return false;
+        }
+        dwellList[j] = step.dwell;
+        voltageList[j] = step.voltage;
+        currentList[j] = step.current;
+    }
+
+    setDwellList(channel, dwellList, length);
+    setVoltageList(channel, voltageList, length);
+    setCurrentList(channel, currentList, length);
+
+    return true;
+}
+
+static bool loadCsvList(Channel &channel, File &file) {
+    int i = channel.index - 1;
 
+    float dwellList[MAX_LIST_LENGTH];
+    float voltageList[MAX_LIST_LENGTH];
     float currentList[MAX_LIST_LENGTH];
-    uint16_t currentListLength = 0;
+    float *lists[3] = { dwellList, voltageList, currentList };
+    uint32_t listLengths[3] = { 0, 0, 0 };
 
-    bool success = true;
+    Step constValues;
 
-    for (int i = 0; i < MAX_LIST_LENGTH; ++i) {
-        sd_card::matchZeroOrMoreSpaces(file);
-        if (!file.available()) {
+    for (uint32_t row = 0; ; ++row) {
+        Step step;
+        int result = readCsvRow(file, step);
+        if (result == 0) {
             break;
         }
+        if (result == -1) {
+            return false;
+        }
 
-        float value;
-
-        if (sd_card::match(file, LIST_CSV_FILE_NO_VALUE_CHAR)) {
-            if (i < dwellListLength) {
-                success = false;
-                break;
-            }
-        } else if (sd_card::match(file, value)) {
-            if (i == dwellListLength) {
-                dwellList[i] = value;
-                dwellListLength = i + 1;
-            } else {
-                success = false;
-                break;
+        float *values = &step.dwell;
+        for (int j = 0; j < 3; ++j) {
+            if (!util::isNaN(values[j])) {
+                // list values must be in the successive rows from the first one
+                if (row != listLengths[j]) {
+                    return false;
+                }
+                if (row < MAX_LIST_LENGTH) {
+                    lists[j][row] = values[j];
+                }
+                if (row == 0) {
+                    (&constValues.dwell)[j] = values[j];
+                }
+                ++listLengths[j];
             }
-        } else {
-            success = false;
-            break;
         }
+    }
 
-        sd_card::match(file, CSV_SEPARATOR);
+    uint32_t length = listLengths[0];
+    if (listLengths[1] > length) {
+        length = listLengths[1];
+    }
+    if (listLengths[2] > length) {
+        length = listLengths[2];
+    }
 
-        if (sd_card::match(file, LIST_CSV_FILE_NO_VALUE_CHAR)) {
-            if (i < voltageListLength) {
-                success = false;
-                break;
+    if (length > MAX_LIST_LENGTH) {
+        // the lists of different lengths can't be streamed
+        for (int j = 0; j < 3; ++j) {
+            if (listLengths[j] != 1 && listLengths[j] != length) {
+                return false;
             }
-        } else if (sd_card::match(file, value)) {
-            if (i == voltageListLength) {
-                voltageList[i] = value;
-                ++voltageListLength;
-            } else {
-                success = false;
-                break;
-            }
-        } else {
-            success = false;
-            break;
         }
 
-        sd_card::match(file, CSV_SEPARATOR);
+        g_streams[i].binary = false;
+        g_streams[i].constValues = constValues;
+        g_streams[i].length = length;
 
-        if (sd_card::match(file, LIST_CSV_FILE_NO_VALUE_CHAR)) {
-            if (i < currentListLength) {
-                success = false;
-                break;
-            }
-        } else if (sd_card::match(file, value)) {
-            if (i == currentListLength) {
-                currentList[i] = value;
-                ++currentListLength;
-            } else {
-                success = false;
-                break;
-            }
-        } else {
-            success = false;
-            break;
+        return true;
+    }
+
+    setDwellList(channel, dwellList, listLengths[0]);
+    setVoltageList(channel, voltageList, listLengths[1]);
+    setCurrentList(channel, currentList, listLengths[2]);
+
+    return true;
+}
+
+#endif
+
+bool loadList(Channel &channel, const char *filePath, int *err) {
+#if OPTION_SD_CARD
+    if (sd_card::g_testResult != TEST_OK) {
+        *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        return false;
+    }
+
+    if (!sd_card::exists(filePath, NULL)) {
+        if (err) {
+            *err = SCPI_ERROR_LIST_NOT_FOUND;
+        }
+        return false;
+    }
+
+    int i = channel.index - 1;
+
+    stopStreaming(i);
+
+    File file = SD.open(filePath, FILE_READ);
+
+    if (!file) {
+        if (err) {
+            *err = SCPI_ERROR_EXECUTION_ERROR;
         }
+        return false;
+    }
+
+    bool success;
+
+    uint32_t length;
+    if (readBinaryListHeader(file, length)) {
+        success = loadBinaryList(channel, file, length);
+    } else {
+        success = loadCsvList(channel, file);
     }
 
     file.close();
 
     if (success) {
-        setDwellList(channel, dwellList, dwellListLength);
-        setVoltageList(channel, voltageList, voltageListLength);
-        setCurrentList(channel, currentList, currentListLength);
+        g_channelsLists[i].function.shape = FUNCTION_NONE;
+
+        if (g_streams[i].length > 0) {
+            g_channelsLists[i].dwellListLength = 0;
+            g_channelsLists[i].voltageListLength = 0;
+            g_channelsLists[i].currentListLength = 0;
+
+            strcpy(g_streams[i].filePath, filePath);
+            prefill(i);
+
+            // list is in the file
+            g_channelsLists[i].changed = false;
+        }
     } else {
         // TODO more specific error
         if (err) {
@@ -323,6 +1022,14 @@ bool saveList(Channel &channel, const char *filePath, int *err) {
         return false;
     }
 
+    if (g_streams[channel.index - 1].length > 0) {
+        // streamed list is not in RAM
+        if (err) {
+            *err = SCPI_ERROR_EXECUTION_ERROR;
+        }
+        return false;
+    }
+
     sd_card::makeParentDir(filePath);
 
     sd_card::deleteFile(filePath, NULL);
@@ -380,14 +1087,145 @@ bool saveList(Channel &channel, const char *filePath, int *err) {
 #endif
 }
 
+/// Precomputes the function points and the DAC codes of the function points
+/// and the other list values, so no function is evaluated in the interrupt.
+/// Function with more than MAX_LIST_LENGTH points is not compiled, its points
+/// are computed when the step is set. Limits are checked when the step is set.
+static void compileFunction(Channel &channel) {
+    int i = channel.index - 1;
+    const Function &function = g_channelsLists[i].function;
+
+    if (function.points > MAX_LIST_LENGTH) {
+        return;
+    }
+
+    for (uint32_t j = 0; j < function.points; ++j) {
+        float value = getFunctionValue(function, j);
+        g_functionValues[i][j] = value;
+        if (function.target == FUNCTION_TARGET_VOLTAGE) {
+            g_compiledSteps[i][j].voltage = channel.getVoltageDacCode(value);
+        } else {
+            g_compiledSteps[i][j].currentRange = channel.getCurrentRangeForValue(value);
+            g_compiledSteps[i][j].current = channel.getCurrentDacCode(value, g_compiledSteps[i][j].currentRange);
+        }
+    }
+
+    uint16_t otherListLength = getFunctionOtherListLength(i);
+    for (int j = 0; j < otherListLength; ++j) {
+        if (function.target == FUNCTION_TARGET_VOLTAGE) {
+            float current = g_channelsLists[i].currentList[j];
+            g_compiledSteps[i][j].currentRange = channel.getCurrentRangeForValue(current);
+            g_compiledSteps[i][j].current = channel.getCurrentDacCode(current, g_compiledSteps[i][j].currentRange);
+        } else {
+            g_compiledSteps[i][j].voltage = channel.getVoltageDacCode(g_channelsLists[i].voltageList[j]);
+        }
+    }
+
+    g_execution[i].compiled = true;
+}
+
+/// Checks all the steps and precomputes their DAC codes once, so only
+/// the codes are written to the DAC while the list is executed.
+/// Not used when channels are coupled or tracked, since then the values
+/// are distributed between the channels by the channel_dispatcher, nor
+/// during the calibration or DAC test. Streamed list steps are compiled
+/// when the windows are filled.
+static void compile(Channel &channel) {
+    int i = channel.index - 1;
+
+    g_execution[i].compiled = false;
+
+    if (channel_dispatcher::isCoupled() || channel_dispatcher::isTracked() || calibration::isEnabled() || channel.dac.isTesting()) {
+        return;
+    }
+
+    if (isFunction(i)) {
+        compileFunction(channel);
+        return;
+    }
+
+#if OPTION_SD_CARD
+    if (g_streams[i].length > 0) {
+        // prefilled steps are already in RAM, so only (re)compute their DAC codes,
+        // window ends before the first step which exceeds the limits
+        g_execution[i].compiled = true;
+        for (int window = 0; window < 2; ++window) {
+            for (uint16_t j = 0; j < g_streams[i].windowLength[window]; ++j) {
+                Step &step = g_streams[i].windows[window][j];
+                int err = compileStep(channel, step.voltage, step.current, step.codes);
+                if (err) {
+                    g_streams[i].windowLength[window] = j;
+                    g_streams[i].error = err;
+                    g_streams[i].errorStep = g_streams[i].windowStart[window] + j;
+                    break;
+                }
+            }
+        }
+        return;
+    }
+#endif
+
+    uint16_t voltageListLength = g_channelsLists[i].voltageListLength;
+    uint16_t currentListLength = g_channelsLists[i].currentListLength;
+
+    int length = maxListsSize(channel);
+    for (int j = 0; j < length; ++j) {
+        if (compileStep(channel,
+            g_channelsLists[i].voltageList[j % voltageListLength],
+            g_channelsLists[i].currentList[j % currentListLength],
+            g_compiledSteps[i][j])) {
+            // error is reported by setListValue when the step is reached
+            return;
+        }
+    }
+
+    g_execution[i].compiled = true;
+}
+
 void executionStart(Channel &channel) {
-    g_execution[channel.index - 1].it = -1;
-    g_execution[channel.index - 1].counter = g_channelsLists[channel.index - 1].count;
+    int i = channel.index - 1;
+
+    compile(channel);
+
+#if OPTION_SD_CARD
+    // windows are moved by the execution, prefill them again for the next one
+    g_streams[i].prefilled = false;
+#endif
+
+    // only precomputed DAC codes are written from the interrupt
+    g_execution[i].timerMode = CONF_LIST_TIMER && g_channelsLists[i].timerMode && g_execution[i].compiled && !g_synchronized;
+    g_execution[i].timerArmed = false;
+
+    g_execution[i].jitterMax = 0;
+    g_execution[i].jitterSum = 0;
+    g_execution[i].jitterCount = 0;
+    memset(g_execution[i].jitterHistogram, 0, sizeof(g_execution[i].jitterHistogram));
+
+    g_skew.max = 0;
+    g_skew.sum = 0;
+    g_skew.count = 0;
+
+    g_execution[i].it = -1;
+    g_execution[i].counter = g_channelsLists[i].count;
     g_active = true;
-    tick(micros());
+
+    if (!g_synchronized) {
+        tick(micros());
+    }
+    // else the first step is set on all the channels together from the next tick
 }
 
 int maxListsSize(Channel &channel) {
+    if (isFunction(channel.index - 1)) {
+        return g_channelsLists[channel.index - 1].function.points;
+    }
+
+#if OPTION_SD_CARD
+    if (g_streams[channel.index - 1].length > 0) {
+        return g_streams[channel.index - 1].length;
+    }
+#endif
+
     uint16_t maxSize = 0;
 
     if (g_channelsLists[channel.index - 1].voltageListLength > maxSize) {
@@ -405,21 +1243,16 @@ int maxListsSize(Channel &channel) {
     return maxSize;
 }
 
-bool setListValue(Channel &channel, int16_t it, int *err) {
-    float voltage = g_channelsLists[channel.index - 1].voltageList[it % g_channelsLists[channel.index - 1].voltageListLength];
-	if (util::greater(voltage, channel_dispatcher::getULimit(channel), getPrecision(VALUE_TYPE_FLOAT_VOLT))) {
-        *err = SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
-        return false;
-	}
-
-    float current = g_channelsLists[channel.index - 1].currentList[it % g_channelsLists[channel.index - 1].currentListLength];
-    if (util::greater(current, channel_dispatcher::getILimit(channel), getPrecision(VALUE_TYPE_FLOAT_AMPER))) {
-        *err = SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
+bool setListValue(Channel &channel, int32_t it, int *err) {
+    float dwell;
+    float voltage;
+    float current;
+    if (!getStep(channel.index - 1, it, dwell, voltage, current, NULL, err)) {
         return false;
-	}
+    }
 
-	if (util::greater(voltage * current, channel_dispatcher::getPowerLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
-        *err = SCPI_ERROR_POWER_LIMIT_EXCEEDED;
+    *err = checkStepLimits(channel, voltage, current);
+    if (*err) {
         return false;
     }
 
@@ -434,6 +1267,420 @@ bool setListValue(Channel &channel, int16_t it, int *err) {
     return true;
 }
 
+/// Same as setListValue, but only the precomputed DAC codes are written.
+/// Limits can be changed after the step is compiled, so they are checked
+/// again, that is only a few float compares.
+static int setCompiledStep(Channel &channel, float voltage, float current, const DacCodes &codes) {
+    int err = checkStepLimits(channel, voltage, current);
+    if (err) {
+        return err;
+    }
+
+    if (channel.u.set != voltage) {
+        channel.setVoltage(voltage, codes.voltage);
+    }
+
+    if (channel.i.set != current) {
+        channel.setCurrent(current, codes.currentRange, codes.current);
+    }
+
+    return 0;
+}
+
+static bool setCompiledListValue(Channel &channel, int32_t it, int *err) {
+    float dwell;
+    float voltage;
+    float current;
+    DacCodes codes;
+    if (!getStep(channel.index - 1, it, dwell, voltage, current, &codes, err)) {
+        return false;
+    }
+
+    *err = setCompiledStep(channel, voltage, current, codes);
+    if (*err) {
+        return false;
+    }
+
+    return true;
+}
+
+/// Moves to the next step, returns false if list execution is finished.
+static bool nextStep(int i) {
+    Channel &channel = Channel::get(i);
+
+    if (++g_execution[i].it == maxListsSize(channel)) {
+        if (g_execution[i].counter > 0) {
+            if (--g_execution[i].counter == 0) {
+                g_execution[i].counter = -1;
+                trigger::setTriggerFinished(channel);
+#if OPTION_SD_CARD
+                closeStream(i);
+#endif
+                return false;
+            }
+        }
+
+        g_execution[i].it = 0;
+    }
+
+    return true;
+}
+
+static void updateJitter(int i, uint32_t jitter) {
+    if (jitter > g_execution[i].jitterMax) {
+        g_execution[i].jitterMax = jitter;
+    }
+    g_execution[i].jitterSum += jitter;
+    ++g_execution[i].jitterCount;
+
+    int bin = 0;
+    while (jitter > 0 && bin < JITTER_HISTOGRAM_SIZE - 1) {
+        jitter >>= 1;
+        ++bin;
+    }
+    ++g_execution[i].jitterHistogram[bin];
+}
+
+#if CONF_LIST_TIMER
+
+#if defined(EEZ_PSU_SIMULATOR)
+
+static void startTimer(uint32_t timeoutUs) {
+    simulator::timer::start(timeoutUs, onTimer);
+}
+
+static void stopTimer() {
+    simulator::timer::stop();
+}
+
+#else
+
+// TC1 channel 0 is used by the buzzer
+#define LIST_TIMER TC1
+#define LIST_TIMER_CHANNEL 1
+#define LIST_TIMER_IRQ TC4_IRQn
+// TIMER_CLOCK1 is MCK/2
+#define LIST_TIMER_TICKS_PER_US (VARIANT_MCK / 2 / 1000000)
+
+static bool g_timerInitialized;
+
+static void startTimer(uint32_t timeoutUs) {
+    if (!g_timerInitialized) {
+        pmc_set_writeprotect(false);
+        pmc_enable_periph_clk((uint32_t)LIST_TIMER_IRQ);
+        TC_Configure(LIST_TIMER, LIST_TIMER_CHANNEL,
+            TC_CMR_TCCLKS_TIMER_CLOCK1 |
+            TC_CMR_WAVE |         // Waveform mode
+            TC_CMR_WAVSEL_UP_RC | // Counter running up and reset when equals to RC
+            TC_CMR_CPCSTOP);      // One shot, counter is stopped at RC compare
+
+        LIST_TIMER->TC_CHANNEL[LIST_TIMER_CHANNEL].TC_IER = TC_IER_CPCS;  // RC compare interrupt
+        LIST_TIMER->TC_CHANNEL[LIST_TIMER_CHANNEL].TC_IDR = ~TC_IER_CPCS;
+        NVIC_EnableIRQ(LIST_TIMER_IRQ);
+
+        g_timerInitialized = true;
+    }
+
+    TC_Stop(LIST_TIMER, LIST_TIMER_CHANNEL);
+    TC_SetRC(LIST_TIMER, LIST_TIMER_CHANNEL, timeoutUs * LIST_TIMER_TICKS_PER_US);
+    TC_Start(LIST_TIMER, LIST_TIMER_CHANNEL);
+}
+
+static void stopTimer() {
+    if (g_timerInitialized) {
+        TC_Stop(LIST_TIMER, LIST_TIMER_CHANNEL);
+    }
+}
+
+#endif
+
+/// Starts the timer for the earliest scheduled step.
+/// Executed from the interrupt handler or with the interrupts disabled.
+static void scheduleTimer() {
+    uint32_t tick_usec = micros();
+
+    bool armed = false;
+    int32_t timeout = 0;
+    for (int i = 0; i < CH_NUM; ++i) {
+        if (g_execution[i].timerArmed) {
+            int32_t remaining = g_execution[i].nextPointTime - tick_usec;
+            if (!armed || remaining < timeout) {
+                timeout = remaining;
+            }
+            armed = true;
+        }
+    }
+
+    if (armed) {
+        startTimer(timeout > 0 ? timeout : 1);
+    } else {
+        stopTimer();
+    }
+}
+
+static void armTimer(int i) {
+    static bool spiUsingInterrupt;
+    if (!spiUsingInterrupt) {
+        // DAC is written from the timer interrupt handler, and since it is not
+        // the pin interrupt, all interrupts are disabled during SPI transactions
+        SPI_usingInterrupt(0xFF);
+        spiUsingInterrupt = true;
+    }
+
+    noInterrupts();
+    g_execution[i].timerArmed = true;
+    scheduleTimer();
+    interrupts();
+}
+
+static void disarmTimers() {
+    noInterrupts();
+    for (int i = 0; i < CH_NUM; ++i) {
+        g_execution[i].timerArmed = false;
+    }
+    stopTimer();
+    interrupts();
+}
+
+/// Same as getStep with the DAC codes, but doesn't read from the file.
+static bool getTimerStep(int i, int32_t it, float &dwell, float &voltage, float &current, DacCodes &codes) {
+#if OPTION_SD_CARD
+    if (g_streams[i].length > 0) {
+        Step step;
+        if (!findStreamStep(i, it, step)) {
+            return false;
+        }
+        dwell = step.dwell;
+        voltage = step.voltage;
+        current = step.current;
+        codes = step.codes;
+        return true;
+    }
+#endif
+
+    return getStep(i, it, dwell, voltage, current, &codes, NULL);
+}
+
+/// Sets the next step from the timer interrupt. Everything which can't be
+/// done from the interrupt handler (end of the list, inhibit, reading the
+/// step from the file, current range switching) is left to the tick, i.e.
+/// timer is disarmed and tick sets the step as in the normal mode.
+static void setTimerStep(int i, uint32_t tick_usec) {
+    Channel &channel = Channel::get(i);
+
+    int32_t it = g_execution[i].it + 1;
+    bool repeat = it == maxListsSize(channel);
+    if (repeat) {
+        if (g_execution[i].counter == 1) {
+            g_execution[i].timerArmed = false;
+            return;
+        }
+        it = 0;
+    }
+
+    float dwell;
+    float voltage;
+    float current;
+    DacCodes codes;
+    if (io_pins::isInhibited() ||
+        !getTimerStep(i, it, dwell, voltage, current, codes) ||
+        channel.i.set != current && codes.currentRange != channel.flags.currentCurrentRange) {
+        g_execution[i].timerArmed = false;
+        return;
+    }
+
+    if (setCompiledStep(channel, voltage, current, codes)) {
+        // step over the limits is left to the tick, which reports the error
+        g_execution[i].timerArmed = false;
+        return;
+    }
+
+    updateJitter(i, tick_usec - g_execution[i].nextPointTime);
+
+    if (repeat && g_execution[i].counter > 0) {
+        --g_execution[i].counter;
+    }
+    g_execution[i].it = it;
+
+    g_execution[i].currentTotalDwellTime = dwell;
+    if (dwell > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
+        // counted in milliseconds by the tick
+        g_execution[i].currentRemainingDwellTime = (uint32_t)round(dwell * 1000L);
+        g_execution[i].nextPointTime = millis() + g_execution[i].currentRemainingDwellTime;
+        g_execution[i].timerArmed = false;
+    } else {
+        // next step is scheduled from the planned, not the actual time of this step,
+        // so the timing errors are not accumulated
+        g_execution[i].currentRemainingDwellTime = (uint32_t)round(dwell * 1000000L);
+        g_execution[i].nextPointTime += g_execution[i].currentRemainingDwellTime;
+    }
+}
+
+void onTimer() {
+    uint32_t tick_usec = micros();
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        if (g_execution[i].timerArmed && (int32_t)(tick_usec - g_execution[i].nextPointTime) >= 0) {
+            setTimerStep(i, tick_usec);
+        }
+    }
+
+    scheduleTimer();
+}
+
+#endif
+
+static void updateSkew(uint32_t skew) {
+    if (skew > g_skew.max) {
+        g_skew.max = skew;
+    }
+    g_skew.sum += skew;
+    ++g_skew.count;
+}
+
+/// Tick of the synchronized execution. Steps of all the channels which are
+/// due are looked up first and then set back-to-back, so the inter-channel
+/// skew is only the time needed to write the DACs.
+static void tickSynchronized(uint32_t tick_usec) {
+    // the same time is used for all the channels
+    uint32_t tick_msec = millis();
+
+    struct {
+        bool due;
+        bool first;
+        // step was counted in milliseconds
+        bool msec;
+        float dwell;
+        float voltage;
+        float current;
+        DacCodes codes;
+    } steps[CH_MAX];
+
+    bool anyDue = false;
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        steps[i].due = false;
+
+        if (g_execution[i].counter < 0) {
+            continue;
+        }
+
+        if (channel_dispatcher::isTripped(Channel::get(i))) {
+            abort();
+            return;
+        }
+
+        g_active = true;
+
+        steps[i].msec = g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS;
+        uint32_t tickCount = steps[i].msec ? tick_msec : tick_usec;
+
+        if (io_pins::isInhibited()) {
+            if (g_execution[i].it != -1) {
+                g_execution[i].nextPointTime += tickCount - g_execution[i].lastTickCount;
+            }
+        } else if (g_execution[i].it == -1) {
+            steps[i].due = true;
+        } else {
+            g_execution[i].currentRemainingDwellTime = g_execution[i].nextPointTime - tickCount;
+
+            if (g_execution[i].currentRemainingDwellTime <= 0) {
+                steps[i].due = true;
+
+                uint32_t jitter = -g_execution[i].currentRemainingDwellTime;
+                if (steps[i].msec) {
+                    jitter *= 1000;
+                }
+                updateJitter(i, jitter);
+            }
+        }
+
+        g_execution[i].lastTickCount = tickCount;
+
+        if (steps[i].due) {
+            steps[i].first = g_execution[i].it == -1;
+
+            if (!nextStep(i)) {
+                steps[i].due = false;
+                continue;
+            }
+
+            int err;
+            if (!getStep(i, g_execution[i].it, steps[i].dwell, steps[i].voltage, steps[i].current,
+                g_execution[i].compiled ? &steps[i].codes : NULL, &err)) {
+                generateError(err);
+                abort();
+                return;
+            }
+
+            anyDue = true;
+        }
+    }
+
+    if (!anyDue) {
+        return;
+    }
+
+    uint32_t firstSetTime = 0;
+    uint32_t lastSetTime = 0;
+    int numSet = 0;
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        if (!steps[i].due) {
+            continue;
+        }
+
+        Channel &channel = Channel::get(i);
+
+        lastSetTime = micros();
+        if (numSet++ == 0) {
+            firstSetTime = lastSetTime;
+        }
+
+        if (g_execution[i].compiled) {
+            int err = setCompiledStep(channel, steps[i].voltage, steps[i].current, steps[i].codes);
+            if (err) {
+                generateError(err);
+                abort();
+                return;
+            }
+        } else {
+            int err;
+            if (!setListValue(channel, g_execution[i].it, &err)) {
+                generateError(err);
+                abort();
+                return;
+            }
+        }
+    }
+
+    if (numSet > 1) {
+        updateSkew(lastSetTime - firstSetTime);
+    }
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        if (!steps[i].due) {
+            continue;
+        }
+
+        // next step is scheduled from the planned time of this step, so the
+        // channels with the same dwell times stay on the same timebase,
+        // unless this is the first step or the time unit is changed
+        g_execution[i].currentTotalDwellTime = steps[i].dwell;
+        if (steps[i].dwell > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
+            g_execution[i].currentRemainingDwellTime = (uint32_t)round(steps[i].dwell * 1000L);
+            uint32_t time = !steps[i].first && steps[i].msec ? g_execution[i].nextPointTime : tick_msec;
+            g_execution[i].nextPointTime = time + g_execution[i].currentRemainingDwellTime;
+            g_execution[i].lastTickCount = tick_msec;
+        } else {
+            g_execution[i].currentRemainingDwellTime = (uint32_t)round(steps[i].dwell * 1000000L);
+            uint32_t time = !steps[i].first && !steps[i].msec ? g_execution[i].nextPointTime : tick_usec;
+            g_execution[i].nextPointTime = time + g_execution[i].currentRemainingDwellTime;
+            g_execution[i].lastTickCount = tick_usec;
+        }
+    }
+}
+
 void tick(uint32_t tick_usec) {
 #if CONF_DEBUG_VARIABLES
     debug::g_listTickDuration.tick(tick_usec);
@@ -441,6 +1688,11 @@ void tick(uint32_t tick_usec) {
 
     g_active = false;
 
+    if (g_synchronized) {
+        tickSynchronized(tick_usec);
+        return;
+    }
+
     for (int i = 0; i < CH_NUM; ++i) {
         Channel &channel = Channel::get(i);
         if (g_execution[i].counter >= 0) {
@@ -460,6 +1712,15 @@ void tick(uint32_t tick_usec) {
                 tickCount = tick_usec;
             }
 
+#if CONF_LIST_TIMER
+            if (g_execution[i].timerArmed) {
+                // steps are set from the timer interrupt
+                g_execution[i].currentRemainingDwellTime = g_execution[i].nextPointTime - tickCount;
+                g_execution[i].lastTickCount = tickCount;
+                continue;
+            }
+#endif
+
             if (io_pins::isInhibited()) {
                 if (g_execution[i].it != -1) {
                     g_execution[i].nextPointTime += tickCount - g_execution[i].lastTickCount;
@@ -474,30 +1735,36 @@ void tick(uint32_t tick_usec) {
 
                     if (g_execution[i].currentRemainingDwellTime <= 0) {
                         set = true;
+
+                        uint32_t jitter = -g_execution[i].currentRemainingDwellTime;
+                        if (g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
+                            jitter *= 1000;
+                        }
+                        updateJitter(i, jitter);
                     }
                 }
 
                 if (set) {
-                    if (++g_execution[i].it == maxListsSize(channel)) {
-                        if (g_execution[i].counter > 0) {
-                            if (--g_execution[i].counter == 0) {
-                                g_execution[i].counter = -1;
-                                trigger::setTriggerFinished(channel);
-                                return;
-                            }
-                        }
-
-                        g_execution[i].it = 0;
+                    if (!nextStep(i)) {
+                        return;
                     }
 
                     int err;
-                    if (!setListValue(channel, g_execution[i].it, &err)) {
+                    bool result;
+                    if (g_execution[i].compiled) {
+                        result = setCompiledListValue(channel, g_execution[i].it, &err);
+                    } else {
+                        result = setListValue(channel, g_execution[i].it, &err);
+                    }
+                    if (!result) {
                         generateError(err);
                         abort();
                         return;
                     }
 
-                    g_execution[i].currentTotalDwellTime = g_channelsLists[i].dwellList[g_execution[i].it % g_channelsLists[i].dwellListLength];
+                    float voltage;
+                    float current;
+                    getStep(i, g_execution[i].it, g_execution[i].currentTotalDwellTime, voltage, current, NULL, NULL);
                     // if dwell time is greater then CONF_COUNTER_THRESHOLD_IN_SECONDS ...
                     if (g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
                         // ... then count in milliseconds
@@ -509,6 +1776,12 @@ void tick(uint32_t tick_usec) {
                         g_execution[i].nextPointTime = tick_usec + g_execution[i].currentRemainingDwellTime;
                     }
                 }
+
+#if CONF_LIST_TIMER
+                if (g_execution[i].timerMode && g_execution[i].currentTotalDwellTime <= CONF_COUNTER_THRESHOLD_IN_SECONDS) {
+                    armTimer(i);
+                }
+#endif
             }
 
             g_execution[i].lastTickCount = tickCount;
@@ -547,12 +1820,58 @@ bool getCurrentDwellTime(Channel &channel, int32_t &remaining, uint32_t &total)
     return false;
 }
 
+bool getJitter(Channel &channel, uint32_t &max, uint32_t &mean, uint32_t &count, uint32_t *histogram) {
+    int i = channel.index - 1;
+
+    // statistics are updated from the timer interrupt
+    noInterrupts();
+
+    bool result = g_execution[i].jitterCount > 0;
+    if (result) {
+        max = g_execution[i].jitterMax;
+        mean = (uint32_t)(g_execution[i].jitterSum / g_execution[i].jitterCount);
+        count = g_execution[i].jitterCount;
+        memcpy(histogram, g_execution[i].jitterHistogram, sizeof(g_execution[i].jitterHistogram));
+    }
+
+    interrupts();
+
+    return result;
+}
+
+bool getSkew(uint32_t &max, uint32_t &mean, uint32_t &count) {
+    if (g_skew.count == 0) {
+        return false;
+    }
+
+    max = g_skew.max;
+    mean = (uint32_t)(g_skew.sum / g_skew.count);
+    count = g_skew.count;
+
+    return true;
+}
+
 void abort() {
+#if CONF_LIST_TIMER
+    disarmTimers();
+#endif
+
     for (int i = 0; i < CH_NUM; ++i) {
         g_execution[i].counter = -1;
+#if OPTION_SD_CARD
+        closeStream(i);
+#endif
     }
 }
 
 }
 }
-} // namespace eez::psu::list
\ No newline at end of file
+} // namespace eez::psu::list
+
+#if CONF_LIST_TIMER && !defined(EEZ_PSU_SIMULATOR)
+// timer ISR TC1 ch 1
+void TC4_Handler(void) {
+    TC_GetStatus(LIST_TIMER, LIST_TIMER_CHANNEL);
+    eez::psu::list::onTimer();
+}
+#endif
\ No newline at end of file
@@ -24,6 +24,43 @@ namespace list {
 
 static const char *LIST_EXT = ".list";
 
+/// Bin 0 counts the steps set on time, bin n the steps set
+/// 2^(n-1) to 2^n - 1 microseconds late and the last bin all the later ones.
+static const int JITTER_HISTOGRAM_SIZE = 16;
+
+/// Shapes of the procedural waveform, all of them swing between
+/// offset - amplitude and offset + amplitude.
+enum FunctionShape {
+    /// Voltage and current lists are used.
+    FUNCTION_NONE,
+    FUNCTION_SINE,
+    /// First half of the points at the high level, second half at the low level.
+    FUNCTION_SQUARE,
+    /// Sawtooth from the low to the high level.
+    FUNCTION_RAMP,
+    /// LIST_FUNCTION_STAIR_STEPS equal steps from the low to the high level and back down.
+    FUNCTION_STAIR,
+    /// Exponential rise from the low to the high level.
+    FUNCTION_EXPONENTIAL
+};
+
+enum FunctionTarget {
+    FUNCTION_TARGET_VOLTAGE,
+    FUNCTION_TARGET_CURRENT
+};
+
+/// Procedural waveform used instead of the voltage or current list.
+/// Points are computed when the step is set, dwell time of each point is
+/// period / points and the other (not target) value is taken from its list.
+struct Function {
+    FunctionShape shape;
+    FunctionTarget target;
+    float amplitude;
+    float offset;
+    float period;
+    uint32_t points;
+};
+
 void init();
 
 void resetChannelList(Channel &channel);
@@ -38,9 +75,30 @@ float *getVoltageList(Channel &channel, uint16_t *listLength);
 void setCurrentList(Channel &channel, float *list, uint16_t listLength);
 float *getCurrentList(Channel &channel, uint16_t *listLength);
 
+/// Sets the list directly from the block of big-endian or little-endian float32 values.
+void setDwellListFromBlock(Channel &channel, const uint8_t *block, uint16_t listLength, bool bigEndian);
+void setVoltageListFromBlock(Channel &channel, const uint8_t *block, uint16_t listLength, bool bigEndian);
+void setCurrentListFromBlock(Channel &channel, const uint8_t *block, uint16_t listLength, bool bigEndian);
+
+void setFunction(Channel &channel, const Function &function);
+void getFunction(Channel &channel, Function &function);
+float getFunctionValue(const Function &function, uint32_t point);
+
 bool getListsChanged(Channel &channel);
 void setListsChanged(Channel &channel, bool changed);
 
+/// In the timer mode list steps are set from the hardware timer interrupt,
+/// at the scheduled time, instead of from the main loop.
+void setTimerMode(Channel &channel, bool enable);
+bool getTimerMode(Channel &channel);
+
+/// In the synchronized mode lists of all the channels are executed on the
+/// one timebase: steps which are due in the same tick are set back-to-back
+/// and the next steps are scheduled from the planned, not the actual time.
+/// Timer mode is not used in this mode.
+void setSynchronized(bool enable);
+bool isSynchronized();
+
 uint16_t getListCount(Channel &channel);
 void setListCount(Channel &channel, uint16_t value);
 
@@ -55,6 +113,9 @@ bool areVoltageAndCurrentListLengthsEquivalent(Channel &channel);
 
 int checkLimits(int iChannel);
 
+/// Loads the list from the CSV or binary list file. List longer than
+/// MAX_LIST_LENGTH is not loaded into RAM, but streamed from the file
+/// while it is executed.
 bool loadList(Channel &channel, const char *filePath, int *err);
 bool saveList(Channel &channel, const char *filePath, int *err);
 
@@ -62,15 +123,35 @@ void executionStart(Channel &channel);
 
 int maxListsSize(Channel &channel);
 
-bool setListValue(Channel &channel, int16_t it, int *err);
+bool setListValue(Channel &channel, int32_t it, int *err);
 
 void tick(uint32_t tick_usec);
 
+#if CONF_LIST_TIMER
+/// List timer interrupt handler.
+void onTimer();
+#endif
+
+#if OPTION_SD_CARD
+/// Reads the next steps of the streamed lists from the files.
+void fillStreams(uint32_t tick_usec);
+#endif
+
 bool isActive();
 
 bool anyCounterVisible(uint32_t totalThreshold);
 bool getCurrentDwellTime(Channel &channel, int32_t &remaining, uint32_t &total);
 
+/// Step jitter of the current or last list execution, i.e. how late the
+/// steps were set (in microseconds), and the histogram of JITTER_HISTOGRAM_SIZE
+/// bins. Returns false if no step is set yet.
+bool getJitter(Channel &channel, uint32_t &max, uint32_t &mean, uint32_t &count, uint32_t *histogram);
+
+/// Inter-channel skew of the synchronized execution, i.e. time between
+/// setting the first and the last channel of the same step (in microseconds).
+/// Returns false if no step is set on more than one channel yet.
+bool getSkew(uint32_t &max, uint32_t &mean, uint32_t &count);
+
 void abort();
 
 }
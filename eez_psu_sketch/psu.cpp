@@ -64,8 +64,12 @@
 #include "channel_dispatcher.h"
 #include "trigger.h"
 #include "list.h"
+#include "sequencer.h"
+#include "threshold.h"
 #include "io_pins.h"
 #include "idle.h"
+#include "scheduler.h"
+#include "stream.h"
 
 namespace eez {
 namespace psu {
@@ -89,8 +93,6 @@ RLState g_rlState = RL_STATE_LOCAL;
 
 bool g_rprogAlarm = false;
 
-static uint32_t g_mainLoopCounter;
-
 ////////////////////////////////////////////////////////////////////////////////
 
 static bool testShield();
@@ -102,6 +104,8 @@ static void updateMasterSync();
 
 static void psuRegSet(scpi_psu_reg_name_t name, scpi_reg_val_t val);
 
+static void initScheduler();
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void loadConf() {
@@ -175,6 +179,9 @@ void init() {
 	temperature::init();
 
     trigger::init();
+    sequencer::init();
+
+    initScheduler();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -318,7 +325,9 @@ static bool psuReset() {
 
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        scpi::resetContext(&ethernet::g_scpiContext);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            scpi::resetContext(&ethernet::g_scpiContext[i]);
+        }
 	}
 
     ntp::reset();
@@ -356,6 +365,12 @@ static bool psuReset() {
     //
     list::reset();
 
+    //
+    sequencer::reset();
+
+    //
+    threshold::reset();
+
 	//
 #if OPTION_SD_CARD
 	dlog::reset();
@@ -659,6 +674,7 @@ void powerDown() {
     if (!g_powerIsUp) return;
 
     trigger::abort();
+    sequencer::abort();
 #if OPTION_SD_CARD
 	dlog::abort();
 #endif
@@ -803,153 +819,195 @@ void onProtectionTripped() {
 ////////////////////////////////////////////////////////////////////////////////
 
 void tick() {
-    ++g_mainLoopCounter;
-
     if (g_powerDownOnNextTick) {
         g_powerDownOnNextTick = false;
         powerDownBySensor();
     }
 
-	uint32_t tick_usec = criticalTick(-1);
+    scheduler::tick(micros());
+}
 
-#if CONF_DEBUG
-    debug::tick(tick_usec);
-#endif
+uint32_t criticalTick(int pageId) {
+    uint32_t tick_usec = micros();
 
-	g_powerOnTimeCounter.tick(tick_usec);
+    scheduler::yield(tick_usec);
 
-	temperature::tick(tick_usec);
+#if OPTION_DISPLAY
+    if (pageId != -1) {
+        return gui::isActivePage(pageId);
+    }
+#endif
 
-	fan::tick(tick_usec);
+    return tick_usec;
+}
 
-    ////dummy eeprom read
-    //uint8_t buf[128];
-    //eeprom::read(buf, 128, 512);
+////////////////////////////////////////////////////////////////////////////////
+// scheduler tasks
 
+static void channelsTask(uint32_t tick_usec) {
     for (int i = 0; i < CH_NUM; ++i) {
         Channel::get(i).tick(tick_usec);
     }
+}
 
-    trigger::tick(tick_usec);
-
-    list::tick(tick_usec);
-
-	event_queue::tick(tick_usec);
+static void adcTask(uint32_t tick_usec) {
+    if (g_powerIsUp) {
+        channelsTask(tick_usec);
+    }
+}
 
-    // if we move this, for example, after ethernet::tick we could get
-    // (in certain situations, see #25) PWRGOOD error on channel after
-    // the "pow:syst 1" command is executed 
-	sound::tick(tick_usec);
+static void listTask(uint32_t tick_usec) {
+    if (g_powerIsUp && list::isActive()) {
+        list::tick(tick_usec);
+        io_pins::tick(tick_usec);
+    }
+}
 
-    profile::tick(tick_usec);
+#if OPTION_SD_CARD
+static void listStreamTask(uint32_t tick_usec) {
+    // streams are also prefilled before the execution
+    if (g_powerIsUp) {
+        list::fillStreams(tick_usec);
+    }
+}
+#endif
 
-    serial::tick(tick_usec);
+static void triggerTask(uint32_t tick_usec) {
+    trigger::tick(tick_usec);
+    if (g_powerIsUp) {
+        sequencer::tick(tick_usec);
+    }
+}
 
-    datetime::tick(tick_usec);
+static void ioPinsTask(uint32_t tick_usec) {
+    if (g_powerIsUp) {
+        io_pins::tick(tick_usec);
+    }
+}
 
-#if OPTION_ETHERNET
-    if (g_mainLoopCounter % 2 == 0) {
-        // tick ethernet every other time
-	    ethernet::tick(tick_usec);
-    } else {
-	    ntp::tick(tick_usec);
+#if OPTION_SD_CARD
+static void dlogTask(uint32_t tick_usec) {
+    if (g_powerIsUp) {
+        dlog::tick(tick_usec);
     }
+}
 #endif
 
-    idle::tick();
-    
 #if OPTION_DISPLAY
+static void touchTask(uint32_t tick_usec) {
 #ifdef EEZ_PSU_SIMULATOR
-    if (simulator::front_panel::isOpened()) {
+    if (!simulator::front_panel::isOpened()) {
+        return;
+    }
 #endif
-        gui::touch::tick(tick_usec);
-        gui::touchHandling(tick_usec);
+    gui::touch::tick(tick_usec);
+    gui::touchHandling(tick_usec);
+}
 
-        if (g_mainLoopCounter % 2 == 1) {
-            // tick gui every other time
-            tick_usec = micros();
-            gui::tick(tick_usec);
-        }
+static void guiTask(uint32_t tick_usec) {
 #ifdef EEZ_PSU_SIMULATOR
+    if (!simulator::front_panel::isOpened()) {
+        return;
     }
 #endif
+    gui::tick(tick_usec);
+}
 #endif
 
+static void onTimeTask(uint32_t tick_usec) {
+	g_powerOnTimeCounter.tick(tick_usec);
+}
+
+static void idleTask(uint32_t tick_usec) {
+    idle::tick();
+}
+
 #if (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12) && OPTION_SYNC_MASTER && !defined(EEZ_PSU_SIMULATOR)
+static void masterSyncTask(uint32_t tick_usec) {
 	updateMasterSync();
+}
 #endif
 
-#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
-    watchdog::tick(tick_usec);
-#endif
+static bool isListActive() {
+    return g_powerIsUp && list::isActive();
 }
 
-uint32_t criticalTick(int pageId) {
-    uint32_t tick_usec = micros();
-
-    if (!g_powerIsUp) {
-        return tick_usec;
-    }
-
-    static uint32_t lastTickList = 0;
-    if (list::isActive()) {
-        if (lastTickList == 0) {
-            lastTickList = tick_usec;
-        } else if (tick_usec - lastTickList >= 250) {
-            lastTickList = tick_usec;
-            list::tick(tick_usec);
-            io_pins::tick(tick_usec);
-        }
-    } else {
-        lastTickList = 0;
-    }
+static bool isTriggerActive() {
+    return !trigger::isIdle() || sequencer::isRunning();
+}
 
 #if OPTION_SD_CARD
-	dlog::tick(tick_usec);
+static bool isDlogActive() {
+    return g_powerIsUp && !dlog::isIdle();
+}
 #endif
 
-    static uint32_t lastTickAdc = 0;
-    if (lastTickAdc == 0) {
-        lastTickAdc = tick_usec;
-    } else if (tick_usec - lastTickAdc >= ADC_READ_TIME_US / 2) {
-        lastTickAdc = tick_usec;
-
-        for (int i = 0; i < CH_NUM; ++i) {
-            Channel::get(i).tick(tick_usec);
-        }
-    }
+#if OPTION_DISPLAY && defined(EEZ_PSU_SIMULATOR)
+static bool isFrontPanelOpened() {
+    return simulator::front_panel::isOpened();
+}
+#endif
 
-    static uint32_t lastTickIoPins = 0;
-    if (lastTickIoPins == 0) {
-        lastTickIoPins = tick_usec;
-    } else if (tick_usec - lastTickIoPins >= 1000) {
-        lastTickIoPins = tick_usec;
-        io_pins::tick(tick_usec);
-    }
+static void initScheduler() {
+    using namespace scheduler;
 
+    // time critical tasks, also executed from inside of the long running tasks (see criticalTick)
+    addTask("list", listTask, PRIORITY_CRITICAL, 250, 100, isListActive);
+    // triggered sequence is started from here (after the delay), so the latency
+    // from the PIN1 edge doesn't depend on the long running tasks,
+    // trigger sequencer steps are also executed from here
+    addTask("trigger", triggerTask, PRIORITY_CRITICAL, 0, 0, isTriggerActive);
+#if OPTION_SD_CARD
+    addTask("dlog", dlogTask, PRIORITY_CRITICAL, 0, 2000, isDlogActive);
+#endif
+    addTask("adc", adcTask, PRIORITY_CRITICAL, ADC_READ_TIME_US / 2, 200, isPowerUp);
+    addTask("io_pins", ioPinsTask, PRIORITY_CRITICAL, 1000, 50, isPowerUp);
 #if OPTION_DISPLAY
-    static uint32_t lastTickTouch = 0;
 #ifdef EEZ_PSU_SIMULATOR
-    if (simulator::front_panel::isOpened()) {
+    addTask("touch", touchTask, PRIORITY_CRITICAL, 5000, 500, isFrontPanelOpened);
+#else
+    addTask("touch", touchTask, PRIORITY_CRITICAL, 5000, 500);
 #endif
-        if (lastTickTouch == 0) {
-            lastTickTouch = tick_usec;
-        } else if (tick_usec - lastTickTouch >= 5000) {
-            lastTickTouch = tick_usec;
-            gui::touch::tick(tick_usec);
-            gui::touchHandling(tick_usec);
-        }
-#ifdef EEZ_PSU_SIMULATOR
-    }
 #endif
 
+    // executed once per main loop pass
+#if CONF_DEBUG
+    addTask("debug", debug::tick, PRIORITY_NORMAL, 0, 0);
+#endif
+    addTask("ontime", onTimeTask, PRIORITY_NORMAL, 0, 0);
+	addTask("temperature", temperature::tick, PRIORITY_NORMAL, 0, 0);
+	addTask("fan", fan::tick, PRIORITY_NORMAL, 0, 0);
+    addTask("channels", channelsTask, PRIORITY_NORMAL, 0, 0);
+#if OPTION_SD_CARD
+    addTask("list_stream", listStreamTask, PRIORITY_NORMAL, 0, 0);
+#endif
+	addTask("event_queue", event_queue::tick, PRIORITY_NORMAL, 0, 0);
+    // if we move this, for example, after ethernet::tick we could get
+    // (in certain situations, see #25) PWRGOOD error on channel after
+    // the "pow:syst 1" command is executed 
+	addTask("sound", sound::tick, PRIORITY_NORMAL, 0, 0);
+    addTask("profile", profile::tick, PRIORITY_NORMAL, 0, 0);
+    addTask("serial", serial::tick, PRIORITY_NORMAL, 0, 0);
+    addTask("stream", stream::tick, PRIORITY_NORMAL, 0, 0);
+    addTask("datetime", datetime::tick, PRIORITY_NORMAL, 0, 0);
+#if OPTION_ETHERNET
+	addTask("ntp", ntp::tick, PRIORITY_NORMAL, 0, 0);
+#endif
+    addTask("idle", idleTask, PRIORITY_NORMAL, 0, 0);
+#if (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12) && OPTION_SYNC_MASTER && !defined(EEZ_PSU_SIMULATOR)
+    addTask("master_sync", masterSyncTask, PRIORITY_NORMAL, 0, 0);
+#endif
+#if OPTION_WATCHDOG && (EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12)
+    addTask("watchdog", watchdog::tick, PRIORITY_NORMAL, 0, 0);
 #endif
 
-    if (pageId != -1) {
-        return gui::isActivePage(pageId);
-    }
-
-    return tick_usec;
+    // long running tasks, only one of these is executed per main loop pass
+#if OPTION_ETHERNET
+	addTask("ethernet", ethernet::tick, PRIORITY_LOW, 0, 5000);
+#endif
+#if OPTION_DISPLAY
+    addTask("gui", guiTask, PRIORITY_LOW, 0, 20000);
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -960,7 +1018,9 @@ void regSet(scpi_reg_name_t name, scpi_reg_val_t val) {
     }
 #if OPTION_ETHERNET
 	if (ethernet::g_testResult == TEST_OK) {
-        SCPI_RegSet(&ethernet::g_scpiContext, name, val);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            SCPI_RegSet(&ethernet::g_scpiContext[i], name, val);
+        }
 	}
 #endif
 }
@@ -971,7 +1031,9 @@ void psuRegSet(scpi_psu_reg_name_t name, scpi_reg_val_t val) {
     }
 #if OPTION_ETHERNET
 	if (ethernet::g_testResult == TEST_OK) {
-        reg_set(&ethernet::g_scpiContext, name, val);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            reg_set(&ethernet::g_scpiContext[i], name, val);
+        }
 	}
 #endif
 }
@@ -982,7 +1044,9 @@ void setEsrBits(int bit_mask) {
     }
 #if OPTION_ETHERNET
 	if (ethernet::g_testResult == TEST_OK) {
-        SCPI_RegSetBits(&ethernet::g_scpiContext, SCPI_REG_ESR, bit_mask);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            SCPI_RegSetBits(&ethernet::g_scpiContext[i], SCPI_REG_ESR, bit_mask);
+        }
 	}
 #endif
 }
@@ -994,7 +1058,9 @@ void setQuesBits(int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
 	if (ethernet::g_testResult == TEST_OK) {
-        reg_set_ques_bit(&ethernet::g_scpiContext, bit_mask, on);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            reg_set_ques_bit(&ethernet::g_scpiContext[i], bit_mask, on);
+        }
 	}
 #endif
 }
@@ -1005,7 +1071,9 @@ void setOperBits(int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
 	if (ethernet::g_testResult == TEST_OK) {
-        reg_set_oper_bit(&ethernet::g_scpiContext, bit_mask, on);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            reg_set_oper_bit(&ethernet::g_scpiContext[i], bit_mask, on);
+        }
 	}
 #endif
 }
@@ -1016,7 +1084,9 @@ void generateError(int16_t error) {
     }
 #if OPTION_ETHERNET
 	if (ethernet::g_testResult == TEST_OK) {
-        SCPI_ErrorPush(&ethernet::g_scpiContext, error);
+        for (int i = 0; i < ETHERNET_MAX_CLIENTS; ++i) {
+            SCPI_ErrorPush(&ethernet::g_scpiContext[i], error);
+        }
     }
 #endif
 	event_queue::pushEvent(error);
@@ -0,0 +1,243 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "psu.h"
+#include "scheduler.h"
+
+namespace eez {
+namespace psu {
+namespace scheduler {
+
+static Task g_tasks[MAX_TASKS];
+static int g_numTasks;
+static bool g_insideYield;
+static Histogram g_mainLoopDurations;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Histogram::reset() {
+    for (int i = 0; i < NUM_HISTOGRAM_BUCKETS; ++i) {
+        buckets[i] = 0;
+    }
+    max = 0;
+}
+
+void Histogram::add(uint32_t duration) {
+    int i = 0;
+    for (uint32_t value = duration; value > 0 && i < NUM_HISTOGRAM_BUCKETS - 1; value >>= 1) {
+        ++i;
+    }
+
+    if (buckets[i] == 0xFFFF) {
+        // halve all the buckets, this keeps the distribution and gives
+        // more weight to the recent durations
+        for (int j = 0; j < NUM_HISTOGRAM_BUCKETS; ++j) {
+            buckets[j] >>= 1;
+        }
+    }
+    ++buckets[i];
+
+    if (duration > max) {
+        max = duration;
+    }
+}
+
+uint32_t Histogram::getPercentile(int percentile) {
+    uint32_t total = 0;
+    for (int i = 0; i < NUM_HISTOGRAM_BUCKETS; ++i) {
+        total += buckets[i];
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    uint32_t threshold = (total * percentile + 99) / 100;
+    uint32_t sum = 0;
+    for (int i = 0; i < NUM_HISTOGRAM_BUCKETS - 1; ++i) {
+        sum += buckets[i];
+        if (sum >= threshold) {
+            uint32_t upperBound = (1UL << i) - 1;
+            return upperBound < max ? upperBound : max;
+        }
+    }
+
+    return max;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int addTask(const char *name, TaskFunction function, Priority priority, uint32_t period, uint32_t budget, IsActiveFunction isActive) {
+    if (g_numTasks == MAX_TASKS) {
+        DebugTraceF("Scheduler: no room for task %s, increase MAX_TASKS", name);
+        ::abort();
+    }
+
+    Task &task = g_tasks[g_numTasks];
+
+    task.name = name;
+    task.function = function;
+    task.priority = priority;
+    task.period = period;
+    task.budget = budget;
+    task.isActive = isActive;
+
+    task.nextTime = micros();
+    task.lastDuration = 0;
+    task.numOverruns = 0;
+    task.durations.reset();
+
+    return g_numTasks++;
+}
+
+static bool isDue(Task &task, uint32_t tick_usec) {
+    return (int32_t)(tick_usec - task.nextTime) >= 0;
+}
+
+static bool isActive(Task &task) {
+    return !task.isActive || task.isActive();
+}
+
+/// Finds due task, with the given priority, with the earliest deadline.
+/// Tasks from the excluded bit mask are skipped.
+static int findNextTask(Priority priority, uint32_t tick_usec, uint32_t excluded) {
+    int next = -1;
+
+    for (int i = 0; i < g_numTasks; ++i) {
+        Task &task = g_tasks[i];
+        if (task.priority == priority && !(excluded & (1UL << i)) && isDue(task, tick_usec) && isActive(task)) {
+            if (next == -1 || (int32_t)(task.nextTime - g_tasks[next].nextTime) < 0) {
+                next = i;
+            }
+        }
+    }
+
+    return next;
+}
+
+static void execute(Task &task) {
+    uint32_t startTime = micros();
+
+    task.function(startTime);
+
+    uint32_t duration = micros() - startTime;
+    task.lastDuration = duration;
+    task.durations.add(duration);
+    if (task.budget > 0 && duration > task.budget) {
+        ++task.numOverruns;
+    }
+
+    if (task.period == 0 || startTime - task.nextTime >= task.period) {
+        // task is late more than one period, don't try to catch up
+        task.nextTime = startTime + task.period;
+    } else {
+        task.nextTime += task.period;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void tick(uint32_t tick_usec) {
+    uint32_t startTime = tick_usec;
+    uint32_t executed = 0;
+
+    int i;
+    while ((i = findNextTask(PRIORITY_NORMAL, tick_usec, executed)) != -1) {
+        executed |= 1UL << i;
+
+        yield(tick_usec);
+
+        execute(g_tasks[i]);
+        tick_usec = micros();
+    }
+
+    i = findNextTask(PRIORITY_LOW, tick_usec, 0);
+    if (i != -1) {
+        yield(tick_usec);
+
+        execute(g_tasks[i]);
+    }
+
+    g_mainLoopDurations.add(micros() - startTime);
+}
+
+void yield(uint32_t tick_usec) {
+    if (g_insideYield) {
+        return;
+    }
+
+    g_insideYield = true;
+
+    uint32_t executed = 0;
+
+    int i;
+    while ((i = findNextTask(PRIORITY_CRITICAL, tick_usec, executed)) != -1) {
+        executed |= 1UL << i;
+        execute(g_tasks[i]);
+    }
+
+    g_insideYield = false;
+}
+
+bool getNextDeadline(uint32_t &deadline) {
+    bool found = false;
+
+    for (int i = 0; i < g_numTasks; ++i) {
+        Task &task = g_tasks[i];
+
+        uint32_t taskDeadline;
+        if (task.period > 0) {
+            if (!isActive(task)) {
+                continue;
+            }
+            taskDeadline = task.nextTime;
+        } else {
+            if (!task.isActive || !task.isActive()) {
+                continue;
+            }
+            // nextTime of the polling task is the time of its last execution
+            taskDeadline = task.nextTime + POLLING_PERIOD;
+        }
+
+        if (!found || (int32_t)(taskDeadline - deadline) < 0) {
+            deadline = taskDeadline;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+int getNumTasks() {
+    return g_numTasks;
+}
+
+Task *getTask(int taskIndex) {
+    return &g_tasks[taskIndex];
+}
+
+Histogram &getMainLoopDurations() {
+    return g_mainLoopDurations;
+}
+
+
+}
+}
+} // namespace eez::psu::scheduler
@@ -0,0 +1,105 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace eez {
+namespace psu {
+/// Cooperative, deadline driven task scheduler used by the main loop.
+namespace scheduler {
+
+/// Maximum number of tasks that can be registered, at most 32 because
+/// the executed tasks are tracked in the 32-bit mask during one pass.
+static const int MAX_TASKS = 32;
+
+enum Priority {
+    /// Executed at every yield point (see psu::criticalTick), i.e. also
+    /// from inside of the long running normal and low priority tasks.
+    PRIORITY_CRITICAL,
+    /// Executed once per main loop pass when due.
+    PRIORITY_NORMAL,
+    /// At most one low priority task is executed per main loop pass.
+    PRIORITY_LOW
+};
+
+/// Number of buckets in the duration histogram. Bucket i holds durations
+/// from 2^(i-1) to 2^i - 1 microseconds, the last one also all the longer ones.
+static const int NUM_HISTOGRAM_BUCKETS = 24;
+
+/// Log scale histogram of the durations measured in microseconds.
+struct Histogram {
+    uint16_t buckets[NUM_HISTOGRAM_BUCKETS];
+    uint32_t max;
+
+    void reset();
+    void add(uint32_t duration);
+    /// Returns the upper bound of the bucket which contains given percentile.
+    uint32_t getPercentile(int percentile);
+};
+
+typedef void (*TaskFunction)(uint32_t tick_usec);
+typedef bool (*IsActiveFunction)();
+
+/// While active, polling tasks (period 0) need one main loop pass
+/// at least this often, in microseconds (see getNextDeadline).
+static const uint32_t POLLING_PERIOD = 1000;
+
+struct Task {
+    const char *name;
+    TaskFunction function;
+    Priority priority;
+    /// Period in microseconds, 0 means execute on every pass.
+    uint32_t period;
+    /// Expected max. execution time in microseconds, 0 means no budget.
+    uint32_t budget;
+    /// Task is skipped while this returns false, 0 means always active.
+    IsActiveFunction isActive;
+
+    uint32_t nextTime;
+    uint32_t lastDuration;
+    uint32_t numOverruns;
+    Histogram durations;
+};
+
+/// All the tasks are registered at boot, so running out of the task slots
+/// is a firmware configuration error and it stops the firmware.
+int addTask(const char *name, TaskFunction function, Priority priority, uint32_t period, uint32_t budget, IsActiveFunction isActive = 0);
+
+/// Executes one main loop pass: all due normal tasks and one due low
+/// priority task in the order of their deadlines. Critical tasks are
+/// given a chance to run before each of them.
+void tick(uint32_t tick_usec);
+
+/// Executes all due critical tasks.
+void yield(uint32_t tick_usec);
+
+/// Returns false if nothing has to be executed at the particular time,
+/// otherwise the earliest deadline of the active periodic tasks and
+/// of the polling tasks which have the isActive function and are active.
+/// Other polling tasks are only executed when the main loop runs anyway.
+bool getNextDeadline(uint32_t &deadline);
+
+int getNumTasks();
+Task *getTask(int taskIndex);
+
+/// Histogram of the complete main loop pass durations.
+Histogram &getMainLoopDurations();
+
+}
+}
+} // namespace eez::psu::scheduler
@@ -55,6 +55,7 @@
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:ADC?", scpi_cmd_diagnosticInformationAdcQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:CALibration?", scpi_cmd_diagnosticInformationCalibrationQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:FAN?", scpi_cmd_diagnosticInformationFanQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROFile?", scpi_cmd_diagnosticInformationProfileQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROTection?", scpi_cmd_diagnosticInformationProtectionQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:TEST?", scpi_cmd_diagnosticInformationTestQ) \
     SCPI_COMMAND("DISPlay:BRIGhtness", scpi_cmd_displayBrightness) \
@@ -66,6 +67,10 @@
     SCPI_COMMAND("DISPlay[:WINdow]:TEXT?", scpi_cmd_displayWindowTextQ) \
     SCPI_COMMAND("DISPlay[:WINdow][:STATe]", scpi_cmd_displayWindowState) \
     SCPI_COMMAND("DISPlay[:WINdow][:STATe]?", scpi_cmd_displayWindowStateQ) \
+    SCPI_COMMAND("FORMat:BORDer", scpi_cmd_formatBorder) \
+    SCPI_COMMAND("FORMat:BORDer?", scpi_cmd_formatBorderQ) \
+    SCPI_COMMAND("FORMat[:DATA]", scpi_cmd_formatData) \
+    SCPI_COMMAND("FORMat[:DATA]?", scpi_cmd_formatDataQ) \
     SCPI_COMMAND("INITiate:CONTinuous", scpi_cmd_initiateContinuous) \
     SCPI_COMMAND("INITiate:CONTinuous?", scpi_cmd_initiateContinuousQ) \
     SCPI_COMMAND("INITiate[:IMMediate]", scpi_cmd_initiateImmediate) \
@@ -130,20 +135,40 @@
     SCPI_COMMAND("OUTPut:PROTection:COUPle?", scpi_cmd_outputProtectionCoupleQ) \
     SCPI_COMMAND("OUTPut:TRACk[:STATe]", scpi_cmd_outputTrackState) \
     SCPI_COMMAND("OUTPut:TRACk[:STATe]?", scpi_cmd_outputTrackStateQ) \
+    SCPI_COMMAND("SENSe:AVERage:COUNt", scpi_cmd_senseAverageCount) \
+    SCPI_COMMAND("SENSe:AVERage:COUNt?", scpi_cmd_senseAverageCountQ) \
+    SCPI_COMMAND("SENSe:AVERage:TCONtrol", scpi_cmd_senseAverageTcontrol) \
+    SCPI_COMMAND("SENSe:AVERage:TCONtrol?", scpi_cmd_senseAverageTcontrolQ) \
     SCPI_COMMAND("SENSe:CURRent[:DC]:RANGe:AUTO", scpi_cmd_senseCurrentDcRangeAuto) \
     SCPI_COMMAND("SENSe:CURRent[:DC]:RANGe:AUTO?", scpi_cmd_senseCurrentDcRangeAutoQ) \
     SCPI_COMMAND("SENSe:CURRent[:DC]:RANGe[:UPPer]", scpi_cmd_senseCurrentDcRangeUpper) \
     SCPI_COMMAND("SENSe:CURRent[:DC]:RANGe[:UPPer]?", scpi_cmd_senseCurrentDcRangeUpperQ) \
+    SCPI_COMMAND("SENSe:DLOG:COMPression", scpi_cmd_senseDlogCompression) \
+    SCPI_COMMAND("SENSe:DLOG:COMPression?", scpi_cmd_senseDlogCompressionQ) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:CURRent", scpi_cmd_senseDlogFunctionCurrent) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:CURRent?", scpi_cmd_senseDlogFunctionCurrentQ) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:VOLTage", scpi_cmd_senseDlogFunctionVoltage) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:VOLTage?", scpi_cmd_senseDlogFunctionVoltageQ) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:POWer", scpi_cmd_senseDlogFunctionPower) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:POWer?", scpi_cmd_senseDlogFunctionPowerQ) \
+    SCPI_COMMAND("SENSe:DLOG:MODE", scpi_cmd_senseDlogMode) \
+    SCPI_COMMAND("SENSe:DLOG:MODE?", scpi_cmd_senseDlogModeQ) \
     SCPI_COMMAND("SENSe:DLOG:PERiod", scpi_cmd_senseDlogPeriod) \
     SCPI_COMMAND("SENSe:DLOG:PERiod?", scpi_cmd_senseDlogPeriodQ) \
+    SCPI_COMMAND("SENSe:DLOG:PRETrigger", scpi_cmd_senseDlogPreTrigger) \
+    SCPI_COMMAND("SENSe:DLOG:PRETrigger?", scpi_cmd_senseDlogPreTriggerQ) \
     SCPI_COMMAND("SENSe:DLOG:TIME", scpi_cmd_senseDlogTime) \
     SCPI_COMMAND("SENSe:DLOG:TIME?", scpi_cmd_senseDlogTimeQ) \
+    SCPI_COMMAND("SEQuencer:ABORt", scpi_cmd_sequencerAbort) \
+    SCPI_COMMAND("SEQuencer:CLEar", scpi_cmd_sequencerClear) \
+    SCPI_COMMAND("SEQuencer:INITiate", scpi_cmd_sequencerInitiate) \
+    SCPI_COMMAND("SEQuencer:STATe?", scpi_cmd_sequencerStateQ) \
+    SCPI_COMMAND("SEQuencer:STEP#:ACTion", scpi_cmd_sequencerStepAction) \
+    SCPI_COMMAND("SEQuencer:STEP#:ACTion?", scpi_cmd_sequencerStepActionQ) \
+    SCPI_COMMAND("SEQuencer:STEP#:NEXT", scpi_cmd_sequencerStepNext) \
+    SCPI_COMMAND("SEQuencer:STEP#:NEXT?", scpi_cmd_sequencerStepNextQ) \
+    SCPI_COMMAND("SEQuencer:STEP#:WAIT", scpi_cmd_sequencerStepWait) \
+    SCPI_COMMAND("SEQuencer:STEP#:WAIT?", scpi_cmd_sequencerStepWaitQ) \
     SCPI_COMMAND("[SOURce#]:CURRent:LIMit[:POSitive][:IMMediate][:AMPLitude]", scpi_cmd_sourceCurrentLimitPositiveImmediateAmplitude) \
     SCPI_COMMAND("[SOURce#]:CURRent:LIMit[:POSitive][:IMMediate][:AMPLitude]?", scpi_cmd_sourceCurrentLimitPositiveImmediateAmplitudeQ) \
     SCPI_COMMAND("[SOURce#]:CURRent:MODE", scpi_cmd_sourceCurrentMode) \
@@ -165,6 +190,24 @@
     SCPI_COMMAND("[SOURce#]:LIST:CURRent[:LEVel]?", scpi_cmd_sourceListCurrentLevelQ) \
     SCPI_COMMAND("[SOURce#]:LIST:DWELl", scpi_cmd_sourceListDwell) \
     SCPI_COMMAND("[SOURce#]:LIST:DWELl?", scpi_cmd_sourceListDwellQ) \
+    SCPI_COMMAND("[SOURce#]:LIST:JITTer?", scpi_cmd_sourceListJitterQ) \
+    SCPI_COMMAND("[SOURce#]:LIST:TIMer", scpi_cmd_sourceListTimer) \
+    SCPI_COMMAND("[SOURce#]:LIST:TIMer?", scpi_cmd_sourceListTimerQ) \
+    SCPI_COMMAND("[SOURce]:LIST:SYNChronize", scpi_cmd_sourceListSynchronize) \
+    SCPI_COMMAND("[SOURce]:LIST:SYNChronize?", scpi_cmd_sourceListSynchronizeQ) \
+    SCPI_COMMAND("[SOURce]:LIST:SKEW?", scpi_cmd_sourceListSkewQ) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion[:SHAPe]", scpi_cmd_sourceListFunctionShape) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion[:SHAPe]?", scpi_cmd_sourceListFunctionShapeQ) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:TARGet", scpi_cmd_sourceListFunctionTarget) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:TARGet?", scpi_cmd_sourceListFunctionTargetQ) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:AMPLitude", scpi_cmd_sourceListFunctionAmplitude) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:AMPLitude?", scpi_cmd_sourceListFunctionAmplitudeQ) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:OFFSet", scpi_cmd_sourceListFunctionOffset) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:OFFSet?", scpi_cmd_sourceListFunctionOffsetQ) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:PERiod", scpi_cmd_sourceListFunctionPeriod) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:PERiod?", scpi_cmd_sourceListFunctionPeriodQ) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:POINts", scpi_cmd_sourceListFunctionPoints) \
+    SCPI_COMMAND("[SOURce#]:LIST:FUNCtion:POINts?", scpi_cmd_sourceListFunctionPointsQ) \
     SCPI_COMMAND("[SOURce#]:LIST:VOLTage[:LEVel]", scpi_cmd_sourceListVoltageLevel) \
     SCPI_COMMAND("[SOURce#]:LIST:VOLTage[:LEVel]?", scpi_cmd_sourceListVoltageLevelQ) \
     SCPI_COMMAND("[SOURce#]:LRIPple", scpi_cmd_sourceLripple) \
@@ -264,6 +307,12 @@
     SCPI_COMMAND("SYSTem:COMMunicate:SERial:BAUD?", scpi_cmd_systemCommunicateSerialBaudQ) \
     SCPI_COMMAND("SYSTem:COMMunicate:SERial:PARity", scpi_cmd_systemCommunicateSerialParity) \
     SCPI_COMMAND("SYSTem:COMMunicate:SERial:PARity?", scpi_cmd_systemCommunicateSerialParityQ) \
+    SCPI_COMMAND("SYSTem:COMMunicate:STReam[:STATe]", scpi_cmd_systemCommunicateStreamState) \
+    SCPI_COMMAND("SYSTem:COMMunicate:STReam[:STATe]?", scpi_cmd_systemCommunicateStreamStateQ) \
+    SCPI_COMMAND("SYSTem:COMMunicate:STReam:CHANnel", scpi_cmd_systemCommunicateStreamChannel) \
+    SCPI_COMMAND("SYSTem:COMMunicate:STReam:CHANnel?", scpi_cmd_systemCommunicateStreamChannelQ) \
+    SCPI_COMMAND("SYSTem:COMMunicate:STReam:PERiod", scpi_cmd_systemCommunicateStreamPeriod) \
+    SCPI_COMMAND("SYSTem:COMMunicate:STReam:PERiod?", scpi_cmd_systemCommunicateStreamPeriodQ) \
     SCPI_COMMAND("SYSTem:CPU:INFOrmation:ETHernet:TYPE?", scpi_cmd_systemCpuInformationEthernetTypeQ) \
     SCPI_COMMAND("SYSTem:CPU:INFOrmation:ONTime:LAST?", scpi_cmd_systemCpuInformationOntimeLastQ) \
     SCPI_COMMAND("SYSTem:CPU:INFOrmation:ONTime:TOTal?", scpi_cmd_systemCpuInformationOntimeTotalQ) \
@@ -320,6 +369,10 @@
     SCPI_COMMAND("TRIGger:DLOG[:IMMediate]", scpi_cmd_triggerDlogImmediate) \
     SCPI_COMMAND("TRIGger:DLOG:SOURce", scpi_cmd_triggerDlogSource) \
     SCPI_COMMAND("TRIGger:DLOG:SOURce?", scpi_cmd_triggerDlogSourceQ) \
+    SCPI_COMMAND("TRIGger:LATency?", scpi_cmd_triggerLatencyQ) \
+    SCPI_COMMAND("TRIGger:THReshold[:DEFine]", scpi_cmd_triggerThresholdDefine) \
+    SCPI_COMMAND("TRIGger:THReshold[:DEFine]?", scpi_cmd_triggerThresholdDefineQ) \
+    SCPI_COMMAND("TRIGger:THReshold:STATe?", scpi_cmd_triggerThresholdStateQ) \
     SCPI_COMMAND("APPLy", scpi_cmd_apply) \
     SCPI_COMMAND("APPLy?", scpi_cmd_applyQ) \
     SCPI_COMMAND("DEBUg?", scpi_cmd_debugQ) \
@@ -338,12 +391,15 @@
     SCPI_COMMAND("SIMUlator:RPOL?", scpi_cmd_simulatorRpolQ) \
     SCPI_COMMAND("SIMUlator:TEMPerature", scpi_cmd_simulatorTemperature) \
     SCPI_COMMAND("SIMUlator:TEMPerature?", scpi_cmd_simulatorTemperatureQ) \
+    SCPI_COMMAND("SIMUlator:TIME:SCALe", scpi_cmd_simulatorTimeScale) \
+    SCPI_COMMAND("SIMUlator:TIME:SCALe?", scpi_cmd_simulatorTimeScaleQ) \
     SCPI_COMMAND("SIMUlator:VOLTage:PROGram:EXTernal", scpi_cmd_simulatorVoltageProgramExternal) \
     SCPI_COMMAND("SIMUlator:VOLTage:PROGram:EXTernal?", scpi_cmd_simulatorVoltageProgramExternalQ) \
     SCPI_COMMAND("DEBUg", scpi_cmd_debug) \
     SCPI_COMMAND("DEBUg:WDOG", scpi_cmd_debugWdog) \
     SCPI_COMMAND("DEBUg:WDOG?", scpi_cmd_debugWdogQ) \
     SCPI_COMMAND("DEBUg:ONTime?", scpi_cmd_debugOntimeQ) \
+    SCPI_COMMAND("DEBUg:PROFile?", scpi_cmd_debugProfileQ) \
     SCPI_COMMAND("DEBUg:VOLTage", scpi_cmd_debugVoltage) \
     SCPI_COMMAND("DEBUg:CURRent", scpi_cmd_debugCurrent) \
     SCPI_COMMAND("DEBUg:MEASure:VOLTage", scpi_cmd_debugMeasureVoltage) \
@@ -128,6 +128,14 @@ scpi_result_t scpi_cmd_debugOntimeQ(scpi_t *context) {
 #endif // CONF_DEBUG
 }
 
+// implemented in scpi_diag.cpp
+scpi_result_t scpi_cmd_diagnosticInformationProfileQ(scpi_t *context);
+
+scpi_result_t scpi_cmd_debugProfileQ(scpi_t *context) {
+    // always available, unlike the other debug commands
+    return scpi_cmd_diagnosticInformationProfileQ(context);
+}
+
 scpi_result_t scpi_cmd_debugVoltage(scpi_t *context) {
 #if CONF_DEBUG
     Channel *channel = param_channel(context);
@@ -22,6 +22,7 @@
 #include "calibration.h"
 #include "devices.h"
 #include "temperature.h"
+#include "scheduler.h"
 #if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R3B4 || EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
 #include "fan.h"
 #endif
@@ -113,7 +114,7 @@ scpi_result_t scpi_cmd_diagnosticInformationAdcQ(scpi_t * context) {
     char buffer[64] = { 0 };
 
     strcpy_P(buffer, PSTR("U_SET="));
-    util::strcatVoltage(buffer, channel->u.mon_dac);
+    util::strcatVoltage(buffer, channel->getUMonDac());
     SCPI_ResultText(context, buffer);
 
     strcpy_P(buffer, PSTR("U_MON="));
@@ -121,7 +122,7 @@ scpi_result_t scpi_cmd_diagnosticInformationAdcQ(scpi_t * context) {
     SCPI_ResultText(context, buffer);
 
     strcpy_P(buffer, PSTR("I_SET="));
-    util::strcatCurrent(buffer, channel->i.mon_dac, getNumSignificantDecimalDigits(VALUE_TYPE_FLOAT_AMPER), channel->index-1);
+    util::strcatCurrent(buffer, channel->getIMonDac(), getNumSignificantDecimalDigits(VALUE_TYPE_FLOAT_AMPER), channel->index-1);
     SCPI_ResultText(context, buffer);
 
     strcpy_P(buffer, PSTR("I_MON="));
@@ -297,6 +298,26 @@ scpi_result_t scpi_cmd_diagnosticInformationFanQ(scpi_t * context) {
     return SCPI_RES_OK;
 }
 
+static void resultProfile(scpi_t * context, const char *name, scheduler::Histogram &histogram) {
+    char buffer[64];
+
+    snprintf_P(buffer, sizeof(buffer), PSTR("%s = %lu %lu %lu"), name,
+        (unsigned long)histogram.getPercentile(50), (unsigned long)histogram.getPercentile(99), (unsigned long)histogram.max);
+    SCPI_ResultText(context, buffer);
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationProfileQ(scpi_t * context) {
+    // one line for the main loop and for each task: p50, p99 and max duration in microseconds
+    resultProfile(context, "main_loop", scheduler::getMainLoopDurations());
+
+    for (int i = 0; i < scheduler::getNumTasks(); ++i) {
+        scheduler::Task *task = scheduler::getTask(i);
+        resultProfile(context, task->name, task->durations);
+    }
+
+    return SCPI_RES_OK;
+}
+
 }
 }
 } // namespace eez::psu::scpi
\ No newline at end of file
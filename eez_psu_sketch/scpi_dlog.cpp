@@ -237,7 +237,113 @@ scpi_result_t scpi_cmd_senseDlogPeriod(scpi_t * context) {
 
 scpi_result_t scpi_cmd_senseDlogPeriodQ(scpi_t * context) {
 #if OPTION_SD_CARD
-	SCPI_ResultFloat(context, dlog::g_period);
+	result_float(context, dlog::g_period);
+	return SCPI_RES_OK;
+#else
+	SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+	return SCPI_RES_ERR;
+#endif
+}
+
+#if OPTION_SD_CARD
+static scpi_choice_def_t modeChoice[] = {
+	{ "PERiodic", dlog::MODE_PERIODIC },
+	{ "ADC", dlog::MODE_ADC },
+	SCPI_CHOICE_LIST_END
+};
+#endif
+
+scpi_result_t scpi_cmd_senseDlogMode(scpi_t * context) {
+#if OPTION_SD_CARD
+	int32_t mode;
+	if (!SCPI_ParamChoice(context, modeChoice, &mode, true)) {
+		return SCPI_RES_ERR;
+	}
+
+	if (!dlog::isIdle()) {
+		SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+		return SCPI_RES_ERR;
+	}
+
+	dlog::g_mode = (dlog::Mode)mode;
+
+	return SCPI_RES_OK;
+#else
+	SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+	return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_senseDlogModeQ(scpi_t * context) {
+#if OPTION_SD_CARD
+	resultChoiceName(context, modeChoice, dlog::g_mode);
+	return SCPI_RES_OK;
+#else
+	SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+	return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_senseDlogCompression(scpi_t * context) {
+#if OPTION_SD_CARD
+	bool enable;
+	if (!SCPI_ParamBool(context, &enable, TRUE)) {
+		return SCPI_RES_ERR;
+	}
+
+	if (!dlog::isIdle()) {
+		SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+		return SCPI_RES_ERR;
+	}
+
+	dlog::g_compression = enable;
+
+	return SCPI_RES_OK;
+#else
+	SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+	return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_senseDlogCompressionQ(scpi_t * context) {
+#if OPTION_SD_CARD
+	SCPI_ResultBool(context, dlog::g_compression);
+	return SCPI_RES_OK;
+#else
+	SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+	return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_senseDlogPreTrigger(scpi_t * context) {
+#if OPTION_SD_CARD
+	uint32_t samples;
+	if (!SCPI_ParamUInt32(context, &samples, true)) {
+		return SCPI_RES_ERR;
+	}
+
+	if (samples > dlog::PRE_TRIGGER_MAX) {
+		SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+		return SCPI_RES_ERR;
+	}
+
+	if (!dlog::isIdle()) {
+		SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+		return SCPI_RES_ERR;
+	}
+
+	dlog::g_preTriggerSamples = samples;
+
+	return SCPI_RES_OK;
+#else
+	SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+	return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_senseDlogPreTriggerQ(scpi_t * context) {
+#if OPTION_SD_CARD
+	SCPI_ResultUInt32(context, dlog::g_preTriggerSamples);
 	return SCPI_RES_OK;
 #else
 	SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
@@ -294,7 +400,7 @@ scpi_result_t scpi_cmd_senseDlogTime(scpi_t * context) {
 
 scpi_result_t scpi_cmd_senseDlogTimeQ(scpi_t * context) {
 #if OPTION_SD_CARD
-	SCPI_ResultFloat(context, dlog::g_time);
+	result_float(context, dlog::g_time);
 	return SCPI_RES_OK;
 #else
 	SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
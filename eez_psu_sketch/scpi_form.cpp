@@ -0,0 +1,109 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "psu.h"
+#include "scpi_psu.h"
+
+namespace eez {
+namespace psu {
+namespace scpi {
+
+////////////////////////////////////////////////////////////////////////////////
+
+static scpi_choice_def_t dataTypeChoice[] = {
+    { "ASCii", DATA_FORMAT_ASCII },
+    { "REAL", DATA_FORMAT_REAL_32 },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static scpi_choice_def_t byteOrderChoice[] = {
+    { "NORMal", SCPI_FORMAT_NORMAL },
+    { "SWAPped", SCPI_FORMAT_SWAPPED },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+scpi_result_t scpi_cmd_formatData(scpi_t *context) {
+    scpi_psu_t *psuContext = (scpi_psu_t *)context->user_context;
+
+    int32_t dataType;
+    if (!SCPI_ParamChoice(context, dataTypeChoice, &dataType, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t length;
+    if (!SCPI_ParamInt(context, &length, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        length = 32;
+    }
+
+    if (dataType == DATA_FORMAT_ASCII) {
+        // length, i.e. number of significant digits, is ignored in ASCii format
+        psuContext->dataFormat = DATA_FORMAT_ASCII;
+    } else if (length == 32) {
+        psuContext->dataFormat = DATA_FORMAT_REAL_32;
+    } else if (length == 64) {
+        psuContext->dataFormat = DATA_FORMAT_REAL_64;
+    } else {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_formatDataQ(scpi_t *context) {
+    scpi_psu_t *psuContext = (scpi_psu_t *)context->user_context;
+
+    if (psuContext->dataFormat == DATA_FORMAT_ASCII) {
+        resultChoiceName(context, dataTypeChoice, DATA_FORMAT_ASCII);
+    } else {
+        resultChoiceName(context, dataTypeChoice, DATA_FORMAT_REAL_32);
+        SCPI_ResultInt(context, psuContext->dataFormat == DATA_FORMAT_REAL_64 ? 64 : 32);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_formatBorder(scpi_t *context) {
+    scpi_psu_t *psuContext = (scpi_psu_t *)context->user_context;
+
+    int32_t byteOrder;
+    if (!SCPI_ParamChoice(context, byteOrderChoice, &byteOrder, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    psuContext->byteOrder = (scpi_array_format_t)byteOrder;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_formatBorderQ(scpi_t *context) {
+    scpi_psu_t *psuContext = (scpi_psu_t *)context->user_context;
+
+    resultChoiceName(context, byteOrderChoice, psuContext->byteOrder);
+
+    return SCPI_RES_OK;
+}
+
+}
+}
+} // namespace eez::psu::scpi
@@ -258,7 +258,7 @@ scpi_result_t scpi_cmd_instrumentDisplayYtRateQ(scpi_t * context) {
     scpi_psu_t *psu_context = (scpi_psu_t *)context->user_context;
     Channel *channel = &Channel::get(psu_context->selected_channel_index - 1);
 
-    SCPI_ResultFloat(context, channel->ytViewRate);
+    result_float(context, channel->ytViewRate);
 
     return SCPI_RES_OK;
 }
@@ -33,8 +33,15 @@ scpi_result_t scpi_cmd_measureScalarCurrentDcQ(scpi_t * context) {
         return SCPI_RES_ERR;
     }
 
+    float value = channel_dispatcher::getIMon(*channel);
+
+    if (is_binary_data_format(context)) {
+        result_float(context, value);
+        return SCPI_RES_OK;
+    }
+
     char buffer[256] = { 0 };
-    util::strcatFloat(buffer, channel_dispatcher::getIMon(*channel), VALUE_TYPE_FLOAT_AMPER, channel->index-1);
+    util::strcatFloat(buffer, value, VALUE_TYPE_FLOAT_AMPER, channel->index-1);
     SCPI_ResultCharacters(context, buffer, strlen(buffer));
 
     return SCPI_RES_OK;
@@ -46,8 +53,15 @@ scpi_result_t scpi_cmd_measureScalarPowerDcQ(scpi_t * context) {
         return SCPI_RES_ERR;
     }
 
+    float value = channel_dispatcher::getUMon(*channel) * channel_dispatcher::getIMon(*channel);
+
+    if (is_binary_data_format(context)) {
+        result_float(context, value);
+        return SCPI_RES_OK;
+    }
+
     char buffer[256] = { 0 };
-    util::strcatFloat(buffer, channel_dispatcher::getUMon(*channel) * channel_dispatcher::getIMon(*channel), getNumSignificantDecimalDigits(VALUE_TYPE_FLOAT_WATT));
+    util::strcatFloat(buffer, value, getNumSignificantDecimalDigits(VALUE_TYPE_FLOAT_WATT));
     SCPI_ResultCharacters(context, buffer, strlen(buffer));
 
     return SCPI_RES_OK;
@@ -59,8 +73,15 @@ scpi_result_t scpi_cmd_measureScalarVoltageDcQ(scpi_t * context) {
         return SCPI_RES_ERR;
     }
 
+    float value = channel_dispatcher::getUMon(*channel);
+
+    if (is_binary_data_format(context)) {
+        result_float(context, value);
+        return SCPI_RES_OK;
+    }
+
     char buffer[256] = { 0 };
-    util::strcatFloat(buffer, channel_dispatcher::getUMon(*channel), getNumSignificantDecimalDigits(VALUE_TYPE_FLOAT_VOLT));
+    util::strcatFloat(buffer, value, getNumSignificantDecimalDigits(VALUE_TYPE_FLOAT_VOLT));
     SCPI_ResultCharacters(context, buffer, strlen(buffer));
 
     return SCPI_RES_OK;
@@ -72,8 +93,15 @@ scpi_result_t scpi_cmd_measureScalarTemperatureThermistorDcQ(scpi_t * context) {
 		return SCPI_RES_ERR;
     }
 
+    float value = temperature::sensors[sensor].measure();
+
+    if (is_binary_data_format(context)) {
+        result_float(context, value);
+        return SCPI_RES_OK;
+    }
+
     char buffer[256] = { 0 };
-    util::strcatFloat(buffer, temperature::sensors[sensor].measure(), getNumSignificantDecimalDigits(VALUE_TYPE_FLOAT_CELSIUS));
+    util::strcatFloat(buffer, value, getNumSignificantDecimalDigits(VALUE_TYPE_FLOAT_CELSIUS));
     SCPI_ResultCharacters(context, buffer, strlen(buffer));
 
     return SCPI_RES_OK;
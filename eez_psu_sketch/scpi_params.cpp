@@ -20,6 +20,7 @@
 #include "scpi_psu.h"
 #include "temp_sensor.h"
 #include "channel_dispatcher.h"
+#include "threshold.h"
 
 namespace eez {
 namespace psu {
@@ -48,6 +49,22 @@ scpi_choice_def_t internal_external_choice[] = {
     SCPI_CHOICE_LIST_END /* termination of option list */
 };
 
+scpi_choice_def_t threshold_function_choice[] = {
+    { "NONE", threshold::FUNCTION_NONE },
+    { "VOLTage", threshold::FUNCTION_VOLTAGE },
+    { "CURRent", threshold::FUNCTION_CURRENT },
+    { "POWer", threshold::FUNCTION_POWER },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+scpi_choice_def_t threshold_condition_choice[] = {
+    { "RISing", threshold::CONDITION_RISING },
+    { "FALLing", threshold::CONDITION_FALLING },
+    { "ABOVe", threshold::CONDITION_ABOVE },
+    { "BELow", threshold::CONDITION_BELOW },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool check_channel(scpi_t *context, int32_t ch) {
@@ -95,6 +112,20 @@ Channel *param_channel(scpi_t *context, scpi_bool_t mandatory, scpi_bool_t skip_
     return &Channel::get(ch - 1);
 }
 
+bool param_channels(scpi_t *context, uint8_t &channels) {
+    channels = 0;
+
+    int32_t ch;
+    while (SCPI_ParamChoice(context, channel_choice, &ch, channels == 0)) {
+        if (!check_channel(context, ch)) {
+            return false;
+        }
+        channels |= 1 << (ch - 1);
+    }
+
+    return !SCPI_ParamErrorOccurred(context);
+}
+
 Channel *set_channel_from_command_number(scpi_t *context) {
     scpi_psu_t *psu_context = (scpi_psu_t *)context->user_context;
 
@@ -185,6 +216,42 @@ bool get_duration_param(scpi_t *context, float &value, float min, float max, flo
     return get_duration_from_param(context, param, value, min, max, def);
 }
 
+static bool get_threshold_from_param(scpi_t *context, const scpi_number_t &param, float &value, Channel &channel, int32_t function) {
+    if (function == threshold::FUNCTION_VOLTAGE) {
+        return get_voltage_from_param(context, param, value, &channel, NULL);
+    }
+    if (function == threshold::FUNCTION_CURRENT) {
+        return get_current_from_param(context, param, value, &channel, NULL);
+    }
+    return get_power_from_param(context, param, value, channel_dispatcher::getPowerMinLimit(channel), channel_dispatcher::getPowerMaxLimit(channel), channel_dispatcher::getPowerDefaultLimit(channel));
+}
+
+bool get_threshold_condition_param(scpi_t *context, Channel &channel, int32_t function, int32_t &condition, float &level, float &hysteresis) {
+    if (!SCPI_ParamChoice(context, threshold_condition_choice, &condition, true)) {
+        return false;
+    }
+
+    scpi_number_t param;
+    if (!SCPI_ParamNumber(context, scpi_special_numbers_def, &param, true)) {
+        return false;
+    }
+    if (!get_threshold_from_param(context, param, level, channel, function)) {
+        return false;
+    }
+
+    // hysteresis is optional
+    hysteresis = 0;
+    if (SCPI_ParamNumber(context, scpi_special_numbers_def, &param, false)) {
+        if (!get_threshold_from_param(context, param, hysteresis, channel, function)) {
+            return false;
+        }
+    } else if (SCPI_ParamErrorOccurred(context)) {
+        return false;
+    }
+
+    return true;
+}
+
 bool get_voltage_from_param(scpi_t *context, const scpi_number_t &param, float &value, const Channel *channel, const Channel::Value *cv) {
     if (param.special) {
 		if (channel) {
@@ -533,6 +600,11 @@ bool get_power_limit_from_param(scpi_t *context, const scpi_number_t &param, flo
 }
 
 scpi_result_t result_float(scpi_t *context, Channel *channel, float value, ValueType valueType) {
+    if (is_binary_data_format(context)) {
+        result_float(context, value);
+        return SCPI_RES_OK;
+    }
+
     char buffer[32] = { 0 };
 
     int numSignificantDecimalDigits = getNumSignificantDecimalDigits(valueType);
@@ -545,6 +617,55 @@ scpi_result_t result_float(scpi_t *context, Channel *channel, float value, Value
     return SCPI_RES_OK;
 }
 
+/// Sends float values as arbitrary block of 4 or 8 bytes values in the given byte order.
+static void resultBinaryFloatArray(scpi_t *context, const float *array, size_t count, DataFormat dataFormat, scpi_array_format_t byteOrder) {
+    size_t valueSize = dataFormat == DATA_FORMAT_REAL_64 ? sizeof(double) : sizeof(float);
+
+    SCPI_ResultArbitraryBlockHeader(context, count * valueSize);
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t bits;
+        if (dataFormat == DATA_FORMAT_REAL_64) {
+            double value = array[i];
+            memcpy(&bits, &value, sizeof(double));
+        } else {
+            uint32_t bits32;
+            memcpy(&bits32, &array[i], sizeof(float));
+            bits = bits32;
+        }
+
+        uint8_t data[sizeof(double)];
+        for (size_t j = 0; j < valueSize; ++j) {
+            size_t shift = byteOrder == SCPI_FORMAT_NORMAL ? valueSize - 1 - j : j;
+            data[j] = (uint8_t)(bits >> (8 * shift));
+        }
+
+        SCPI_ResultArbitraryBlockData(context, data, valueSize);
+    }
+}
+
+/// Returns true if REAL data format is selected with FORMat[:DATA].
+bool is_binary_data_format(scpi_t *context) {
+    scpi_psu_t *psuContext = (scpi_psu_t *)context->user_context;
+    return psuContext->dataFormat != DATA_FORMAT_ASCII;
+}
+
+/// Sends float value in the data format selected with FORMat[:DATA] and FORMat:BORDer.
+void result_float(scpi_t *context, float value) {
+    result_float_array(context, &value, 1);
+}
+
+/// Sends float values in the data format selected with FORMat[:DATA] and FORMat:BORDer.
+/// In REAL format all the values are sent as one arbitrary block.
+void result_float_array(scpi_t *context, const float *array, size_t count) {
+    scpi_psu_t *psuContext = (scpi_psu_t *)context->user_context;
+    if (psuContext->dataFormat == DATA_FORMAT_ASCII) {
+        SCPI_ResultArrayFloat(context, array, count, SCPI_FORMAT_ASCII);
+    } else {
+        resultBinaryFloatArray(context, array, count, psuContext->dataFormat, psuContext->byteOrder);
+    }
+}
+
 bool get_profile_location_param(scpi_t * context, int &location, bool all_locations) {
     int32_t param;
     if (!SCPI_ParamInt(context, &param, true)) {
@@ -584,6 +705,77 @@ bool checkPassword(scpi_t *context, const char *againstPassword) {
     return true;
 }
 
+/// Checks, without consuming it, if the next parameter is definite length arbitrary block.
+bool is_arbitrary_block_param(scpi_t *context) {
+    const char *pos = context->param_list.lex_state.pos;
+    const char *end = context->param_list.lex_state.buffer + context->param_list.lex_state.len;
+
+    while (pos < end && (*pos == ' ' || *pos == '\t')) {
+        ++pos;
+    }
+
+    return end - pos >= 2 && pos[0] == '#' && pos[1] >= '1' && pos[1] <= '9';
+}
+
+/// Gets arbitrary block with the list of float32 values,
+/// in the byte order selected with FORMat:BORDer.
+bool get_list_block_param(scpi_t *context, const uint8_t *&block, uint16_t &listLength, bool &bigEndian) {
+    const char *data;
+    size_t len;
+    if (!SCPI_ParamArbitraryBlock(context, &data, &len, true)) {
+        return false;
+    }
+
+    if (len % sizeof(float) != 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_INVALID_BLOCK_DATA);
+        return false;
+    }
+
+    if (len == 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MISSING_PARAMETER);
+        return false;
+    }
+
+    if (len > MAX_LIST_LENGTH * sizeof(float)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_TOO_MANY_LIST_POINTS);
+        return false;
+    }
+
+    block = (const uint8_t *)data;
+    listLength = (uint16_t)(len / sizeof(float));
+
+    scpi_psu_t *psuContext = (scpi_psu_t *)context->user_context;
+    bigEndian = psuContext->byteOrder == SCPI_FORMAT_NORMAL;
+
+    return true;
+}
+
+static scpi_choice_def_t list_format_choice[] = {
+    { "ASCii", DATA_FORMAT_ASCII },
+    { "REAL", DATA_FORMAT_REAL_32 },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+/// Sends the list of float values. Optional ASCii or REAL parameter overrides
+/// the FORMat[:DATA] setting, REAL means arbitrary block of float32 values in the byte
+/// order selected with FORMat:BORDer, i.e. the same block as accepted by get_list_block_param.
+scpi_result_t result_float_list(scpi_t *context, const float *list, uint16_t listLength) {
+    int32_t format;
+    if (!SCPI_ParamChoice(context, list_format_choice, &format, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        result_float_array(context, list, listLength);
+    } else if (format == DATA_FORMAT_ASCII) {
+        SCPI_ResultArrayFloat(context, list, listLength, SCPI_FORMAT_ASCII);
+    } else {
+        scpi_psu_t *psuContext = (scpi_psu_t *)context->user_context;
+        resultBinaryFloatArray(context, list, listLength, DATA_FORMAT_REAL_32, psuContext->byteOrder);
+    }
+
+    return SCPI_RES_OK;
+}
+
 #if OPTION_SD_CARD
 
 void cleanupPath(char *filePath) {
@@ -24,8 +24,12 @@ namespace scpi {
 
 extern scpi_choice_def_t temp_sensor_choice[];
 extern scpi_choice_def_t internal_external_choice[];
+extern scpi_choice_def_t threshold_function_choice[];
+extern scpi_choice_def_t threshold_condition_choice[];
 
 Channel *param_channel(scpi_t *context, scpi_bool_t mandatory = FALSE, scpi_bool_t skip_channel_check = FALSE);
+/// Parses one or more channels (e.g. CH1,CH2) into the bit mask, bit 0 is CH1.
+bool param_channels(scpi_t *context, uint8_t &channels);
 bool check_channel(scpi_t *context, int32_t ch);
 Channel *set_channel_from_command_number(scpi_t *context);
 
@@ -37,6 +41,9 @@ bool get_current_param(scpi_t *context, float &value, const Channel *channel, co
 bool get_power_param(scpi_t *context, float &value, float min, float max, float def);
 bool get_temperature_param(scpi_t *context, float &value, float min, float max, float def);
 bool get_duration_param(scpi_t *context, float &value, float min, float max, float def);
+/// Parses the threshold condition, level and optional hysteresis, level and
+/// hysteresis are in the units of the function (threshold::Function).
+bool get_threshold_condition_param(scpi_t *context, Channel &channel, int32_t function, int32_t &condition, float &level, float &hysteresis);
 
 bool get_voltage_from_param(scpi_t *context, const scpi_number_t &param, float &value, const Channel *channel, const Channel::Value *cv);
 bool get_voltage_protection_level_from_param(scpi_t *context, const scpi_number_t &param, float &value, float min, float max, float def);
@@ -53,6 +60,10 @@ bool get_current_limit_from_param(scpi_t *context, const scpi_number_t &param, f
 bool get_power_limit_from_param(scpi_t *context, const scpi_number_t &param, float &value, const Channel *channel, const Channel::Value *cv);
 
 scpi_result_t result_float(scpi_t *context, Channel *channel, float value, ValueType valueType);
+bool is_binary_data_format(scpi_t *context);
+void result_float(scpi_t *context, float value);
+void result_float_array(scpi_t *context, const float *array, size_t count);
+scpi_result_t result_float_list(scpi_t *context, const float *list, uint16_t listLength);
 bool get_profile_location_param(scpi_t *context, int &location, bool all_locations = false);
 
 void outputOnTime(scpi_t* context, uint32_t time);
@@ -60,6 +71,9 @@ bool checkPassword(scpi_t *context, const char *againstPassword);
 
 bool getFilePath(scpi_t *context, char *filePath, bool mandatory);
 
+bool is_arbitrary_block_param(scpi_t *context);
+bool get_list_block_param(scpi_t *context, const uint8_t *&block, uint16_t &listLength, bool &bigEndian);
+
 }
 }
 } // namespace eez::psu::scpi
@@ -72,6 +72,8 @@ void init(scpi_t &scpi_context,
     scpi_interface_t *interface,
     char *input_buffer,
     size_t input_buffer_length,
+    char *output_buffer,
+    size_t output_buffer_length,
     int16_t *error_queue_data,
     int16_t error_queue_size)
 {
@@ -85,10 +87,42 @@ void init(scpi_t &scpi_context,
 #endif
 	scpi_psu_context.isBufferOverrun = false;
 	scpi_psu_context.bufferOverrunTime =  0;
+    scpi_psu_context.outputBuffer = output_buffer;
+    scpi_psu_context.outputBufferLength = output_buffer_length;
+    scpi_psu_context.outputBufferPosition = 0;
+    scpi_psu_context.dataFormat = DATA_FORMAT_ASCII;
+    scpi_psu_context.byteOrder = SCPI_FORMAT_NORMAL;
 
     scpi_context.user_context = &scpi_psu_context;
 }
 
+size_t writeBuffered(scpi_t &context, const char *data, size_t len, WriteFunction write) {
+    scpi_psu_t *psu_context = (scpi_psu_t *)context.user_context;
+
+    if (psu_context->outputBufferPosition + len > psu_context->outputBufferLength) {
+        flushBuffered(context, write);
+
+        if (len >= psu_context->outputBufferLength) {
+            // doesn't fit in the buffer, write it directly
+            return write(&context, data, len);
+        }
+    }
+
+    memcpy(psu_context->outputBuffer + psu_context->outputBufferPosition, data, len);
+    psu_context->outputBufferPosition += len;
+
+    return len;
+}
+
+void flushBuffered(scpi_t &context, WriteFunction write) {
+    scpi_psu_t *psu_context = (scpi_psu_t *)context.user_context;
+
+    if (psu_context->outputBufferPosition > 0) {
+        write(&context, psu_context->outputBuffer, psu_context->outputBufferPosition);
+        psu_context->outputBufferPosition = 0;
+    }
+}
+
 void emptyBuffer(scpi_t &context) {
 	SCPI_Input(&context, 0, 0);
 }
@@ -177,9 +211,25 @@ void resetContext(scpi_t *context) {
     psuContext->currentDirectory[0] = 0;
 #endif
 
+    psuContext->dataFormat = DATA_FORMAT_ASCII;
+    psuContext->byteOrder = SCPI_FORMAT_NORMAL;
+
     SCPI_ErrorClear(context);
 }
 
+void resetConnection(scpi_t &context) {
+    // unlike emptyBuffer, partial command left by the previous connection is not executed
+    context.buffer.position = 0;
+    context.buffer.data[0] = 0;
+
+    scpi_psu_t *psuContext = (scpi_psu_t *)context.user_context;
+    psuContext->outputBufferPosition = 0;
+    psuContext->isBufferOverrun = false;
+    psuContext->bufferOverrunTime = 0;
+
+    resetContext(&context);
+}
+
 }
 }
 } // namespace eez::psu::scpi
\ No newline at end of file
@@ -26,6 +26,13 @@ namespace psu {
 /// SCPI commands.
 namespace scpi {
 
+/// Data format of the numeric query results, see FORMat[:DATA].
+enum DataFormat {
+    DATA_FORMAT_ASCII,
+    DATA_FORMAT_REAL_32,
+    DATA_FORMAT_REAL_64
+};
+
 /// EEZ PSU specific SCPI parser context data.
 struct scpi_psu_t {
     scpi_reg_val_t *registers;
@@ -35,6 +42,12 @@ struct scpi_psu_t {
 #endif
 	bool isBufferOverrun;
 	uint32_t bufferOverrunTime;
+    char *outputBuffer;
+    size_t outputBufferLength;
+    size_t outputBufferPosition;
+    DataFormat dataFormat;
+    /// SCPI_FORMAT_NORMAL (big-endian) or SCPI_FORMAT_SWAPPED (little-endian), see FORMat:BORDer.
+    scpi_array_format_t byteOrder;
 };
 
 void init(scpi_t &scpi_context,
@@ -42,11 +55,20 @@ void init(scpi_t &scpi_context,
     scpi_interface_t *interface,
     char *input_buffer,
     size_t input_buffer_length,
+    char *output_buffer,
+    size_t output_buffer_length,
     int16_t *error_queue_data,
     int16_t error_queue_size);
 
 void input(scpi_t &scpi_context, const char *str, size_t size);
 
+typedef size_t (*WriteFunction)(scpi_t *context, const char *data, size_t len);
+
+/// Appends data to the output buffer. Buffer is written with the write function only when full.
+size_t writeBuffered(scpi_t &context, const char *data, size_t len, WriteFunction write);
+/// Writes and empties the output buffer.
+void flushBuffered(scpi_t &context, WriteFunction write);
+
 void emptyBuffer(scpi_t &context);
 void onBufferOverrun(scpi_t &context);
 
@@ -57,6 +79,9 @@ void resultChoiceName(scpi_t *context, scpi_choice_def_t *choice, int tag);
 extern bool g_busy;
 
 void resetContext(scpi_t *context);
+/// Puts the context in the state of the new connection: pending input and
+/// output are discarded and the settings and the error queue are reset.
+void resetConnection(scpi_t &context);
 
 }
 }
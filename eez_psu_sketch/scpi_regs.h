@@ -74,6 +74,7 @@ namespace scpi {
 #define OPER_ISUM_DP_OFF   (1 << 11)  /* Down Programmer OFF */
 #define OPER_ISUM_RSENS_ON (1 << 12)  /* Remote SENSe ON */
 #define OPER_ISUM_RPROG_ON (1 << 13)  /* Remote PROGram ON */
+#define OPER_ISUM_THR      (1 << 14)  /* THReshold condition is met */
 
 //
 // PSU registers
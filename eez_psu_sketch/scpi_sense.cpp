@@ -104,9 +104,9 @@ scpi_result_t scpi_cmd_senseCurrentDcRangeUpperQ(scpi_t *context) {
     CurrentRangeSelectionMode mode = channel->getCurrentRangeSelectionMode();
 
     if (mode == CURRENT_RANGE_SELECTION_ALWAYS_LOW) {
-        SCPI_ResultFloat(context, 0.5);
+        result_float(context, 0.5);
     } else if (mode == CURRENT_RANGE_SELECTION_ALWAYS_HIGH) {
-        SCPI_ResultFloat(context, 5);
+        result_float(context, 5);
     } else {
         SCPI_ResultText(context, "Default");
     }
@@ -160,6 +160,71 @@ scpi_result_t scpi_cmd_senseCurrentDcRangeAutoQ(scpi_t * context) {
     return SCPI_RES_OK;
 }
 
+static scpi_choice_def_t averagingTypeChoice[] = {
+    { "MOVing", AVERAGING_TYPE_MOVING },
+    { "EXPonential", AVERAGING_TYPE_EXPONENTIAL },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+scpi_result_t scpi_cmd_senseAverageCount(scpi_t * context) {
+    uint32_t count;
+    if (!SCPI_ParamUInt32(context, &count, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (count < ADC_AVERAGING_COUNT_MIN || count > ADC_AVERAGING_COUNT_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    channel_dispatcher::setAveraging(*channel, channel->getAveragingType(), (uint16_t)count);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAverageCountQ(scpi_t * context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultInt(context, channel->getAveragingCount());
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAverageTcontrol(scpi_t * context) {
+    int32_t type;
+    if (!SCPI_ParamChoice(context, averagingTypeChoice, &type, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    channel_dispatcher::setAveraging(*channel, (AveragingType)type, channel->getAveragingCount());
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAverageTcontrolQ(scpi_t * context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    resultChoiceName(context, averagingTypeChoice, channel->getAveragingType());
+
+    return SCPI_RES_OK;
+}
+
 }
 }
 } // namespace eez::psu::scpi
\ No newline at end of file
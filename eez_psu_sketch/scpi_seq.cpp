@@ -0,0 +1,329 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "psu.h"
+#include "scpi_psu.h"
+
+#include "sequencer.h"
+#include "channel_dispatcher.h"
+
+namespace eez {
+namespace psu {
+namespace scpi {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// wait condition and trigger source in one choice
+enum {
+    WAIT_CHOICE_NONE,
+    WAIT_CHOICE_TIME,
+    WAIT_CHOICE_BUS,
+    WAIT_CHOICE_MANUAL,
+    WAIT_CHOICE_PIN1,
+    WAIT_CHOICE_THRESHOLD
+};
+
+static scpi_choice_def_t waitChoice[] = {
+    { "NONE", WAIT_CHOICE_NONE },
+    { "TIME", WAIT_CHOICE_TIME },
+    { "BUS", WAIT_CHOICE_BUS },
+    { "MANual", WAIT_CHOICE_MANUAL },
+    { "PIN1", WAIT_CHOICE_PIN1 },
+    { "THReshold", WAIT_CHOICE_THRESHOLD },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static scpi_choice_def_t actionChoice[] = {
+    { "NONE", sequencer::ACTION_NONE },
+    { "VOLTage", sequencer::ACTION_SET_VOLTAGE },
+    { "CURRent", sequencer::ACTION_SET_CURRENT },
+    { "OUTPut", sequencer::ACTION_OUTPUT },
+    { "TRIGger", sequencer::ACTION_TRIGGER },
+    { "DLOG", sequencer::ACTION_DLOG },
+    { "PULSe", sequencer::ACTION_PULSE },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static bool getStepNumber(scpi_t *context, int32_t &stepNumber) {
+    SCPI_CommandNumbers(context, &stepNumber, 1, 1);
+    if (stepNumber < 1 || stepNumber > MAX_SEQUENCER_STEPS) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HEADER_SUFFIX_OUTOFRANGE);
+        return false;
+    }
+    return true;
+}
+
+static void resultChannel(scpi_t *context, uint8_t channelIndex) {
+    char text[4] = "CH1";
+    text[2] = '1' + channelIndex;
+    SCPI_ResultText(context, text);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+scpi_result_t scpi_cmd_sequencerStepWait(scpi_t *context) {
+    int32_t stepNumber;
+    if (!getStepNumber(context, stepNumber)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t wait;
+    if (!SCPI_ParamChoice(context, waitChoice, &wait, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    sequencer::Step step;
+    sequencer::getStep(stepNumber, step);
+
+    if (wait == WAIT_CHOICE_NONE) {
+        step.wait = sequencer::WAIT_NONE;
+    } else if (wait == WAIT_CHOICE_TIME) {
+        if (!get_duration_param(context, step.waitValue, sequencer::WAIT_TIME_MIN, sequencer::WAIT_TIME_MAX, sequencer::WAIT_TIME_MIN)) {
+            return SCPI_RES_ERR;
+        }
+        step.wait = sequencer::WAIT_TIME;
+    } else if (wait == WAIT_CHOICE_THRESHOLD) {
+        // same parameters as TRIGger:THReshold, but the condition is only for this step
+        Channel *channel = param_channel(context, TRUE);
+        if (!channel) {
+            return SCPI_RES_ERR;
+        }
+
+        int32_t function;
+        if (!SCPI_ParamChoice(context, threshold_function_choice, &function, true)) {
+            return SCPI_RES_ERR;
+        }
+        if (function == threshold::FUNCTION_NONE) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+
+        int32_t condition;
+        float level;
+        float hysteresis;
+        if (!get_threshold_condition_param(context, *channel, function, condition, level, hysteresis)) {
+            return SCPI_RES_ERR;
+        }
+
+        step.wait = sequencer::WAIT_THRESHOLD;
+        step.waitChannelIndex = channel->index - 1;
+        step.waitFunction = (threshold::Function)function;
+        step.waitCondition = (threshold::Condition)condition;
+        step.waitValue = level;
+        step.waitHysteresis = hysteresis;
+    } else {
+        step.wait = sequencer::WAIT_TRIGGER;
+        step.waitSource = wait == WAIT_CHOICE_BUS ? trigger::SOURCE_BUS : wait == WAIT_CHOICE_MANUAL ? trigger::SOURCE_MANUAL : trigger::SOURCE_PIN1;
+    }
+
+    sequencer::setStep(stepNumber, step);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerStepWaitQ(scpi_t *context) {
+    int32_t stepNumber;
+    if (!getStepNumber(context, stepNumber)) {
+        return SCPI_RES_ERR;
+    }
+
+    sequencer::Step step;
+    sequencer::getStep(stepNumber, step);
+
+    if (step.wait == sequencer::WAIT_NONE) {
+        resultChoiceName(context, waitChoice, WAIT_CHOICE_NONE);
+    } else if (step.wait == sequencer::WAIT_TIME) {
+        resultChoiceName(context, waitChoice, WAIT_CHOICE_TIME);
+        result_float(context, step.waitValue);
+    } else if (step.wait == sequencer::WAIT_TRIGGER) {
+        resultChoiceName(context, waitChoice,
+            step.waitSource == trigger::SOURCE_BUS ? WAIT_CHOICE_BUS : step.waitSource == trigger::SOURCE_MANUAL ? WAIT_CHOICE_MANUAL : WAIT_CHOICE_PIN1);
+    } else {
+        resultChoiceName(context, waitChoice, WAIT_CHOICE_THRESHOLD);
+        resultChannel(context, step.waitChannelIndex);
+        resultChoiceName(context, threshold_function_choice, step.waitFunction);
+        resultChoiceName(context, threshold_condition_choice, step.waitCondition);
+        result_float(context, step.waitValue);
+        result_float(context, step.waitHysteresis);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerStepAction(scpi_t *context) {
+    int32_t stepNumber;
+    if (!getStepNumber(context, stepNumber)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t action;
+    if (!SCPI_ParamChoice(context, actionChoice, &action, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    sequencer::Step step;
+    sequencer::getStep(stepNumber, step);
+
+    if (action == sequencer::ACTION_SET_VOLTAGE || action == sequencer::ACTION_SET_CURRENT || action == sequencer::ACTION_OUTPUT) {
+        Channel *channel = param_channel(context, TRUE);
+        if (!channel) {
+            return SCPI_RES_ERR;
+        }
+
+        float value;
+        if (action == sequencer::ACTION_SET_VOLTAGE) {
+            if (!get_voltage_param(context, value, channel, NULL)) {
+                return SCPI_RES_ERR;
+            }
+        } else if (action == sequencer::ACTION_SET_CURRENT) {
+            if (!get_current_param(context, value, channel, NULL)) {
+                return SCPI_RES_ERR;
+            }
+        } else {
+            bool enable;
+            if (!SCPI_ParamBool(context, &enable, TRUE)) {
+                return SCPI_RES_ERR;
+            }
+            value = enable ? 1.0f : 0.0f;
+        }
+
+        step.actionTarget = channel->index - 1;
+        step.actionValue = value;
+    } else if (action == sequencer::ACTION_PULSE) {
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+        int32_t pin;
+        if (!SCPI_ParamInt(context, &pin, TRUE)) {
+            return SCPI_RES_ERR;
+        }
+
+        if (pin != 2 && pin != 3) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+
+        float width;
+        if (!get_duration_param(context, width, sequencer::PULSE_WIDTH_MIN, sequencer::PULSE_WIDTH_MAX, CONF_TOUTPUT_PULSE_WIDTH_MS / 1000.0f)) {
+            return SCPI_RES_ERR;
+        }
+
+        step.actionTarget = (uint8_t)pin;
+        step.actionValue = width;
+#else
+        SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+        return SCPI_RES_ERR;
+#endif
+    }
+
+    step.action = (sequencer::Action)action;
+
+    sequencer::setStep(stepNumber, step);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerStepActionQ(scpi_t *context) {
+    int32_t stepNumber;
+    if (!getStepNumber(context, stepNumber)) {
+        return SCPI_RES_ERR;
+    }
+
+    sequencer::Step step;
+    sequencer::getStep(stepNumber, step);
+
+    resultChoiceName(context, actionChoice, step.action);
+
+    if (step.action == sequencer::ACTION_SET_VOLTAGE || step.action == sequencer::ACTION_SET_CURRENT) {
+        resultChannel(context, step.actionTarget);
+        result_float(context, step.actionValue);
+    } else if (step.action == sequencer::ACTION_OUTPUT) {
+        resultChannel(context, step.actionTarget);
+        SCPI_ResultBool(context, step.actionValue != 0);
+    } else if (step.action == sequencer::ACTION_PULSE) {
+        SCPI_ResultInt(context, step.actionTarget);
+        result_float(context, step.actionValue);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerStepNext(scpi_t *context) {
+    int32_t stepNumber;
+    if (!getStepNumber(context, stepNumber)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t next;
+    if (!SCPI_ParamInt(context, &next, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (next < 0 || next > MAX_SEQUENCER_STEPS) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    sequencer::Step step;
+    sequencer::getStep(stepNumber, step);
+    step.next = (uint8_t)next;
+    sequencer::setStep(stepNumber, step);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerStepNextQ(scpi_t *context) {
+    int32_t stepNumber;
+    if (!getStepNumber(context, stepNumber)) {
+        return SCPI_RES_ERR;
+    }
+
+    sequencer::Step step;
+    sequencer::getStep(stepNumber, step);
+    SCPI_ResultInt(context, step.next);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerClear(scpi_t *context) {
+    if (sequencer::isRunning()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    sequencer::clear();
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerInitiate(scpi_t *context) {
+    sequencer::initiate();
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerAbort(scpi_t *context) {
+    sequencer::abort();
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sequencerStateQ(scpi_t *context) {
+    SCPI_ResultInt(context, sequencer::getCurrentStepNumber());
+    return SCPI_RES_OK;
+}
+
+}
+}
+} // namespace eez::psu::scpi
@@ -331,6 +331,48 @@ scpi_result_t scpi_cmd_simulatorTemperatureQ(scpi_t *context) {
     return result_float(context, 0, value, VALUE_TYPE_FLOAT_CELSIUS);
 }
 
+scpi_result_t scpi_cmd_simulatorTimeScale(scpi_t *context) {
+    scpi_number_t param;
+    if (!SCPI_ParamNumber(context, scpi_special_numbers_def, &param, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    float value;
+    if (param.special) {
+        if (param.tag == SCPI_NUM_MAX) {
+            // fast forward
+            value = 0;
+        } else if (param.tag == SCPI_NUM_MIN) {
+            value = SIM_TIME_SCALE_MIN;
+        } else if (param.tag == SCPI_NUM_DEF) {
+            value = SIM_TIME_SCALE_DEF;
+        } else {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+    } else {
+        if (param.unit != SCPI_UNIT_NONE) {
+            SCPI_ErrorPush(context, SCPI_ERROR_INVALID_SUFFIX);
+            return SCPI_RES_ERR;
+        }
+
+        value = (float)param.value;
+        if (value != 0 && (value < SIM_TIME_SCALE_MIN || value > SIM_TIME_SCALE_MAX)) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    simulator::setTimeScale(value);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorTimeScaleQ(scpi_t *context) {
+    result_float(context, simulator::getTimeScale());
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_simulatorGui(scpi_t *context) {
 #if OPTION_DISPLAY
     if (!simulator::front_panel::open()) {
@@ -441,6 +483,16 @@ scpi_result_t scpi_cmd_simulatorTemperatureQ(scpi_t *context) {
     return SCPI_RES_ERR;
 }
 
+scpi_result_t scpi_cmd_simulatorTimeScale(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorTimeScaleQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
 scpi_result_t scpi_cmd_simulatorGui(scpi_t *context) {
     SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
     return SCPI_RES_ERR;
@@ -119,7 +119,7 @@ static scpi_result_t get_source_value(scpi_t *context, Channel &channel, ValueTy
 }
 
 scpi_result_t get_delay(scpi_t *context, float delay) {
-    SCPI_ResultFloat(context, delay);
+    result_float(context, delay);
 
     return SCPI_RES_OK;
 }
@@ -232,7 +232,7 @@ scpi_result_t scpi_cmd_sourceVoltageLevelImmediateAmplitudeQ(scpi_t * context) {
 
 	float u;
 	if (channel->isRemoteProgrammingEnabled()) {
-		u = channel->u.mon_dac;
+		u = channel->getUMonDac();
 	} else {
 		u = channel_dispatcher::getUSet(*channel);
 	}
@@ -1017,18 +1017,64 @@ scpi_result_t scpi_cmd_sourceListCountQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+static bool checkCurrentListValue(scpi_t *context, Channel &channel, float current, int i) {
+    if (util::isNaN(current)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return false;
+    }
+
+    if (util::greater(current, channel_dispatcher::getIMaxLimit(channel), getPrecision(VALUE_TYPE_FLOAT_AMPER))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_CURRENT_LIMIT_EXCEEDED);
+        return false;
+    }
+
+    uint16_t voltageListLength;
+    float *voltageList = list::getVoltageList(channel, &voltageListLength);
+    if (voltageListLength > 0) {
+        if (util::greater(current * voltageList[i % voltageListLength], channel_dispatcher::getPowerMaxLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
+            SCPI_ErrorPush(context, SCPI_ERROR_POWER_LIMIT_EXCEEDED);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 scpi_result_t scpi_cmd_sourceListCurrentLevel(scpi_t *context) {
     Channel *channel = set_channel_from_command_number(context);
     if (!channel) {
         return SCPI_RES_ERR;
     }
 
+    if (is_arbitrary_block_param(context)) {
+        // binary block is validated and then decoded directly into the channel list
+        const uint8_t *block;
+        uint16_t listLength;
+        bool bigEndian;
+        if (!get_list_block_param(context, block, listLength, bigEndian)) {
+            return SCPI_RES_ERR;
+        }
+
+        for (int i = 0; i < listLength; ++i) {
+            if (!checkCurrentListValue(context, *channel, util::getFloat(block + i * sizeof(float), bigEndian), i)) {
+                return SCPI_RES_ERR;
+            }
+        }
+
+        if (!trigger::isIdle()) {
+            SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+            return SCPI_RES_ERR;
+        }
+
+        list::setCurrentListFromBlock(*channel, block, listLength, bigEndian);
+        profile::save();
+
+        return SCPI_RES_OK;
+    }
+
     float list[MAX_LIST_LENGTH];
     uint16_t listLength = 0;
 
-    uint16_t voltageListLength;
-    float *voltageList = list::getCurrentList(*channel, &voltageListLength);
-
     for (int i = 0; ; ++i) {
         scpi_number_t param;
         if (!SCPI_ParamNumber(context, 0, &param, false)) {
@@ -1047,16 +1093,8 @@ scpi_result_t scpi_cmd_sourceListCurrentLevel(scpi_t *context) {
             return SCPI_RES_ERR;
         }
 
-	    if (util::greater(current, channel_dispatcher::getIMaxLimit(*channel), getPrecision(VALUE_TYPE_FLOAT_AMPER))) {
-            SCPI_ErrorPush(context, SCPI_ERROR_CURRENT_LIMIT_EXCEEDED);
+        if (!checkCurrentListValue(context, *channel, current, i)) {
             return SCPI_RES_ERR;
-	    }
-
-        if (voltageListLength > 0) {
-            if (util::greater(current * voltageList[i % voltageListLength], channel_dispatcher::getPowerMaxLimit(*channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
-                SCPI_ErrorPush(context, SCPI_ERROR_POWER_LIMIT_EXCEEDED);
-                return SCPI_RES_ERR;
-            }
         }
 
         list[listLength++] = current;
@@ -1086,9 +1124,7 @@ scpi_result_t scpi_cmd_sourceListCurrentLevelQ(scpi_t *context) {
 
     uint16_t listLength;
     float *list = list::getCurrentList(*channel, &listLength);
-    SCPI_ResultArrayFloat(context, list, listLength, SCPI_FORMAT_ASCII);
-
-    return SCPI_RES_OK;
+    return result_float_list(context, list, listLength);
 }
 
 scpi_result_t scpi_cmd_sourceListDwell(scpi_t *context) {
@@ -1097,6 +1133,33 @@ scpi_result_t scpi_cmd_sourceListDwell(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
+    if (is_arbitrary_block_param(context)) {
+        const uint8_t *block;
+        uint16_t listLength;
+        bool bigEndian;
+        if (!get_list_block_param(context, block, listLength, bigEndian)) {
+            return SCPI_RES_ERR;
+        }
+
+        for (int i = 0; i < listLength; ++i) {
+            float dwell = util::getFloat(block + i * sizeof(float), bigEndian);
+            if (!(dwell >= LIST_DWELL_MIN && dwell <= LIST_DWELL_MAX)) {
+                SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+                return SCPI_RES_ERR;
+            }
+        }
+
+        if (!trigger::isIdle()) {
+            SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+            return SCPI_RES_ERR;
+        }
+
+        list::setDwellListFromBlock(*channel, block, listLength, bigEndian);
+        profile::save();
+
+        return SCPI_RES_OK;
+    }
+
     float list[MAX_LIST_LENGTH];
     uint16_t listLength = 0;
 
@@ -1112,6 +1175,10 @@ scpi_result_t scpi_cmd_sourceListDwell(scpi_t *context) {
         }
 
         float dwell = (float)param.value;
+        if (dwell < LIST_DWELL_MIN || dwell > LIST_DWELL_MAX) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return SCPI_RES_ERR;
+        }
 
         if (listLength >= MAX_LIST_LENGTH) {
             SCPI_ErrorPush(context, SCPI_ERROR_TOO_MANY_LIST_POINTS);
@@ -1145,23 +1212,398 @@ scpi_result_t scpi_cmd_sourceListDwellQ(scpi_t *context) {
 
     uint16_t listLength;
     float *list = list::getDwellList(*channel, &listLength);
-    SCPI_ResultArrayFloat(context, list, listLength, SCPI_FORMAT_ASCII);
+    return result_float_list(context, list, listLength);
+}
+
+scpi_result_t scpi_cmd_sourceListJitterQ(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t max = 0;
+    uint32_t mean = 0;
+    uint32_t count = 0;
+    uint32_t histogram[list::JITTER_HISTOGRAM_SIZE] = { 0 };
+    list::getJitter(*channel, max, mean, count, histogram);
+
+    // max and mean in seconds, followed by the number of steps and the histogram
+    result_float(context, max / 1000000.0f);
+    result_float(context, mean / 1000000.0f);
+    SCPI_ResultInt(context, count);
+    for (int i = 0; i < list::JITTER_HISTOGRAM_SIZE; ++i) {
+        SCPI_ResultInt(context, histogram[i]);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListTimer(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    bool enable;
+    if (!SCPI_ParamBool(context, &enable, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+#if !CONF_LIST_TIMER
+    if (enable) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+        return SCPI_RES_ERR;
+    }
+#endif
+
+    list::setTimerMode(*channel, enable);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListTimerQ(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBool(context, list::getTimerMode(*channel));
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListSynchronize(scpi_t *context) {
+    bool enable;
+    if (!SCPI_ParamBool(context, &enable, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!trigger::isIdle()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+        return SCPI_RES_ERR;
+    }
+
+    list::setSynchronized(enable);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListSynchronizeQ(scpi_t *context) {
+    SCPI_ResultBool(context, list::isSynchronized());
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListSkewQ(scpi_t *context) {
+    uint32_t max = 0;
+    uint32_t mean = 0;
+    uint32_t count = 0;
+    list::getSkew(max, mean, count);
+
+    // max and mean in seconds, followed by the number of steps
+    result_float(context, max / 1000000.0f);
+    result_float(context, mean / 1000000.0f);
+    SCPI_ResultInt(context, count);
+
+    return SCPI_RES_OK;
+}
+
+static scpi_choice_def_t functionShapeChoice[] = {
+    { "NONE", list::FUNCTION_NONE },
+    { "SINusoid", list::FUNCTION_SINE },
+    { "SQUare", list::FUNCTION_SQUARE },
+    { "RAMP", list::FUNCTION_RAMP },
+    { "STAIr", list::FUNCTION_STAIR },
+    { "EXPonential", list::FUNCTION_EXPONENTIAL },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static scpi_choice_def_t functionTargetChoice[] = {
+    { "VOLTage", list::FUNCTION_TARGET_VOLTAGE },
+    { "CURRent", list::FUNCTION_TARGET_CURRENT },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static bool setListFunction(scpi_t *context, Channel &channel, const list::Function &function) {
+    if (!trigger::isIdle()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+        return false;
+    }
+
+    list::setFunction(channel, function);
+
+    return true;
+}
+
+/// Amplitude and offset are in volts or amperes, depending on the function target.
+static bool getListFunctionLevelParam(scpi_t *context, Channel &channel, const list::Function &function, float &value) {
+    if (function.target == list::FUNCTION_TARGET_VOLTAGE) {
+        return get_voltage_param(context, value, &channel, NULL);
+    }
+    return get_current_param(context, value, &channel, NULL);
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionShape(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t shape;
+    if (!SCPI_ParamChoice(context, functionShapeChoice, &shape, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    function.shape = (list::FunctionShape)shape;
+    if (!setListFunction(context, *channel, function)) {
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionShapeQ(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    resultChoiceName(context, functionShapeChoice, function.shape);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionTarget(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t target;
+    if (!SCPI_ParamChoice(context, functionTargetChoice, &target, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    function.target = (list::FunctionTarget)target;
+    if (!setListFunction(context, *channel, function)) {
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionTargetQ(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    resultChoiceName(context, functionTargetChoice, function.target);
 
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_sourceListFunctionAmplitude(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    if (!getListFunctionLevelParam(context, *channel, function, function.amplitude)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!setListFunction(context, *channel, function)) {
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionAmplitudeQ(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    result_float(context, function.amplitude);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionOffset(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    if (!getListFunctionLevelParam(context, *channel, function, function.offset)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!setListFunction(context, *channel, function)) {
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionOffsetQ(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    result_float(context, function.offset);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionPeriod(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    if (!get_duration_param(context, function.period, LIST_FUNCTION_PERIOD_MIN, LIST_FUNCTION_PERIOD_MAX, LIST_FUNCTION_PERIOD_DEF)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!setListFunction(context, *channel, function)) {
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionPeriodQ(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    result_float(context, function.period);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionPoints(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t points;
+    if (!SCPI_ParamUInt32(context, &points, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (points < LIST_FUNCTION_POINTS_MIN || points > LIST_FUNCTION_POINTS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    function.points = points;
+    if (!setListFunction(context, *channel, function)) {
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_sourceListFunctionPointsQ(scpi_t *context) {
+    Channel *channel = set_channel_from_command_number(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    list::Function function;
+    list::getFunction(*channel, function);
+    SCPI_ResultUInt32(context, function.points);
+
+    return SCPI_RES_OK;
+}
+
+static bool checkVoltageListValue(scpi_t *context, Channel &channel, float voltage, int i) {
+    if (util::isNaN(voltage)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return false;
+    }
+
+    if (util::greater(voltage, channel_dispatcher::getUMaxLimit(channel), getPrecision(VALUE_TYPE_FLOAT_VOLT))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED);
+        return false;
+    }
+
+    uint16_t currentListLength;
+    float *currentList = list::getCurrentList(channel, &currentListLength);
+    if (currentListLength > 0) {
+        if (util::greater(voltage * currentList[i % currentListLength], channel_dispatcher::getPowerMaxLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
+            SCPI_ErrorPush(context, SCPI_ERROR_POWER_LIMIT_EXCEEDED);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 scpi_result_t scpi_cmd_sourceListVoltageLevel(scpi_t *context) {
     Channel *channel = set_channel_from_command_number(context);
     if (!channel) {
         return SCPI_RES_ERR;
     }
 
+    if (is_arbitrary_block_param(context)) {
+        // binary block is validated and then decoded directly into the channel list
+        const uint8_t *block;
+        uint16_t listLength;
+        bool bigEndian;
+        if (!get_list_block_param(context, block, listLength, bigEndian)) {
+            return SCPI_RES_ERR;
+        }
+
+        for (int i = 0; i < listLength; ++i) {
+            if (!checkVoltageListValue(context, *channel, util::getFloat(block + i * sizeof(float), bigEndian), i)) {
+                return SCPI_RES_ERR;
+            }
+        }
+
+        if (!trigger::isIdle()) {
+            SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+            return SCPI_RES_ERR;
+        }
+
+        list::setVoltageListFromBlock(*channel, block, listLength, bigEndian);
+        profile::save();
+
+        return SCPI_RES_OK;
+    }
+
     float list[MAX_LIST_LENGTH];
     uint16_t listLength = 0;
 
-    uint16_t currentListLength;
-    float *currentList = list::getCurrentList(*channel, &currentListLength);
-
     for (int i = 0; ; ++i) {
         scpi_number_t param;
         if (!SCPI_ParamNumber(context, 0, &param, false)) {
@@ -1180,16 +1622,8 @@ scpi_result_t scpi_cmd_sourceListVoltageLevel(scpi_t *context) {
             return SCPI_RES_ERR;
         }
 
-	    if (util::greater(voltage, channel_dispatcher::getUMaxLimit(*channel), getPrecision(VALUE_TYPE_FLOAT_VOLT))) {
-            SCPI_ErrorPush(context, SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED);
+        if (!checkVoltageListValue(context, *channel, voltage, i)) {
             return SCPI_RES_ERR;
-	    }
-
-        if (currentListLength > 0) {
-            if (util::greater(voltage * currentList[i % currentListLength], channel_dispatcher::getPowerMaxLimit(*channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
-                SCPI_ErrorPush(context, SCPI_ERROR_POWER_LIMIT_EXCEEDED);
-                return SCPI_RES_ERR;
-            }
         }
 
         list[listLength++] = voltage;
@@ -1219,9 +1653,7 @@ scpi_result_t scpi_cmd_sourceListVoltageLevelQ(scpi_t *context) {
 
     uint16_t listLength;
     float *list = list::getVoltageList(*channel, &listLength);
-    SCPI_ResultArrayFloat(context, list, listLength, SCPI_FORMAT_ASCII);
-
-    return SCPI_RES_OK;
+    return result_float_list(context, list, listLength);
 }
 
 }
@@ -32,6 +32,7 @@
 #include "gui.h"
 #endif
 #include "io_pins.h"
+#include "stream.h"
 
 namespace eez {
 namespace psu {
@@ -385,7 +386,7 @@ scpi_result_t scpi_cmd_systemTemperatureProtectionHighDelayTimeQ(scpi_t *context
 		return SCPI_RES_ERR;
     }
 
-    SCPI_ResultFloat(context, temperature::sensors[sensor].prot_conf.delay);
+    result_float(context, temperature::sensors[sensor].prot_conf.delay);
 
     return SCPI_RES_OK;
 }
@@ -413,7 +414,7 @@ scpi_result_t scpi_cmd_systemChannelInformationCurrentQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    SCPI_ResultFloat(context, channel_dispatcher::getIMax(*channel));
+    result_float(context, channel_dispatcher::getIMax(*channel));
 
     return SCPI_RES_OK;
 }
@@ -424,7 +425,7 @@ scpi_result_t scpi_cmd_systemChannelInformationPowerQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    SCPI_ResultFloat(context, channel->PTOT);
+    result_float(context, channel->PTOT);
 
     return SCPI_RES_OK;
 }
@@ -503,7 +504,7 @@ scpi_result_t scpi_cmd_systemChannelInformationVoltageQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    SCPI_ResultFloat(context, channel_dispatcher::getUMax(*channel));
+    result_float(context, channel_dispatcher::getUMax(*channel));
 
     return SCPI_RES_OK;
 }
@@ -859,6 +860,70 @@ scpi_result_t scpi_cmd_systemCommunicateSerialParityQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_systemCommunicateStreamState(scpi_t *context) {
+    bool enable;
+    if (!SCPI_ParamBool(context, &enable, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (enable) {
+        if (!stream::start(*context)) {
+            // only one connection at a time can receive the stream
+            SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+            return SCPI_RES_ERR;
+        }
+    } else {
+        stream::stop(*context);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_systemCommunicateStreamStateQ(scpi_t *context) {
+    SCPI_ResultBool(context, stream::isActive(*context));
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_systemCommunicateStreamChannel(scpi_t *context) {
+    uint8_t channels;
+    if (!param_channels(context, channels)) {
+        return SCPI_RES_ERR;
+    }
+
+    stream::setChannels(channels);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_systemCommunicateStreamChannelQ(scpi_t *context) {
+    uint8_t channels = stream::getChannels();
+    for (int i = 0; i < CH_NUM; ++i) {
+        if (channels & (1 << i)) {
+            char buffer[8];
+            sprintf_P(buffer, PSTR("CH%d"), i + 1);
+            SCPI_ResultCharacters(context, buffer, strlen(buffer));
+        }
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_systemCommunicateStreamPeriod(scpi_t *context) {
+    float period;
+    if (!get_duration_param(context, period, stream::PERIOD_MIN, stream::PERIOD_MAX, stream::PERIOD_DEFAULT)) {
+        return SCPI_RES_ERR;
+    }
+
+    stream::setPeriod(period);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_systemCommunicateStreamPeriodQ(scpi_t *context) {
+    result_float(context, stream::getPeriod());
+    return SCPI_RES_OK;
+}
+
 // NONE|ODD|EVEN
 static scpi_choice_def_t commInterfaceChoice[] = {
     { "SERial", 1 },
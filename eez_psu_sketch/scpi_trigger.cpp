@@ -23,6 +23,7 @@
 #include "io_pins.h"
 #include "channel_dispatcher.h"
 #include "profile.h"
+#include "threshold.h"
 #if OPTION_SD_CARD
 #include "dlog.h"
 #endif
@@ -38,6 +39,7 @@ static scpi_choice_def_t sourceChoice[] = {
     { "IMMediate", trigger::SOURCE_IMMEDIATE },
     { "MANual", trigger::SOURCE_MANUAL },
     { "PIN1", trigger::SOURCE_PIN1 },
+    { "THReshold", trigger::SOURCE_THRESHOLD },
     SCPI_CHOICE_LIST_END
 };
 
@@ -66,7 +68,7 @@ scpi_result_t scpi_cmd_triggerSequenceDelay(scpi_t * context) {
 }
 
 scpi_result_t scpi_cmd_triggerSequenceDelayQ(scpi_t * context) {
-    SCPI_ResultFloat(context, trigger::getDelay());
+    result_float(context, trigger::getDelay());
     return SCPI_RES_OK;
 }
 
@@ -133,6 +135,81 @@ scpi_result_t scpi_cmd_triggerSequenceExitConditionQ(scpi_t * context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_triggerLatencyQ(scpi_t * context) {
+    uint32_t min = 0;
+    uint32_t mean = 0;
+    uint32_t max = 0;
+    uint32_t count = 0;
+    trigger::getLatency(min, mean, max, count);
+
+    // min, mean and max in seconds, followed by the number of triggers
+    result_float(context, min / 1000000.0f);
+    result_float(context, mean / 1000000.0f);
+    result_float(context, max / 1000000.0f);
+    SCPI_ResultInt(context, count);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_triggerThresholdDefine(scpi_t * context) {
+    Channel *channel = param_channel(context, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t function;
+    if (!SCPI_ParamChoice(context, threshold_function_choice, &function, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t condition = threshold::CONDITION_RISING;
+    float level = 0;
+    float hysteresis = 0;
+
+    if (function != threshold::FUNCTION_NONE) {
+        if (!get_threshold_condition_param(context, *channel, function, condition, level, hysteresis)) {
+            return SCPI_RES_ERR;
+        }
+    }
+
+    threshold::setCondition(*channel, (threshold::Function)function, (threshold::Condition)condition, level, hysteresis);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_triggerThresholdDefineQ(scpi_t * context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    threshold::Function function;
+    threshold::Condition condition;
+    float level;
+    float hysteresis;
+    threshold::getCondition(*channel, function, condition, level, hysteresis);
+
+    resultChoiceName(context, threshold_function_choice, function);
+    if (function != threshold::FUNCTION_NONE) {
+        resultChoiceName(context, threshold_condition_choice, condition);
+        result_float(context, level);
+        result_float(context, hysteresis);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_triggerThresholdStateQ(scpi_t * context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBool(context, threshold::isConditionMet(*channel));
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_initiateImmediate(scpi_t * context) {
     int result = trigger::initiate();
     if (result != SCPI_RES_OK) {
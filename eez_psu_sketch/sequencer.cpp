@@ -0,0 +1,318 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "psu.h"
+#include "sequencer.h"
+#include "channel_dispatcher.h"
+#include "persist_conf.h"
+#include "io_pins.h"
+
+#if OPTION_SD_CARD
+#include "dlog.h"
+#endif
+
+namespace eez {
+namespace psu {
+namespace sequencer {
+
+static Step g_steps[MAX_SEQUENCER_STEPS];
+
+// index of the current step, -1 if sequence is not running
+static int g_currentStep = -1;
+// if previous step waited for the time, this is the planned
+// and not the actual start time, so the timing errors are not accumulated
+static uint32_t g_stepStartTime;
+static volatile bool g_triggerReceived;
+
+// condition of the current WAIT_THRESHOLD step, it is evaluated
+// from onMonValue while armed
+static threshold::Detector g_threshold;
+static volatile bool g_thresholdArmed;
+
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+// pulses on the digital output pins 2 and 3 (see ACTION_PULSE)
+static struct {
+    bool active;
+    uint32_t startTime;
+    uint32_t width;
+} g_pulses[2];
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+void init() {
+    clear();
+}
+
+void reset() {
+    abort();
+    clear();
+}
+
+void clear() {
+    for (int i = 0; i < MAX_SEQUENCER_STEPS; ++i) {
+        Step &step = g_steps[i];
+
+        step.wait = WAIT_NONE;
+        step.waitSource = trigger::SOURCE_BUS;
+        step.waitChannelIndex = 0;
+        step.waitFunction = threshold::FUNCTION_VOLTAGE;
+        step.waitCondition = threshold::CONDITION_RISING;
+        step.waitHysteresis = 0;
+        step.waitValue = 0;
+
+        step.action = ACTION_NONE;
+        step.actionTarget = 0;
+        step.actionValue = 0;
+
+        step.next = i + 1 < MAX_SEQUENCER_STEPS ? i + 2 : 0;
+    }
+}
+
+void getStep(int stepNumber, Step &step) {
+    step = g_steps[stepNumber - 1];
+}
+
+void setStep(int stepNumber, const Step &step) {
+    g_steps[stepNumber - 1] = step;
+}
+
+static void startStep(int stepIndex, uint32_t startTime) {
+    g_thresholdArmed = false;
+
+    g_stepStartTime = startTime;
+    g_triggerReceived = false;
+    g_currentStep = stepIndex;
+
+    const Step &step = g_steps[stepIndex];
+    if (step.wait == WAIT_THRESHOLD) {
+        // crossing is detected only from the values measured within the step
+        g_threshold.setCondition(step.waitFunction, step.waitCondition, step.waitValue, step.waitHysteresis);
+        g_thresholdArmed = true;
+    }
+}
+
+void initiate() {
+    startStep(0, micros());
+}
+
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+static void endPulse(int i) {
+    g_pulses[i].active = false;
+    io_pins::setDigitalOutputPinState(i + 2, false);
+}
+#endif
+
+void abort() {
+    g_thresholdArmed = false;
+    g_currentStep = -1;
+
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+    for (int i = 0; i < 2; ++i) {
+        if (g_pulses[i].active) {
+            endPulse(i);
+        }
+    }
+#endif
+}
+
+bool isRunning() {
+    return g_currentStep != -1;
+}
+
+int getCurrentStepNumber() {
+    return g_currentStep + 1;
+}
+
+bool triggerGenerated(trigger::Source source) {
+    int stepIndex = g_currentStep;
+    if (stepIndex != -1 && g_steps[stepIndex].wait == WAIT_TRIGGER && g_steps[stepIndex].waitSource == source) {
+        g_triggerReceived = true;
+        return true;
+    }
+    return false;
+}
+
+void onMonValue(Channel &channel, threshold::Function measured) {
+    int stepIndex = g_currentStep;
+    if (!g_thresholdArmed || stepIndex == -1 || g_steps[stepIndex].waitChannelIndex != channel.index - 1) {
+        return;
+    }
+
+    bool metChanged;
+    if (g_threshold.onMonValue(channel, measured, metChanged)) {
+        g_triggerReceived = true;
+    }
+}
+
+void resetThresholdState(Channel &channel) {
+    int stepIndex = g_currentStep;
+    if (g_thresholdArmed && stepIndex != -1 && g_steps[stepIndex].waitChannelIndex == channel.index - 1) {
+        g_threshold.resetState();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Returns true if the wait condition of the step is met and the time
+/// from which the next step is timed.
+static bool isWaitConditionMet(const Step &step, uint32_t tick_usec, uint32_t &time) {
+    if (step.wait == WAIT_NONE) {
+        time = g_stepStartTime;
+        return true;
+    }
+
+    if (step.wait == WAIT_TIME) {
+        uint32_t waitTime = (uint32_t)round(step.waitValue * 1000000L);
+        if (tick_usec - g_stepStartTime >= waitTime) {
+            time = g_stepStartTime + waitTime;
+            return true;
+        }
+        return false;
+    }
+
+    // WAIT_TRIGGER or WAIT_THRESHOLD
+    if (g_triggerReceived) {
+        time = tick_usec;
+        return true;
+    }
+
+    return false;
+}
+
+static int executeAction(const Step &step) {
+    if (step.action == ACTION_SET_VOLTAGE || step.action == ACTION_SET_CURRENT || step.action == ACTION_OUTPUT) {
+        Channel &channel = Channel::get(step.actionTarget);
+
+        if (channel_dispatcher::getVoltageTriggerMode(channel) != TRIGGER_MODE_FIXED && !trigger::isIdle()) {
+            return SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER;
+        }
+
+        // levels are set by the remote programming input while it is enabled
+        if (step.action != ACTION_OUTPUT && channel.isRemoteProgrammingEnabled()) {
+            return SCPI_ERROR_EXECUTION_ERROR;
+        }
+
+        if (step.action == ACTION_SET_VOLTAGE) {
+            if (util::greater(step.actionValue, channel_dispatcher::getULimit(channel), getPrecision(VALUE_TYPE_FLOAT_VOLT))) {
+                return SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
+            }
+
+            if (util::greater(step.actionValue * channel_dispatcher::getISetUnbalanced(channel), channel_dispatcher::getPowerLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
+                return SCPI_ERROR_POWER_LIMIT_EXCEEDED;
+            }
+
+            channel_dispatcher::setVoltage(channel, step.actionValue);
+        } else if (step.action == ACTION_SET_CURRENT) {
+            if (util::greater(step.actionValue, channel_dispatcher::getILimit(channel), getPrecision(VALUE_TYPE_FLOAT_AMPER))) {
+                return SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
+            }
+
+            if (util::greater(step.actionValue * channel_dispatcher::getUSetUnbalanced(channel), channel_dispatcher::getPowerLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
+                return SCPI_ERROR_POWER_LIMIT_EXCEEDED;
+            }
+
+            channel_dispatcher::setCurrent(channel, step.actionValue);
+        } else {
+            bool enable = step.actionValue != 0;
+            if (enable && channel_dispatcher::isTripped(channel)) {
+                return SCPI_ERROR_CANNOT_EXECUTE_BEFORE_CLEARING_PROTECTION;
+            }
+
+            channel_dispatcher::outputEnable(channel, enable);
+        }
+    } else if (step.action == ACTION_TRIGGER) {
+        int err = trigger::startImmediately();
+        if (err != SCPI_RES_OK) {
+            return err;
+        }
+    } else if (step.action == ACTION_DLOG) {
+#if OPTION_SD_CARD
+        if (!dlog::isInitiated()) {
+            return SCPI_ERROR_TRIGGER_IGNORED;
+        }
+        dlog::triggerGenerated();
+#else
+        return SCPI_ERROR_HARDWARE_MISSING;
+#endif
+    } else if (step.action == ACTION_PULSE) {
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+        int pin = step.actionTarget;
+        if (persist_conf::devConf2.ioPins[pin - 1].function != io_pins::FUNCTION_OUTPUT) {
+            return SCPI_ERROR_DIGITAL_PIN_FUNCTION_MISMATCH;
+        }
+
+        io_pins::setDigitalOutputPinState(pin, true);
+
+        g_pulses[pin - 2].active = true;
+        g_pulses[pin - 2].startTime = micros();
+        g_pulses[pin - 2].width = (uint32_t)round(step.actionValue * 1000000L);
+#else
+        return SCPI_ERROR_HARDWARE_MISSING;
+#endif
+    }
+
+    return 0;
+}
+
+void tick(uint32_t tick_usec) {
+#if EEZ_PSU_SELECTED_REVISION == EEZ_PSU_REVISION_R5B12
+    for (int i = 0; i < 2; ++i) {
+        if (g_pulses[i].active && tick_usec - g_pulses[i].startTime >= g_pulses[i].width) {
+            endPulse(i);
+        }
+    }
+#endif
+
+    // steps are executed one after another in the same tick as long as their
+    // wait conditions are met, but at most MAX_SEQUENCER_STEPS of them,
+    // so the endless loop of the steps without the wait condition doesn't block
+    for (int n = 0; g_currentStep != -1 && n < MAX_SEQUENCER_STEPS; ++n) {
+        const Step &step = g_steps[g_currentStep];
+
+        if (step.wait == WAIT_NONE && step.action == ACTION_NONE) {
+            g_currentStep = -1;
+            return;
+        }
+
+        uint32_t time;
+        if (!isWaitConditionMet(step, tick_usec, time)) {
+            return;
+        }
+
+        g_thresholdArmed = false;
+
+        int err = executeAction(step);
+        if (err) {
+            generateError(err);
+            abort();
+            return;
+        }
+
+        if (step.next == 0) {
+            g_currentStep = -1;
+            return;
+        }
+
+        startStep(step.next - 1, time);
+    }
+}
+
+}
+}
+} // namespace eez::psu::sequencer
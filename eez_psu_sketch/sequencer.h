@@ -0,0 +1,116 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "trigger.h"
+#include "threshold.h"
+
+namespace eez {
+namespace psu {
+/// Trigger sequencer, executes the table of steps without host involvement.
+/// Each step waits for its condition, executes its action and continues
+/// with the next step. Sequence ends with the step which has no wait
+/// condition and no action or with the step which next step is 0.
+namespace sequencer {
+
+static const float WAIT_TIME_MIN = 0;
+static const float WAIT_TIME_MAX = 3600.0f;
+
+static const float PULSE_WIDTH_MIN = 0.001f;
+static const float PULSE_WIDTH_MAX = 3600.0f;
+
+enum WaitCondition {
+    WAIT_NONE,
+    /// Wait for the time from the start of the step.
+    WAIT_TIME,
+    /// Wait for the trigger from the given source (BUS, MANUAL or PIN1).
+    WAIT_TRIGGER,
+    /// Wait until the threshold condition of the step is met on the measured
+    /// values of its channel, the condition is detected as by the threshold
+    /// module, but independently of the TRIGger:THReshold conditions.
+    WAIT_THRESHOLD
+};
+
+enum Action {
+    ACTION_NONE,
+    ACTION_SET_VOLTAGE,
+    ACTION_SET_CURRENT,
+    ACTION_OUTPUT,
+    /// Starts the transient trigger (list or step) immediately.
+    ACTION_TRIGGER,
+    /// Triggers the initiated data logging.
+    ACTION_DLOG,
+    /// Active pulse on the digital output pin 2 or 3.
+    ACTION_PULSE
+};
+
+struct Step {
+    WaitCondition wait;
+    /// WAIT_TRIGGER
+    trigger::Source waitSource;
+    /// WAIT_THRESHOLD, zero based
+    uint8_t waitChannelIndex;
+    threshold::Function waitFunction;
+    threshold::Condition waitCondition;
+    float waitHysteresis;
+    /// Time in seconds for WAIT_TIME, level for WAIT_THRESHOLD.
+    float waitValue;
+
+    Action action;
+    /// Zero based channel index or pin number for ACTION_PULSE.
+    uint8_t actionTarget;
+    /// Level, output state or pulse width in seconds.
+    float actionValue;
+
+    /// One based step number, 0 means end of the sequence.
+    uint8_t next;
+};
+
+void init();
+void reset();
+
+/// Resets all the steps, next step of each is the following one.
+void clear();
+
+/// stepNumber is one based.
+void getStep(int stepNumber, Step &step);
+void setStep(int stepNumber, const Step &step);
+
+/// Starts the sequence from the first step.
+void initiate();
+void abort();
+bool isRunning();
+/// One based number of the current step, 0 if sequence is not running.
+int getCurrentStepNumber();
+
+/// Called when the trigger is generated, also from the interrupt handler.
+/// Returns true if the current step waits for this trigger.
+bool triggerGenerated(trigger::Source source);
+
+/// Called after the U_MON or I_MON of the channel is measured, it could be
+/// called from the interrupt (see threshold::onMonValue).
+void onMonValue(Channel &channel, threshold::Function measured);
+/// Called when the channel stops measuring the output (see threshold::resetState).
+void resetThresholdState(Channel &channel);
+
+void tick(uint32_t tick_usec);
+
+}
+}
+} // namespace eez::psu::sequencer
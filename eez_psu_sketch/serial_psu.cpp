@@ -33,7 +33,7 @@ psu::TestResult g_testResult = psu::TEST_FAILED;
 long g_bauds[] = {4800, 9600, 19200, 38400, 57600, 115200};
 size_t g_baudsSize = sizeof(g_bauds) / sizeof(long);
 
-size_t SCPI_Write(scpi_t *context, const char * data, size_t len) {
+static size_t writeSerial(scpi_t *context, const char * data, size_t len) {
 	size_t written = 0;
 
 	if (serial::g_testResult == TEST_OK) {
@@ -47,12 +47,20 @@ size_t SCPI_Write(scpi_t *context, const char * data, size_t len) {
 	return written;
 }
 
+size_t SCPI_Write(scpi_t *context, const char * data, size_t len) {
+    return writeBuffered(*context, data, len, writeSerial);
+}
+
 scpi_result_t SCPI_Flush(scpi_t *context) {
+    flushBuffered(*context, writeSerial);
     return SCPI_RES_OK;
 }
 
 int SCPI_Error(scpi_t *context, int_fast16_t err) {
     if (err != 0) {
+        // keep the order of the output
+        flushBuffered(*context, writeSerial);
+
         scpi::printError(err);
 
 		if (err == SCPI_ERROR_INPUT_BUFFER_OVERRUN) {
@@ -64,6 +72,8 @@ int SCPI_Error(scpi_t *context, int_fast16_t err) {
 }
 
 scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val) {
+    flushBuffered(*context, writeSerial);
+
     if (serial::g_testResult == TEST_OK) {
         char errorOutputBuffer[256];
         if (SCPI_CTRL_SRQ == ctrl) {
@@ -79,6 +89,8 @@ scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_
 }
 
 scpi_result_t SCPI_Reset(scpi_t *context) {
+    flushBuffered(*context, writeSerial);
+
     if (serial::g_testResult == TEST_OK) {
         char errorOutputBuffer[256];
         strcpy_P(errorOutputBuffer, PSTR("**Reset\r\n"));
@@ -102,6 +114,7 @@ static scpi_interface_t g_scpiInterface = {
 };
 
 static char g_scpiInputBuffer[SCPI_PARSER_INPUT_BUFFER_LENGTH];
+static char g_scpiOutputBuffer[SCPI_PARSER_OUTPUT_BUFFER_LENGTH];
 static int16_t g_errorQueueData[SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
 
 scpi_t g_scpiContext;
@@ -153,6 +166,7 @@ void init() {
         g_scpiPsuContext,
         &g_scpiInterface,
         g_scpiInputBuffer, SCPI_PARSER_INPUT_BUFFER_LENGTH,
+        g_scpiOutputBuffer, SCPI_PARSER_OUTPUT_BUFFER_LENGTH,
         g_errorQueueData, SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
 
     g_testResult = TEST_OK;
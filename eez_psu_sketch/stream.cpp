@@ -0,0 +1,219 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "psu.h"
+#include "stream.h"
+
+namespace eez {
+namespace psu {
+namespace stream {
+
+struct Frame {
+    uint16_t sequence;
+    uint8_t channels;
+    uint32_t timestamp;
+    float values[CH_MAX * 3];
+};
+
+/// If there is no ADC reading for this long after the period is elapsed,
+/// (e.g. output is disabled on all the selected channels) frame is captured
+/// from the tick with the last measured values.
+#define IDLE_TIMEOUT_US (4 * ADC_READ_TIME_US)
+
+#define FRAME_HEADER_SIZE 8
+#define MAX_FRAME_SIZE (4 + FRAME_HEADER_SIZE + CH_MAX * 3 * 4)
+
+static scpi_t *g_context;
+static uint8_t g_channels = 1;
+static float g_period = PERIOD_DEFAULT;
+static uint32_t g_periodUs = (uint32_t)(PERIOD_DEFAULT * 1000000L);
+
+// single producer (ADC) single consumer (tick) ring buffer,
+// head is changed only by the producer and tail only by the consumer
+static Frame g_frames[STREAM_FRAME_BUFFER_SIZE];
+static volatile uint8_t g_head;
+static volatile uint8_t g_tail;
+
+static uint16_t g_sequence;
+static volatile uint32_t g_lastCaptureTime;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void capture(uint32_t time) {
+    g_lastCaptureTime = time;
+
+    uint8_t head = g_head;
+    uint8_t next = (head + 1) % STREAM_FRAME_BUFFER_SIZE;
+    if (next == g_tail) {
+        // buffer is full, frame is dropped and client will see the gap in the sequence
+        ++g_sequence;
+        return;
+    }
+
+    Frame &frame = g_frames[head];
+
+    frame.sequence = g_sequence++;
+    frame.channels = g_channels;
+    frame.timestamp = time;
+
+    int n = 0;
+    for (int i = 0; i < CH_NUM; ++i) {
+        if (g_channels & (1 << i)) {
+            Channel &channel = Channel::get(i);
+            frame.values[n++] = channel.u.mon_last;
+            frame.values[n++] = channel.i.mon_last;
+            frame.values[n++] = channel.u.mon_last * channel.i.mon_last;
+        }
+    }
+
+    g_head = next;
+}
+
+static uint8_t *putUint16(uint8_t *p, uint16_t value) {
+    *p++ = (uint8_t)value;
+    *p++ = (uint8_t)(value >> 8);
+    return p;
+}
+
+static uint8_t *putUint32(uint8_t *p, uint32_t value) {
+    p = putUint16(p, (uint16_t)value);
+    return putUint16(p, (uint16_t)(value >> 16));
+}
+
+static uint8_t *putFloat(uint8_t *p, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return putUint32(p, bits);
+}
+
+static size_t encodeFrame(const Frame &frame, uint8_t *buffer) {
+    int numValues = 0;
+    for (int i = 0; i < CH_NUM; ++i) {
+        if (frame.channels & (1 << i)) {
+            numValues += 3;
+        }
+    }
+
+    size_t payloadSize = FRAME_HEADER_SIZE + numValues * 4;
+
+    char header[8];
+    char length[4];
+    sprintf(length, "%d", (int)payloadSize);
+    sprintf(header, "#%d%s", (int)strlen(length), length);
+    size_t headerSize = strlen(header);
+    memcpy(buffer, header, headerSize);
+
+    uint8_t *p = buffer + headerSize;
+    p = putUint16(p, frame.sequence);
+    *p++ = frame.channels;
+    *p++ = 0;
+    p = putUint32(p, frame.timestamp);
+    for (int i = 0; i < numValues; ++i) {
+        p = putFloat(p, frame.values[i]);
+    }
+
+    return p - buffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool start(scpi_t &context) {
+    if (g_context && g_context != &context) {
+        return false;
+    }
+
+    if (!g_context) {
+        g_tail = g_head;
+        g_lastCaptureTime = micros() - g_periodUs;
+        g_context = &context;
+    }
+
+    return true;
+}
+
+void stop(scpi_t &context) {
+    if (g_context == &context) {
+        g_context = 0;
+    }
+}
+
+bool isActive(scpi_t &context) {
+    return g_context == &context;
+}
+
+void setChannels(uint8_t channels) {
+    g_channels = channels;
+}
+
+uint8_t getChannels() {
+    return g_channels;
+}
+
+void setPeriod(float period) {
+    g_period = period;
+    g_periodUs = (uint32_t)(period * 1000000L);
+}
+
+float getPeriod() {
+    return g_period;
+}
+
+void onMonValues(Channel &channel) {
+    if (!g_context || !(g_channels & (1 << (channel.index - 1)))) {
+        return;
+    }
+
+    uint32_t time = micros();
+    if (time - g_lastCaptureTime >= g_periodUs) {
+        capture(time);
+    }
+}
+
+void tick(uint32_t tick_usec) {
+    if (!g_context) {
+        return;
+    }
+
+    if (tick_usec - g_lastCaptureTime >= g_periodUs + IDLE_TIMEOUT_US) {
+#if ADC_USE_INTERRUPTS
+        noInterrupts();
+#endif
+        capture(tick_usec);
+#if ADC_USE_INTERRUPTS
+        interrupts();
+#endif
+    }
+
+    if (g_tail == g_head) {
+        return;
+    }
+
+    // all the frames are written into the connection output buffer and sent at once
+    while (g_tail != g_head) {
+        uint8_t buffer[MAX_FRAME_SIZE];
+        size_t size = encodeFrame(g_frames[g_tail], buffer);
+        g_context->interface->write(g_context, (const char *)buffer, size);
+        g_tail = (g_tail + 1) % STREAM_FRAME_BUFFER_SIZE;
+    }
+
+    g_context->interface->flush(g_context);
+}
+
+}
+}
+} // namespace eez::psu::stream
@@ -0,0 +1,65 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "scpi_psu.h"
+
+namespace eez {
+namespace psu {
+/// Push based streaming of the measured values to one SCPI connection.
+///
+/// Each frame is sent as IEEE 488.2 definite length block, for example
+/// "#236" followed by 36 bytes, with the following little endian payload:
+///
+///     uint16_t sequence;    incremented for each captured frame, gaps mean dropped frames
+///     uint8_t channels;     bit mask of the channels in this frame, bit 0 is CH1
+///     uint8_t reserved;
+///     uint32_t timestamp;   microseconds, wraps around
+///     float u, i, p;        for each channel in the mask, in the channel order
+namespace stream {
+
+static const float PERIOD_MIN = 0.0f;
+static const float PERIOD_MAX = 60.0f;
+static const float PERIOD_DEFAULT = 0.1f;
+
+/// Starts streaming to the given connection.
+/// Returns false if some other connection is already streaming.
+bool start(scpi_t &context);
+/// Stops streaming if it is active on the given connection.
+void stop(scpi_t &context);
+bool isActive(scpi_t &context);
+
+/// Channels bit mask, bit 0 is CH1.
+void setChannels(uint8_t channels);
+uint8_t getChannels();
+
+/// Min. time between two frames in seconds, 0 means every ADC reading.
+void setPeriod(float period);
+float getPeriod();
+
+/// Called after both U and I of the channel are measured, it could be
+/// called from the interrupt.
+void onMonValues(Channel &channel);
+
+/// Sends all the captured frames.
+void tick(uint32_t tick_usec);
+
+}
+}
+} // namespace eez::psu::stream
@@ -0,0 +1,167 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "psu.h"
+#include "threshold.h"
+#include "trigger.h"
+#include "scpi_regs.h"
+
+namespace eez {
+namespace psu {
+namespace threshold {
+
+enum State {
+    STATE_UNKNOWN,
+    STATE_HIGH,
+    STATE_LOW
+};
+
+static Detector g_conditions[CH_MAX];
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Detector::setCondition(Function function_, Condition condition_, float level_, float hysteresis_) {
+    state = STATE_UNKNOWN;
+
+    function = function_;
+    condition = condition_;
+    level = level_;
+    hysteresis = hysteresis_;
+
+    if (condition == CONDITION_RISING || condition == CONDITION_ABOVE) {
+        upper = level;
+        lower = level - hysteresis;
+    } else {
+        upper = level + hysteresis;
+        lower = level;
+    }
+}
+
+bool Detector::isConditionMet() {
+    if (condition == CONDITION_RISING || condition == CONDITION_ABOVE) {
+        return state == STATE_HIGH;
+    }
+    return state == STATE_LOW;
+}
+
+bool Detector::resetState() {
+    bool wasMet = isConditionMet();
+    state = STATE_UNKNOWN;
+    return wasMet;
+}
+
+bool Detector::onMonValue(Channel &channel, Function measured, bool &metChanged) {
+    metChanged = false;
+
+    if (function == FUNCTION_NONE) {
+        return false;
+    }
+
+    float value;
+    if (function == FUNCTION_VOLTAGE) {
+        if (measured != FUNCTION_VOLTAGE) {
+            return false;
+        }
+        value = channel.u.mon_last;
+    } else {
+        // power is evaluated when the current is measured,
+        // with the voltage from the previous conversion
+        if (measured != FUNCTION_CURRENT) {
+            return false;
+        }
+        value = function == FUNCTION_CURRENT ? channel.i.mon_last : channel.u.mon_last * channel.i.mon_last;
+    }
+
+    State newState;
+    if (value > upper) {
+        newState = STATE_HIGH;
+    } else if (value < lower) {
+        newState = STATE_LOW;
+    } else if (state == STATE_UNKNOWN) {
+        // inside the hysteresis band at the start, which means the
+        // condition is not met and the next crossing is an edge
+        newState = condition == CONDITION_RISING || condition == CONDITION_ABOVE ? STATE_LOW : STATE_HIGH;
+    } else {
+        newState = (State)state;
+    }
+
+    bool wasMet = isConditionMet();
+    State previousState = (State)state;
+    state = newState;
+    bool met = isConditionMet();
+    metChanged = met != wasMet;
+
+    if (condition == CONDITION_RISING || condition == CONDITION_FALLING) {
+        // edge requires the known state before the crossing
+        return metChanged && met && previousState != STATE_UNKNOWN;
+    }
+
+    // level condition keeps firing while it is met, so the trigger
+    // initiated after the crossing is not missed
+    return met;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void setCondition(Channel &channel, Function function, Condition condition, float level, float hysteresis) {
+    resetState(channel);
+    g_conditions[channel.index - 1].setCondition(function, condition, level, hysteresis);
+}
+
+void getCondition(Channel &channel, Function &function, Condition &condition, float &level, float &hysteresis) {
+    Detector &detector = g_conditions[channel.index - 1];
+    function = detector.function;
+    condition = detector.condition;
+    level = detector.level;
+    hysteresis = detector.hysteresis;
+}
+
+bool isConditionMet(Channel &channel) {
+    return g_conditions[channel.index - 1].isConditionMet();
+}
+
+void reset() {
+    for (int i = 0; i < CH_NUM; ++i) {
+        setCondition(Channel::get(i), FUNCTION_NONE, CONDITION_RISING, 0, 0);
+    }
+}
+
+void onMonValue(Channel &channel, Function measured) {
+    Detector &detector = g_conditions[channel.index - 1];
+
+    bool metChanged;
+    bool fired = detector.onMonValue(channel, measured, metChanged);
+
+    if (metChanged) {
+        channel.setOperBits(OPER_ISUM_THR, detector.isConditionMet());
+    }
+
+    if (fired) {
+        trigger::generateTrigger(trigger::SOURCE_THRESHOLD, false);
+    }
+}
+
+void resetState(Channel &channel) {
+    if (g_conditions[channel.index - 1].resetState()) {
+        channel.setOperBits(OPER_ISUM_THR, false);
+    }
+}
+
+}
+}
+} // namespace eez::psu::threshold
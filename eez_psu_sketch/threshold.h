@@ -0,0 +1,100 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace eez {
+namespace psu {
+/// Measured threshold trigger conditions, one per channel.
+///
+/// Condition is evaluated for each U_MON and I_MON ADC conversion of the
+/// channel, so the reaction time is the ADC conversion period. When it is met
+/// the trigger from the trigger::SOURCE_THRESHOLD is generated (it could start
+/// the transient trigger, i.e. the list or the output change, or data logging)
+/// and OPER_ISUM_THR bit is set for the channel. The same detection, with
+/// its own condition, is used by the sequencer steps which wait for the threshold.
+namespace threshold {
+
+enum Function {
+    FUNCTION_NONE,
+    FUNCTION_VOLTAGE,
+    FUNCTION_CURRENT,
+    FUNCTION_POWER
+};
+
+enum Condition {
+    /// Trigger when the value crosses the level upwards.
+    CONDITION_RISING,
+    /// Trigger when the value crosses the level downwards.
+    CONDITION_FALLING,
+    /// Trigger for each measurement while the value is above the level.
+    CONDITION_ABOVE,
+    /// Trigger for each measurement while the value is below the level.
+    CONDITION_BELOW
+};
+
+/// Detects one condition on the measured values of one channel.
+/// Hysteresis is below the level for the CONDITION_RISING and CONDITION_ABOVE
+/// and above the level for the CONDITION_FALLING and CONDITION_BELOW, i.e.
+/// condition is met again only after the value returns over the hysteresis band.
+struct Detector {
+    Function function;
+    Condition condition;
+    float level;
+    float hysteresis;
+
+    // value is high above the upper and low below the lower limit,
+    // between the two it keeps the previous state
+    float upper;
+    float lower;
+    uint8_t state;
+
+    void setCondition(Function function, Condition condition, float level, float hysteresis);
+
+    /// Is condition currently met?
+    bool isConditionMet();
+
+    /// Forgets the previous value, so the edge needs the known state first.
+    /// Returns true if isConditionMet is changed.
+    bool resetState();
+
+    /// Takes the U_MON (FUNCTION_VOLTAGE) or I_MON (FUNCTION_CURRENT) value of the
+    /// channel, metChanged is set if isConditionMet is changed. Returns true when
+    /// condition fires: at the crossing for the CONDITION_RISING and CONDITION_FALLING
+    /// and for each value while it is met for the CONDITION_ABOVE and CONDITION_BELOW.
+    bool onMonValue(Channel &channel, Function measured, bool &metChanged);
+};
+
+void setCondition(Channel &channel, Function function, Condition condition, float level, float hysteresis);
+void getCondition(Channel &channel, Function &function, Condition &condition, float &level, float &hysteresis);
+
+/// Is condition currently met?
+bool isConditionMet(Channel &channel);
+
+void reset();
+
+/// Called after the U_MON (FUNCTION_VOLTAGE) or I_MON (FUNCTION_CURRENT)
+/// of the channel is measured, it could be called from the interrupt.
+void onMonValue(Channel &channel, Function measured);
+
+/// Called when the channel stops measuring the output, i.e. output is disabled.
+void resetState(Channel &channel);
+
+}
+}
+} // namespace eez::psu::threshold
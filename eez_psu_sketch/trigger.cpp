@@ -24,6 +24,8 @@
 #include "persist_conf.h"
 #include "io_pins.h"
 #include "scpi_regs.h"
+#include "calibration.h"
+#include "sequencer.h"
 
 #if OPTION_SD_CARD
 #include "dlog.h"
@@ -50,6 +52,138 @@ static uint8_t g_extTrigLastState;
 
 bool g_triggerInProgress[CH_MAX];
 
+// Fast trigger path: while initiated with PIN1 source and no delay, DAC codes
+// of the channels in the step mode are prepared in advance and written directly
+// from the PIN1 interrupt handler. Everything else (list start, output enable,
+// current range switch, ...) is still done by startImmediately from the trigger task.
+static struct {
+    bool armed;
+    struct {
+        bool prepared;
+        float u;
+        float i;
+        uint16_t uDacCode;
+        uint16_t iDacCode;
+        uint8_t currentRange;
+    } channels[CH_MAX];
+} g_fastPath;
+
+// micros() of the last PIN1 edge which triggered the sequence
+static uint32_t g_edgeTime;
+static volatile bool g_edgeLatencyPending;
+
+static struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t count;
+} g_latency;
+
+static void updateLatency(uint32_t latency) {
+    if (g_latency.count == 0 || latency < g_latency.min) {
+        g_latency.min = latency;
+    }
+    if (latency > g_latency.max) {
+        g_latency.max = latency;
+    }
+    g_latency.sum += latency;
+    ++g_latency.count;
+}
+
+static int checkLevelsLimits(Channel &channel) {
+    int i = channel.index - 1;
+
+	if (util::greater(g_levels[i].u, channel_dispatcher::getULimit(channel), getPrecision(VALUE_TYPE_FLOAT_VOLT))) {
+        return SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
+	}
+
+    if (util::greater(g_levels[i].i, channel_dispatcher::getILimit(channel), getPrecision(VALUE_TYPE_FLOAT_AMPER))) {
+        return SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
+	}
+
+	if (util::greater(g_levels[i].u * g_levels[i].i, channel_dispatcher::getPowerLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
+        return SCPI_ERROR_POWER_LIMIT_EXCEEDED;
+    }
+
+    return 0;
+}
+
+static void armFastPath() {
+    g_fastPath.armed = false;
+
+    if (persist_conf::devConf2.triggerSource != SOURCE_PIN1 || persist_conf::devConf2.triggerDelay != 0 ||
+        channel_dispatcher::isCoupled() || channel_dispatcher::isTracked() || calibration::isEnabled()) {
+        return;
+    }
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        Channel &channel = Channel::get(i);
+
+        g_fastPath.channels[i].prepared = false;
+
+        if (channel.getVoltageTriggerMode() != TRIGGER_MODE_STEP || channel.dac.isTesting() ||
+            channel.isOutputEnabled() != channel_dispatcher::getTriggerOutputState(channel)) {
+            continue;
+        }
+
+        uint8_t currentRange = channel.getCurrentRangeForValue(g_levels[i].i);
+        if (currentRange != channel.flags.currentCurrentRange) {
+            continue;
+        }
+
+        g_fastPath.channels[i].u = g_levels[i].u;
+        g_fastPath.channels[i].i = g_levels[i].i;
+        g_fastPath.channels[i].uDacCode = channel.getVoltageDacCode(g_levels[i].u);
+        g_fastPath.channels[i].iDacCode = channel.getCurrentDacCode(g_levels[i].i, currentRange);
+        g_fastPath.channels[i].currentRange = currentRange;
+        g_fastPath.channels[i].prepared = true;
+
+        g_fastPath.armed = true;
+    }
+}
+
+int checkTrigger();
+
+/// Called from the PIN1 interrupt handler.
+static void executeFastPath() {
+    if (persist_conf::devConf2.triggerSource != SOURCE_PIN1 || persist_conf::devConf2.triggerDelay != 0) {
+        return;
+    }
+
+    // limits, modes, lists and RPROG are changeable while initiated, so
+    // first check all the channels as startImmediately does and write nothing
+    // if the trigger would fail, startImmediately then reports the error
+    if (checkTrigger()) {
+        return;
+    }
+
+    bool executed = false;
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        Channel &channel = Channel::get(i);
+
+        // levels are changeable while initiated, channel which is not
+        // prepared any more is set by startImmediately
+        if (!g_fastPath.channels[i].prepared ||
+            g_fastPath.channels[i].u != g_levels[i].u || g_fastPath.channels[i].i != g_levels[i].i ||
+            g_fastPath.channels[i].currentRange != channel.flags.currentCurrentRange ||
+            channel.getVoltageTriggerMode() != TRIGGER_MODE_STEP ||
+            channel.isOutputEnabled() != channel_dispatcher::getTriggerOutputState(channel)) {
+            continue;
+        }
+
+        channel.setVoltage(g_fastPath.channels[i].u, g_fastPath.channels[i].uDacCode);
+        channel.setCurrent(g_fastPath.channels[i].i, g_fastPath.channels[i].currentRange, g_fastPath.channels[i].iDacCode);
+
+        executed = true;
+    }
+
+    if (executed) {
+        updateLatency(micros() - g_edgeTime);
+        g_edgeLatencyPending = false;
+    }
+}
+
 void setState(State newState) {
     if (g_state != newState) {
         if (newState == STATE_INITIATED) {
@@ -57,6 +191,8 @@ void setState(State newState) {
                 Channel& channel = Channel::get(i);
                 channel.setOperBits(OPER_ISUM_TRIG, true);
             }
+
+            armFastPath();
         }
 
         if (g_state == STATE_INITIATED) {
@@ -64,6 +200,8 @@ void setState(State newState) {
                 Channel& channel = Channel::get(i);
                 channel.setOperBits(OPER_ISUM_TRIG, false);
             }
+
+            g_fastPath.armed = false;
         }
 
         g_state = newState;
@@ -78,12 +216,29 @@ void reset() {
     persist_conf::saveDevice2();
 
     setState(STATE_IDLE);
+
+    g_edgeLatencyPending = false;
+    g_latency.count = 0;
+    g_latency.min = 0;
+    g_latency.max = 0;
+    g_latency.sum = 0;
 }
 
 void extTrigInterruptHandler() {
+    uint32_t edgeTime = micros();
+
     uint8_t state = digitalRead(EXT_TRIG);
     if (state == 1 && g_extTrigLastState == 0 && persist_conf::devConf2.ioPins[0].polarity == io_pins::POLARITY_POSITIVE ||
         state == 0 && g_extTrigLastState == 1 && persist_conf::devConf2.ioPins[0].polarity == io_pins::POLARITY_NEGATIVE) {
+        if (persist_conf::devConf2.triggerSource == SOURCE_PIN1 && g_state == STATE_INITIATED) {
+            g_edgeTime = edgeTime;
+            g_edgeLatencyPending = true;
+
+            if (g_fastPath.armed) {
+                executeFastPath();
+            }
+        }
+
         generateTrigger(SOURCE_PIN1, false);
     }
     g_extTrigLastState = state;
@@ -94,6 +249,8 @@ void init() {
 
     noInterrupts();
     g_extTrigLastState = digitalRead(EXT_TRIG);
+    // DAC is written from the interrupt handler (see executeFastPath)
+    SPI_usingInterrupt(digitalPinToInterrupt(EXT_TRIG));
     attachInterrupt(digitalPinToInterrupt(EXT_TRIG), extTrigInterruptHandler, CHANGE);
     interrupts();
 
@@ -145,8 +302,9 @@ int generateTrigger(Source source, bool checkImmediatelly) {
 #if OPTION_SD_CARD
 	bool dlogTriggered = dlog::g_triggerSource == source && dlog::isInitiated();
 #endif
+	bool sequencerTriggered = sequencer::triggerGenerated(source);
 
-	if (!seqTriggered) {
+	if (!seqTriggered && !sequencerTriggered) {
 #if OPTION_SD_CARD
 		if (!dlogTriggered) {
 			return SCPI_ERROR_TRIGGER_IGNORED;
@@ -268,16 +426,9 @@ int checkTrigger() {
                         return err;
                     }
                 } else {
-	                if (util::greater(g_levels[i].u, channel_dispatcher::getULimit(channel), getPrecision(VALUE_TYPE_FLOAT_VOLT))) {
-                        return SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
-	                }
-
-                    if (util::greater(g_levels[i].i, channel_dispatcher::getILimit(channel), getPrecision(VALUE_TYPE_FLOAT_AMPER))) {
-                        return SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
-	                }
-
-	                if (util::greater(g_levels[i].u * g_levels[i].i, channel_dispatcher::getPowerLimit(channel), getPrecision(VALUE_TYPE_FLOAT_WATT))) {
-                        return SCPI_ERROR_POWER_LIMIT_EXCEEDED;
+                    int err = checkLevelsLimits(channel);
+                    if (err) {
+                        return err;
                     }
                 }
 
@@ -296,6 +447,7 @@ int checkTrigger() {
 int startImmediately() {
     int err = checkTrigger();
     if (err) {
+        g_edgeLatencyPending = false;
         return err;
     }
 
@@ -330,6 +482,11 @@ int startImmediately() {
         }
     }
 
+    if (g_edgeLatencyPending) {
+        updateLatency(micros() - g_edgeTime);
+        g_edgeLatencyPending = false;
+    }
+
     return SCPI_RES_OK;
 }
 
@@ -370,6 +527,24 @@ bool isInitiated() {
 void abort() {
     list::abort();
     setState(STATE_IDLE);
+    g_edgeLatencyPending = false;
+}
+
+bool getLatency(uint32_t &min, uint32_t &mean, uint32_t &max, uint32_t &count) {
+    // updated from the interrupt handler
+    noInterrupts();
+
+    bool result = g_latency.count > 0;
+    if (result) {
+        min = g_latency.min;
+        mean = (uint32_t)(g_latency.sum / g_latency.count);
+        max = g_latency.max;
+        count = g_latency.count;
+    }
+
+    interrupts();
+
+    return result;
 }
 
 void tick(uint32_t tick_usec) {
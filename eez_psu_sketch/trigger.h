@@ -30,7 +30,9 @@ enum Source {
     SOURCE_BUS,
     SOURCE_IMMEDIATE,
     SOURCE_MANUAL,
-    SOURCE_PIN1
+    SOURCE_PIN1,
+    /// Measured threshold condition is met (see threshold.h).
+    SOURCE_THRESHOLD
 };
 
 void init();
@@ -58,6 +60,11 @@ bool isIdle();
 bool isInitiated();
 void abort();
 
+/// Latency from the PIN1 edge to the trigger action, i.e. setting
+/// the new levels, in microseconds. Returns false if there was no PIN1
+/// trigger yet.
+bool getLatency(uint32_t &min, uint32_t &mean, uint32_t &max, uint32_t &count);
+
 void tick(uint32_t tick_usec);
 
 }
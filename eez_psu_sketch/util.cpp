@@ -185,6 +185,24 @@ uint32_t crc32(const uint8_t *mem_block, size_t block_size) {
     return ~crc;
 }
 
+float getFloatLE(const uint8_t *data) {
+    uint32_t bits = data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+float getFloat(const uint8_t *data, bool bigEndian) {
+    if (!bigEndian) {
+        return getFloatLE(data);
+    }
+
+    uint32_t bits = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
 uint8_t toBCD(uint8_t bin) {
     return ((bin / 10) << 4) | (bin % 10);
 }
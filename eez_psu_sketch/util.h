@@ -53,6 +53,11 @@ void strcatLoad(char *str, float value);
 
 uint32_t crc32(const uint8_t *message, size_t size);
 
+/// Returns float stored as 4 bytes in the little-endian byte order.
+float getFloatLE(const uint8_t *data);
+/// Returns float stored as 4 bytes in the big-endian or little-endian byte order.
+float getFloat(const uint8_t *data, bool bigEndian);
+
 uint8_t toBCD(uint8_t bin);
 uint8_t fromBCD(uint8_t bcd);
 
@@ -162,6 +162,269 @@ static scpi_bool_t processCommand(scpi_t * context) {
     return result;
 }
 
+#if USE_COMMAND_INDEX && !USE_64K_PROGMEM_FOR_CMD_LIST && !USE_FULL_PROGMEM_FOR_CMD_LIST
+
+/*
+ * Command index maps the first two mnemonics of the command header to the
+ * list of commands (in command list order) whose pattern can match them.
+ * Only first INDEX_KEY_LENGTH characters of the mnemonic, without numeric
+ * suffix, are used, so short and long form of the mnemonic share the same
+ * key (except when short form is even shorter). Optional pattern nodes
+ * are handled by indexing the pattern under all possible first two nodes.
+ */
+
+#define INDEX_KEY_LENGTH 3
+#define INDEX_MAX_NODES 16
+#define INDEX_MAX_BUCKETS_PER_PATTERN 64
+
+typedef struct {
+    const char * ptr;
+    int len;
+    int short_len;
+    scpi_bool_t optional;
+} index_node_t;
+
+static const scpi_command_t * index_cmdlist = NULL;
+static uint16_t index_offsets[SCPI_COMMAND_INDEX_BUCKETS + 1];
+static uint16_t index_entries[SCPI_COMMAND_INDEX_MAX_ENTRIES];
+
+/**
+ * Length of the mnemonic without numeric suffix
+ */
+static int indexMnemonicLength(const char * ptr, int len) {
+    while ((len > 0) && isdigit((unsigned char) ptr[len - 1])) {
+        len--;
+    }
+    return len;
+}
+
+/**
+ * FNV-1a hash of the mnemonic key, case insensitive
+ */
+static uint32_t indexHashMnemonic(uint32_t hash, const char * ptr, int len) {
+    int i;
+
+    if (len > INDEX_KEY_LENGTH) {
+        len = INDEX_KEY_LENGTH;
+    }
+
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t) toupper((unsigned char) ptr[i])) * 16777619UL;
+    }
+
+    return (hash ^ ':') * 16777619UL;
+}
+
+static int indexBucket(const char * m1, int m1_len, const char * m2, int m2_len) {
+    uint32_t hash = 2166136261UL;
+    hash = indexHashMnemonic(hash, m1, m1_len);
+    hash = indexHashMnemonic(hash, m2, m2_len);
+    return (int) (hash % SCPI_COMMAND_INDEX_BUCKETS);
+}
+
+/**
+ * Split pattern, e.g. [SOURce#]:VOLTage[:LEVel]?, to the mnemonic nodes
+ * @return number of nodes or -1 if there is too many of them
+ */
+static int indexParsePattern(const char * pattern, index_node_t * nodes) {
+    int n = 0;
+    int brackets = 0;
+    const char * p = pattern;
+    const char * start;
+    int len;
+    int short_len;
+
+    while (*p && *p != '?') {
+        if (*p == '[') {
+            brackets++;
+            p++;
+        } else if (*p == ']') {
+            brackets--;
+            p++;
+        } else if (*p == ':') {
+            p++;
+        } else {
+            start = p;
+            while (*p && !strchr("[]:?", *p)) {
+                p++;
+            }
+
+            if (n == INDEX_MAX_NODES) {
+                return -1;
+            }
+
+            len = p - start;
+            if ((len > 0) && start[len - 1] == '#') {
+                len--;
+            }
+            len = indexMnemonicLength(start, len);
+
+            for (short_len = 0; (short_len < len) && !islower((unsigned char) start[short_len]); short_len++);
+
+            nodes[n].ptr = start;
+            nodes[n].len = len;
+            nodes[n].short_len = short_len;
+            nodes[n].optional = brackets > 0 ? TRUE : FALSE;
+            n++;
+        }
+    }
+
+    return n;
+}
+
+static scpi_bool_t indexAddBucket(int * buckets, int * num_buckets, int bucket) {
+    int i;
+
+    for (i = 0; i < *num_buckets; i++) {
+        if (buckets[i] == bucket) {
+            return TRUE;
+        }
+    }
+
+    if (*num_buckets == INDEX_MAX_BUCKETS_PER_PATTERN) {
+        return FALSE;
+    }
+
+    buckets[(*num_buckets)++] = bucket;
+    return TRUE;
+}
+
+/**
+ * Add buckets for both short and long form of the first and second node
+ */
+static scpi_bool_t indexAddNodes(int * buckets, int * num_buckets, const index_node_t * node1, const index_node_t * node2) {
+    int i, j;
+    int len1[2], len2[2];
+
+    len1[0] = node1->short_len;
+    len1[1] = node1->len;
+    len2[0] = node2 ? node2->short_len : 0;
+    len2[1] = node2 ? node2->len : 0;
+
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < 2; j++) {
+            if (!indexAddBucket(buckets, num_buckets, indexBucket(node1->ptr, len1[i], node2 ? node2->ptr : NULL, len2[j]))) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Find all the buckets pattern should be added to
+ * @return number of buckets or -1 on failure
+ */
+static int indexPatternBuckets(const char * pattern, int * buckets) {
+    index_node_t nodes[INDEX_MAX_NODES];
+    int num_nodes;
+    int num_buckets = 0;
+    int i, j;
+
+    num_nodes = indexParsePattern(pattern, nodes);
+    if (num_nodes < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < num_nodes; i++) {
+        for (j = i + 1; j <= num_nodes; j++) {
+            /* j == num_nodes: command ends after the first node */
+            if (!indexAddNodes(buckets, &num_buckets, &nodes[i], j < num_nodes ? &nodes[j] : NULL)) {
+                return -1;
+            }
+
+            if (j == num_nodes || !nodes[j].optional) {
+                break;
+            }
+        }
+
+        if (!nodes[i].optional) {
+            break;
+        }
+    }
+
+    return num_buckets;
+}
+
+/**
+ * Build command index for the given command list. If it doesn't
+ * fit, index is not used and command header is searched by linear scan.
+ */
+static void indexBuild(const scpi_command_t * cmdlist) {
+    int buckets[INDEX_MAX_BUCKETS_PER_PATTERN];
+    int num_buckets;
+    int i, j;
+    uint32_t total = 0;
+
+    index_cmdlist = NULL;
+    memset(index_offsets, 0, sizeof(index_offsets));
+
+    /* count entries per bucket */
+    for (i = 0; cmdlist[i].pattern != NULL; i++) {
+        num_buckets = indexPatternBuckets(cmdlist[i].pattern, buckets);
+        if (num_buckets < 0 || i > 0xFFFF) {
+            return;
+        }
+        for (j = 0; j < num_buckets; j++) {
+            index_offsets[buckets[j]]++;
+        }
+        total += num_buckets;
+    }
+
+    if (total > SCPI_COMMAND_INDEX_MAX_ENTRIES) {
+        return;
+    }
+
+    /* index_offsets[b] becomes the end of the bucket b */
+    for (j = 1; j < SCPI_COMMAND_INDEX_BUCKETS; j++) {
+        index_offsets[j] += index_offsets[j - 1];
+    }
+    index_offsets[SCPI_COMMAND_INDEX_BUCKETS] = (uint16_t) total;
+
+    /* fill backwards so entries are in command list order and
+       index_offsets[b] ends as the start of the bucket b */
+    for (i = i - 1; i >= 0; i--) {
+        num_buckets = indexPatternBuckets(cmdlist[i].pattern, buckets);
+        for (j = 0; j < num_buckets; j++) {
+            index_entries[--index_offsets[buckets[j]]] = (uint16_t) i;
+        }
+    }
+
+    index_cmdlist = cmdlist;
+}
+
+/**
+ * Bucket for the first two mnemonics of the command header
+ */
+static int indexHeaderBucket(const char * header, int len) {
+    const char * m2 = NULL;
+    int m1_len = 0;
+    int m2_len = 0;
+
+    if ((len > 0) && header[0] == ':') {
+        header++;
+        len--;
+    }
+
+    while ((m1_len < len) && header[m1_len] != ':' && header[m1_len] != '?') {
+        m1_len++;
+    }
+
+    if ((m1_len < len) && header[m1_len] == ':') {
+        m2 = header + m1_len + 1;
+        len -= m1_len + 1;
+        while ((m2_len < len) && m2[m2_len] != ':' && m2[m2_len] != '?') {
+            m2_len++;
+        }
+    }
+
+    return indexBucket(header, indexMnemonicLength(header, m1_len), m2, indexMnemonicLength(m2, m2_len));
+}
+
+#define SCPI_COMMAND_INDEX 1
+#endif
+
 /**
  * Cycle all patterns and search matching pattern. Execute command callback.
  * @param context
@@ -211,6 +474,24 @@ static scpi_bool_t findCommandHeader(scpi_t * context, const char * header, int
 #else
     const scpi_command_t * cmd;
 
+#if SCPI_COMMAND_INDEX
+    if (index_cmdlist == context->cmdlist) {
+        int bucket = indexHeaderBucket(header, len);
+        int k;
+
+        for (k = index_offsets[bucket]; k < index_offsets[bucket + 1]; k++) {
+            cmd = &context->cmdlist[index_entries[k]];
+            if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
+                context->param_list.cmd = cmd;
+                return TRUE;
+            }
+        }
+
+        /* not found in the index, fall through to the linear scan which
+           will, in most cases, report undefined header */
+    }
+#endif
+
     for (i = 0; context->cmdlist[i].pattern != NULL; i++) {
         cmd = &context->cmdlist[i];
         if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
@@ -316,6 +597,13 @@ void SCPI_Init(scpi_t * context,
     context->param_list.cmd_s.pattern = context->param_list.cmd_pattern_s;
     context->param_list.cmd = &context->param_list.cmd_s;
 #endif
+
+#if SCPI_COMMAND_INDEX
+    /* index is shared by all the contexts with the same command list */
+    if (index_cmdlist != commands) {
+        indexBuild(commands);
+    }
+#endif
 }
 
 /**
@@ -567,7 +855,7 @@ size_t SCPI_ResultArbitraryBlockHeader(scpi_t * context, size_t len) {
     block_header[1] = (char) (header_len + '0');
 
     context->arbitrary_reminding = len;
-    return writeData(context, block_header, header_len + 2);
+    return writeDelimiter(context) + writeData(context, block_header, header_len + 2);
 }
 
 /**
@@ -104,6 +104,27 @@ extern "C" {
 #define USE_FULL_PROGMEM_FOR_CMD_LIST 0
 #endif
 
+/**
+ * Enable command index (hash of the first two command header mnemonics)
+ * 0 = Command header is searched by linear scan of the command list
+ * 1 = Index is built in SCPI_Init and only matching candidates are scanned
+ *
+ * Index is not supported for command list stored in program memory.
+ * If the index doesn't fit into SCPI_COMMAND_INDEX_MAX_ENTRIES,
+ * linear scan is used.
+ */
+#ifndef USE_COMMAND_INDEX
+#define USE_COMMAND_INDEX 1
+#endif
+
+#ifndef SCPI_COMMAND_INDEX_BUCKETS
+#define SCPI_COMMAND_INDEX_BUCKETS 256
+#endif
+
+#ifndef SCPI_COMMAND_INDEX_MAX_ENTRIES
+#define SCPI_COMMAND_INDEX_MAX_ENTRIES 1024
+#endif
+
 #ifndef USE_64K_PROGMEM_FOR_ERROR_MESSAGES
 #define USE_64K_PROGMEM_FOR_ERROR_MESSAGES 0
 #endif
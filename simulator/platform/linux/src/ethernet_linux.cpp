@@ -18,6 +18,7 @@
 
 #include "psu.h"
 #include "ethernet_platform.h"
+#include "main_loop_linux.h"
 
 #include <errno.h>
 #include <unistd.h>
@@ -25,13 +26,25 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <fcntl.h>
+#include <poll.h>
 
 namespace eez {
 namespace psu {
 namespace ethernet_platform {
 
 static int listen_socket = -1;
-static int client_socket = -1;
+
+static struct {
+    int socket;
+
+    // data received from the client socket, but not yet read
+    char input_buffer[SCPI_PARSER_INPUT_BUFFER_LENGTH / 2];
+    int input_buffer_position;
+    int input_buffer_size;
+} clients[MAX_CLIENTS];
+
+// is listen socket watched by the main loop, it is not while all the client slots are taken
+static bool listen_socket_watched;
 
 bool enable_non_blocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
@@ -78,98 +91,179 @@ bool bind(int port) {
         return false;
     }
 
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        clients[i].socket = -1;
+    }
+
+    main_loop_watch(listen_socket);
+    listen_socket_watched = true;
+
     return true;
 }
 
-bool client_available() {
-    if (connected()) return true;
+static int accept_client() {
+    int i;
+    for (i = 0; i < MAX_CLIENTS; ++i) {
+        if (clients[i].socket == -1) {
+            break;
+        }
+    }
 
-    if (listen_socket == -1) {
-        return 0;
+    if (i == MAX_CLIENTS) {
+        // don't wake up main loop for the new connections until some client is closed
+        if (listen_socket_watched) {
+            main_loop_unwatch(listen_socket);
+            listen_socket_watched = false;
+        }
+        return -1;
     }
 
     sockaddr_in cli_addr;
     socklen_t clilen = sizeof(cli_addr);
-    client_socket = accept(listen_socket, (sockaddr *)&cli_addr, &clilen);
+    int client_socket = accept(listen_socket, (sockaddr *)&cli_addr, &clilen);
     if (client_socket < 0) {
         if (errno == EWOULDBLOCK) {
-            return false;
+            return -1;
         }
 
         DebugTraceF("EHTERNET: accept failed with error %d", errno);
+        main_loop_unwatch(listen_socket);
         close(listen_socket);
         listen_socket = -1;
-        return false;
+        return -1;
     }
 
     if (!enable_non_blocking(client_socket)) {
         DebugTraceF("EHTERNET: ioctl on client socket failed with error %d", errno);
         close(client_socket);
-        listen_socket = -1;
-        return false;
+        return -1;
     }
 
-    return true;
-}
+    clients[i].socket = client_socket;
+    clients[i].input_buffer_position = 0;
+    clients[i].input_buffer_size = 0;
 
-bool connected() {
-    return client_socket != -1;
-}
+    main_loop_watch(client_socket);
 
-int available() {
-    if (client_socket == -1) return 0;
+    return i;
+}
 
-    char buffer[SCPI_PARSER_INPUT_BUFFER_LENGTH / 2];
-    int iResult = ::recv(client_socket, buffer, SCPI_PARSER_INPUT_BUFFER_LENGTH / 2, MSG_PEEK);
-    if (iResult > 0) {
-        return iResult;
+int client_available() {
+    if (listen_socket != -1) {
+        int client = accept_client();
+        if (client != -1) {
+            return client;
+        }
     }
 
-    if (iResult < 0 && errno == EWOULDBLOCK) {
-        return 0;
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        if (available(i) > 0) {
+            return i;
+        }
     }
 
-    stop();
+    return -1;
+}
 
-    return 0;
+static void close_client_socket(int client) {
+    main_loop_unwatch(clients[client].socket);
+    close(clients[client].socket);
+    clients[client].socket = -1;
+
+    if (listen_socket != -1 && !listen_socket_watched) {
+        main_loop_watch(listen_socket);
+        listen_socket_watched = true;
+    }
+}
+
+bool connected(int client) {
+    return clients[client].socket != -1;
 }
 
-int read(char *buffer, int buffer_size) {
-    int n = ::read(client_socket, buffer, buffer_size);
+int available(int client) {
+    if (clients[client].socket == -1) return 0;
+
+    if (clients[client].input_buffer_position < clients[client].input_buffer_size) {
+        return clients[client].input_buffer_size - clients[client].input_buffer_position;
+    }
+
+    int n = ::recv(clients[client].socket, clients[client].input_buffer, sizeof(clients[client].input_buffer), 0);
     if (n > 0) {
+        clients[client].input_buffer_position = 0;
+        clients[client].input_buffer_size = n;
         return n;
     }
 
-    if (n < 0 && errno == EWOULDBLOCK) {
+    if (n < 0 && (errno == EWOULDBLOCK || errno == EINTR)) {
         return 0;
     }
 
-    stop();
+    stop(client);
 
     return 0;
 }
 
-int write(const char *buffer, int buffer_size) {
-    if (client_socket != -1) {
-        int n = ::write(client_socket, buffer, buffer_size);
-        if (n < 0) {
-            close(client_socket);
-            client_socket = -1;
-            return 0;
+int read(int client, char *buffer, int buffer_size) {
+    int n = available(client);
+    if (n > buffer_size) {
+        n = buffer_size;
+    }
+
+    if (n > 0) {
+        memcpy(buffer, clients[client].input_buffer + clients[client].input_buffer_position, n);
+        clients[client].input_buffer_position += n;
+    }
+
+    return n;
+}
+
+/// Client socket is non-blocking, so when its send buffer is full (client
+/// reads slower than the output is produced) wait until it is writable again,
+/// like the write on the hardware does, instead of dropping the rest of the output.
+int write(int client, const char *buffer, int buffer_size) {
+    int written = 0;
+
+    while (clients[client].socket != -1 && written < buffer_size) {
+        int n = ::write(clients[client].socket, buffer + written, buffer_size - written);
+        if (n > 0) {
+            written += n;
+            continue;
         }
-        return n;
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd fd;
+            fd.fd = clients[client].socket;
+            fd.events = POLLOUT;
+            int result = poll(&fd, 1, SIM_CLIENT_WRITE_TIMEOUT);
+            if (result > 0 || (result < 0 && errno == EINTR)) {
+                continue;
+            }
+
+            if (result == 0) {
+                DebugTrace("EHTERNET: client write timeout");
+            }
+        }
+
+        close_client_socket(client);
     }
 
-    return 0;
+    return written;
 }
 
-void stop() {    
-    int result = shutdown(client_socket, SHUT_WR);
+void stop(int client) {
+    if (clients[client].socket == -1) {
+        return;
+    }
+
+    int result = shutdown(clients[client].socket, SHUT_WR);
     if (result < 0) {
         DebugTraceF("ETHERNET shutdown failed with error %d\n", errno);
     }
-    close(client_socket);
-    client_socket = -1;
+    close_client_socket(client);
 }
 
 }
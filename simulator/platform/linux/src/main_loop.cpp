@@ -19,67 +19,149 @@
 #include "psu.h"
 #include "serial_psu.h"
 #include "main_loop.h"
+#include "main_loop_linux.h"
 
 #include <errno.h>
-#include "thread_queue.h"
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 using namespace eez::psu;
 
-#define NEW_INPUT_MESSAGE 1
-#define QUIT_MESSAGE      2
+#define MAX_EVENTS 16
+#define INPUT_BUFFER_SIZE 4096
 
-threadqueue queue;
+static int epoll_fd = -1;
+static int timer_fd = -1;
 
-void *input_thread(void *) {
-    while (1) {
-        int ch = getchar();
-        if (ch == EOF) break;
+// epoll doesn't support regular files, if stdin is redirected from a file
+// it is always considered ready for reading
+static bool stdin_always_ready;
+
+static bool watch_fd(int fd) {
+    if (epoll_fd == -1) {
+        // sockets can be watched before main loop is started
+        epoll_fd = epoll_create1(0);
+        if (epoll_fd < 0) {
+            return false;
+        }
+    }
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void main_loop_watch(int fd) {
+    if (!watch_fd(fd)) {
+        DebugTraceF("MAIN LOOP: epoll_ctl add failed with error %d", errno);
+    }
+}
+
+void main_loop_unwatch(int fd) {
+    if (epoll_fd != -1) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, 0);
+    }
+}
+
+/// Arms one shot timer for the next main loop pass (see
+/// simulator::getTimeToNextTick). Returns false if the pass is already due
+/// or if in the fast forward mode, then main loop doesn't wait at all.
+static bool update_timer() {
+    float time_scale = simulator::getTimeScale();
+    if (time_scale == 0) {
+        return false;
+    }
+
+    uint32_t timeout = simulator::getTimeToNextTick();
+    if (timeout == 0) {
+        return false;
+    }
 
-        thread_queue_add(&queue, new char(ch), NEW_INPUT_MESSAGE);
+    long long timeout_ns = (long long)(timeout * 1000.0 / time_scale);
+    if (timeout_ns < 1000) {
+        timeout_ns = 1000;
     }
 
-    thread_queue_add(&queue, 0, QUIT_MESSAGE);
+    itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = (time_t)(timeout_ns / 1000000000);
+    spec.it_value.tv_nsec = (long)(timeout_ns % 1000000000);
+    timerfd_settime(timer_fd, 0, &spec, 0);
 
-    return 0;
+    return true;
 }
 
+/// Reads all the available input in bulk, returns false on EOF.
+static bool read_stdin() {
+    char buffer[INPUT_BUFFER_SIZE];
+    int n = read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (n <= 0) {
+        return n < 0 && (errno == EAGAIN || errno == EINTR);
+    }
+    SERIAL_PORT.put(buffer, n);
+    return true;
+}
 
 int main_loop() {
-    timespec timeout = { 0, TICK_TIMEOUT * 1000 * 1000 };
+    // writing to the closed client socket shouldn't terminate the simulator
+    signal(SIGPIPE, SIG_IGN);
 
-    if (thread_queue_init(&queue) != 0) return -1;
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (timer_fd < 0 || !watch_fd(timer_fd)) {
+        return errno;
+    }
 
-    pthread_t thread;
-    pthread_create(&thread, 0, input_thread, 0);
+    if (!watch_fd(STDIN_FILENO)) {
+        if (errno != EPERM) {
+            return errno;
+        }
+        stdin_always_ready = true;
+    }
 
     while (1) {
-        threadmsg msg;
-        char *p_ch;
-        int ret;
-        switch (ret = thread_queue_get(&queue, &timeout, &msg)) {
-        case 0:
-            switch (msg.msgtype) {
-            case NEW_INPUT_MESSAGE:
-                p_ch = (char *)msg.data;
-                SERIAL_PORT.put(*p_ch);
-                delete p_ch;
-                break;
-
-            case QUIT_MESSAGE:
-                return 0;
+        int timeout = update_timer() && !stdin_always_ready ? -1 : 0;
+
+        epoll_event events[MAX_EVENTS];
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
             }
-            break;
+            return errno;
+        }
 
-        case ETIMEDOUT:
-            simulator::tick();
-            break;
+        bool tick = n == 0 && timeout == 0;
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == timer_fd) {
+                uint64_t expirations;
+                ::read(timer_fd, &expirations, sizeof(expirations));
+                tick = true;
+            } else if (fd == STDIN_FILENO) {
+                if (!read_stdin()) {
+                    return 0;
+                }
+                tick = true;
+            } else {
+                // socket activity, it is handled by ethernet::tick
+                tick = true;
+            }
+        }
 
-        default:
-            return ret;
+        if (stdin_always_ready && !read_stdin()) {
+            return 0;
+        }
+
+        if (tick) {
+            simulator::tick();
         }
     }
 }
 
 void main_loop_exit() {
     ::exit(0);
-}
\ No newline at end of file
+}
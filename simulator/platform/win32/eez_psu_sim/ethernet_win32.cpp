@@ -38,7 +38,7 @@ namespace psu {
 namespace ethernet_platform {
 
 static SOCKET listen_socket = INVALID_SOCKET;
-static SOCKET client_socket = INVALID_SOCKET;
+static SOCKET client_sockets[MAX_CLIENTS];
 
 bool bind(int port) {
     WSADATA wsaData;
@@ -107,41 +107,67 @@ bool bind(int port) {
         return false;
     }
 
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        client_sockets[i] = INVALID_SOCKET;
+    }
+
     return true;
 }
 
-bool client_available() {
-    if (connected()) return true;
+static int accept_client() {
+    int i;
+    for (i = 0; i < MAX_CLIENTS; ++i) {
+        if (client_sockets[i] == INVALID_SOCKET) {
+            break;
+        }
+    }
 
-    if (listen_socket == INVALID_SOCKET) {
-        return false;
+    if (i == MAX_CLIENTS) {
+        return -1;
     }
 
     // Accept a client socket
-    client_socket = accept(listen_socket, NULL, NULL);
-    if (client_socket == INVALID_SOCKET) {
+    client_sockets[i] = accept(listen_socket, NULL, NULL);
+    if (client_sockets[i] == INVALID_SOCKET) {
         if (WSAGetLastError() == WSAEWOULDBLOCK) {
-            return false;
+            return -1;
         }
 
         DebugTraceF("EHTERNET accept failed with error %d\n", WSAGetLastError());
         closesocket(listen_socket);
         listen_socket = INVALID_SOCKET;
-        return false;
+        return -1;
     }
 
-    return true;
+    return i;
 }
 
-bool connected() {
-    return client_socket != INVALID_SOCKET;
+int client_available() {
+    if (listen_socket != INVALID_SOCKET) {
+        int client = accept_client();
+        if (client != -1) {
+            return client;
+        }
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        if (available(i) > 0) {
+            return i;
+        }
+    }
+
+    return -1;
 }
 
-int available() {
-    if (client_socket == INVALID_SOCKET) return 0;
+bool connected(int client) {
+    return client_sockets[client] != INVALID_SOCKET;
+}
+
+int available(int client) {
+    if (client_sockets[client] == INVALID_SOCKET) return 0;
 
     char buffer[SCPI_PARSER_INPUT_BUFFER_LENGTH / 2];
-    int iResult = ::recv(client_socket, buffer, SCPI_PARSER_INPUT_BUFFER_LENGTH / 2, MSG_PEEK);
+    int iResult = ::recv(client_sockets[client], buffer, SCPI_PARSER_INPUT_BUFFER_LENGTH / 2, MSG_PEEK);
     if (iResult > 0) {
         return iResult;
     }
@@ -150,13 +176,13 @@ int available() {
         return 0;
     }
 
-    stop();
+    stop(client);
 
     return 0;
 }
 
-int read(char *buffer, int buffer_size) {
-    int iResult = ::recv(client_socket, buffer, buffer_size, 0);
+int read(int client, char *buffer, int buffer_size) {
+    int iResult = ::recv(client_sockets[client], buffer, buffer_size, 0);
     if (iResult > 0) {
         return iResult;
     }
@@ -165,37 +191,58 @@ int read(char *buffer, int buffer_size) {
         return 0;
     }
 
-    stop();
+    stop(client);
 
     return 0;
 }
 
-int write(const char *buffer, int buffer_size) {
-    int iSendResult;
+/// Client socket is non-blocking, so when its send buffer is full (client
+/// reads slower than the output is produced) wait until it is writable again,
+/// like the write on the hardware does, instead of dropping the rest of the output.
+int write(int client, const char *buffer, int buffer_size) {
+    int written = 0;
+
+    while (client_sockets[client] != INVALID_SOCKET && written < buffer_size) {
+        int iSendResult = ::send(client_sockets[client], buffer + written, buffer_size - written, 0);
+        if (iSendResult > 0) {
+            written += iSendResult;
+            continue;
+        }
 
-    if (client_socket != INVALID_SOCKET) {
-        // Echo the buffer back to the sender
-        iSendResult = ::send(client_socket, buffer, buffer_size, 0);
-        if (iSendResult == SOCKET_ERROR) {
+        if (iSendResult == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK) {
+            fd_set writeSet;
+            FD_ZERO(&writeSet);
+            FD_SET(client_sockets[client], &writeSet);
+            timeval timeout;
+            timeout.tv_sec = SIM_CLIENT_WRITE_TIMEOUT / 1000;
+            timeout.tv_usec = (SIM_CLIENT_WRITE_TIMEOUT % 1000) * 1000;
+            int iResult = select(0, NULL, &writeSet, NULL, &timeout);
+            if (iResult > 0) {
+                continue;
+            }
+
+            if (iResult == 0) {
+                DebugTrace("EHTERNET: client write timeout\n");
+            }
+        } else {
             DebugTraceF("send failed with error: %d\n", WSAGetLastError());
-            closesocket(client_socket);
-            client_socket = INVALID_SOCKET;
-            return 0;
         }
-        return iSendResult;
+
+        closesocket(client_sockets[client]);
+        client_sockets[client] = INVALID_SOCKET;
     }
 
-    return 0;
+    return written;
 }
 
-void stop() {
-    if (client_socket != INVALID_SOCKET) {
-        int iResult = shutdown(client_socket, SD_SEND);
+void stop(int client) {
+    if (client_sockets[client] != INVALID_SOCKET) {
+        int iResult = shutdown(client_sockets[client], SD_SEND);
         if (iResult == SOCKET_ERROR) {
             DebugTraceF("EHTERNET shutdown failed with error %d\n", WSAGetLastError());
         }
-        closesocket(client_socket);
-        client_socket = INVALID_SOCKET;
+        closesocket(client_sockets[client]);
+        client_sockets[client] = INVALID_SOCKET;
     }
 }
 
@@ -51,7 +51,14 @@ int main_loop() {
     CreateThread(0, 0, input_thread_proc, 0, 0, 0);
 
     while (1) {
-        switch (MsgWaitForMultipleObjects(0, 0, FALSE, 0, QS_POSTMESSAGE)) {
+        // wait until the next main loop pass is due (see simulator::getTimeToNextTick)
+        DWORD timeout = 0;
+        float timeScale = simulator::getTimeScale();
+        if (timeScale != 0) {
+            timeout = (DWORD)(simulator::getTimeToNextTick() / timeScale / 1000);
+        }
+
+        switch (MsgWaitForMultipleObjects(0, 0, FALSE, timeout, QS_POSTMESSAGE)) {
         case WAIT_OBJECT_0:
             while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
             {
@@ -67,6 +74,7 @@ int main_loop() {
                     return 0;
                 }
             }
+            simulator::tick();
             break;
 
         case WAIT_TIMEOUT:
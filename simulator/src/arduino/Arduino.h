@@ -69,6 +69,12 @@ uint32_t micros();
 void delay(uint32_t millis);
 void delayMicroseconds(uint32_t microseconds);
 
+/// Interrupt handlers are simulated by the threads (see simulator_timer.h),
+/// handler is executed while the interrupts are disabled, i.e. these lock
+/// and unlock the same (recursive) mutex.
+void noInterrupts();
+void interrupts();
+
 /// Bare minimum implementation of the Arduino IPAddress class
 class IPAddress {
     friend class UARTClass;
@@ -120,6 +126,7 @@ public:
     void flush(void);
 
     void put(int ch);
+    void put(const char *buffer, int size);
 
 private:
     std::queue<int> input;
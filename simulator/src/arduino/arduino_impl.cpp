@@ -141,6 +141,12 @@ void UARTClass::put(int ch) {
     input.push(ch);
 }
 
+void UARTClass::put(const char *buffer, int size) {
+    for (int i = 0; i < size; ++i) {
+        input.push((uint8_t)buffer[i]);
+    }
+}
+
 void UARTClass::flush() {
 }
 
@@ -156,10 +162,17 @@ SimulatorSPI SPI;
 void SimulatorSPI::begin() {
 }
 
+// interrupt handler is using SPI, so it must not be executed during the transaction
+static bool g_spiUsingInterrupt;
+
 void SimulatorSPI::usingInterrupt(uint8_t interruptNumber) {
+    g_spiUsingInterrupt = true;
 }
 
 void SimulatorSPI::beginTransaction(SPISettings settings) {
+    if (g_spiUsingInterrupt) {
+        noInterrupts();
+    }
 }
 
 uint8_t SimulatorSPI::transfer(uint8_t data) {
@@ -167,6 +180,9 @@ uint8_t SimulatorSPI::transfer(uint8_t data) {
 }
 
 void SimulatorSPI::endTransaction(void) {
+    if (g_spiUsingInterrupt) {
+        interrupts();
+    }
 }
 
 void SimulatorSPI::attachInterrupt() {
@@ -196,46 +212,60 @@ void tone(uint8_t _pin, unsigned int frequency, unsigned long duration) {
 #else
 #include <sys/time.h>
 #include <time.h>
+#include <pthread.h>
 #endif
 
-uint32_t millis() {
+////////////////////////////////////////////////////////////////////////////////
+// Simulator clock. Virtual time is the real (wall clock) time multiplied
+// by the time scale. In the fast forward mode (time scale is 0) it is not
+// related to the real time at all, it is advanced only by advanceTime and delay.
+
+static float g_timeScale = SIM_TIME_SCALE_DEF;
+static bool g_timeInitialized;
+static uint64_t g_virtualTimeBase;
+static uint64_t g_realTimeBase;
+static time_t g_utcTimeBase;
+
+static uint64_t getRealTime() {
 #ifdef _WIN32
-    return GetTickCount();
+    static unsigned __int64 frequency;
+    if (!frequency) {
+        QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
+    }
+
+    unsigned __int64 time;
+    QueryPerformanceCounter((LARGE_INTEGER *)&time);
+
+    return time * 1000000L / frequency;
 #else
     timeval tv;
     gettimeofday(&tv, NULL);
-    uint64_t micros = tv.tv_sec*(uint64_t)1000000 + tv.tv_usec;
-    return (uint32_t)(micros / 1000);
+    return tv.tv_sec*(uint64_t)1000000 + tv.tv_usec;
 #endif
 }
 
-uint32_t micros() {
-#ifdef _WIN32
-    static bool firstTime = true;
-    static unsigned __int64 frequency;
-    static unsigned __int64 startTime;
-
-    if (firstTime) {
-        firstTime = false;
-        QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
-        QueryPerformanceCounter((LARGE_INTEGER *)&startTime);
-
+/// Returns virtual time, in microseconds, since the simulator start.
+static uint64_t getTime() {
+    if (!g_timeInitialized) {
+        g_timeInitialized = true;
+        g_realTimeBase = getRealTime();
+        g_utcTimeBase = time(0);
         return 0;
-    } else {
-        unsigned __int64 time;
-        QueryPerformanceCounter((LARGE_INTEGER *)&time);
-
-        unsigned __int64 diff = (time - startTime) * 1000000L / frequency;
+    }
 
-        return (uint32_t)(diff % 4294967296);
+    if (g_timeScale == 0) {
+        return g_virtualTimeBase;
     }
 
-#else
-    timeval tv;
-    gettimeofday(&tv, NULL);
-    uint64_t micros = tv.tv_sec*(uint64_t)1000000 + tv.tv_usec;
-    return (uint32_t)(micros % 4294967296);
-#endif
+    return g_virtualTimeBase + (uint64_t)((getRealTime() - g_realTimeBase) * g_timeScale);
+}
+
+uint32_t millis() {
+    return (uint32_t)(getTime() / 1000);
+}
+
+uint32_t micros() {
+    return (uint32_t)(getTime() % 4294967296);
 }
 
 void delay(uint32_t millis) {
@@ -243,6 +273,13 @@ void delay(uint32_t millis) {
 } 
 
 void delayMicroseconds(uint32_t microseconds) {
+    if (g_timeScale == 0) {
+        g_virtualTimeBase += microseconds;
+        return;
+    }
+
+    microseconds = (uint32_t)(microseconds / g_timeScale);
+
 #ifdef _WIN32
     Sleep(microseconds / 1000);
 #else
@@ -253,7 +290,61 @@ void delayMicroseconds(uint32_t microseconds) {
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+static struct InterruptsMutex {
+    CRITICAL_SECTION criticalSection;
+    InterruptsMutex() {
+        InitializeCriticalSection(&criticalSection);
+    }
+} g_interruptsMutex;
+#else
+static pthread_mutex_t g_interruptsMutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+#endif
+
+void noInterrupts() {
+#ifdef _WIN32
+    EnterCriticalSection(&g_interruptsMutex.criticalSection);
+#else
+    pthread_mutex_lock(&g_interruptsMutex);
+#endif
+}
+
+void interrupts() {
+#ifdef _WIN32
+    LeaveCriticalSection(&g_interruptsMutex.criticalSection);
+#else
+    pthread_mutex_unlock(&g_interruptsMutex);
+#endif
+}
+
+} // namespace arduino
+
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace arduino;
+
+void setTimeScale(float scale) {
+    g_virtualTimeBase = getTime();
+    g_realTimeBase = getRealTime();
+    g_timeScale = scale;
+}
+
+float getTimeScale() {
+    return g_timeScale;
+}
+
+void advanceTime(uint32_t microseconds) {
+    if (g_timeScale == 0) {
+        g_virtualTimeBase += microseconds;
+    }
+}
+
+time_t getUtcTime() {
+    return g_utcTimeBase + (time_t)(getTime() / 1000000);
 }
+
 }
 }
-} // namespace eez::psu::simulator::arduino;
+} // namespace eez::psu::simulator
@@ -0,0 +1,228 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SCPI command dispatch benchmark. Uses the firmware command list with
+ * dummy callbacks. Build it with USE_COMMAND_INDEX set to 0 and 1 to
+ * compare the linear scan with the command index (see "make benchmark").
+ *
+ * Before measuring, it verifies that every command from the list, in
+ * short, long and mixed form, is dispatched to the same command as the
+ * reference linear scan.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include <scpi-parser.h>
+#include "impl/utils_private.h"
+
+#include "scpi_commands.h"
+
+#define NUM_ITERATIONS 200000
+
+static scpi_result_t dummy_callback(scpi_t *context) {
+    scpi_parameter_t param;
+    while (SCPI_Parameter(context, &param, FALSE)) {
+    }
+    return SCPI_RES_OK;
+}
+
+#define SCPI_COMMAND(P, C) {P, dummy_callback},
+static const scpi_command_t scpi_commands[] = {
+    SCPI_COMMANDS
+    SCPI_CMD_LIST_END
+};
+#undef SCPI_COMMAND
+
+static size_t write_null(scpi_t *context, const char *data, size_t len) {
+    return len;
+}
+
+static scpi_interface_t scpi_interface = {
+    NULL, write_null, NULL, NULL, NULL
+};
+
+static scpi_t scpi_context;
+static char scpi_input_buffer[256];
+static int16_t scpi_error_queue_data[16];
+
+static const char *benchmark_commands[] = {
+    "*IDN?",
+    "*OPC?",
+    "MEAS:VOLT?",
+    "MEASure:SCALar:CURRent:DC?",
+    "VOLT 5",
+    "SOUR2:CURR 0.5",
+    "OUTP ON",
+    "INST:NSEL 2",
+    "SYST:ERR?",
+    "SYST:COMM:ETH:ADDR?",
+    "STAT:QUES:INST:ISUM2:COND?",
+    "SENS:DLOG:PER 0.1",
+    "SIMU:PIN1?",
+    0
+};
+
+/* expected command found by the linear scan, same as the original findCommandHeader */
+static const scpi_command_t *find_linear(const char *header, size_t len) {
+    int i;
+    for (i = 0; scpi_commands[i].pattern != NULL; i++) {
+        if (matchCommand(scpi_commands[i].pattern, header, len, NULL, 0, 0)) {
+            return &scpi_commands[i];
+        }
+    }
+    return NULL;
+}
+
+enum {
+    FORM_SHORT,
+    FORM_LONG,
+    FORM_SHORT_WITH_OPTIONAL
+};
+
+/* make the command header from the pattern */
+static void make_command(const char *pattern, int form, char *cmd) {
+    const char *p = pattern;
+    int brackets = 0;
+    int first = 1;
+
+    *cmd = 0;
+
+    while (*p) {
+        if (*p == '[') {
+            ++brackets;
+            ++p;
+        } else if (*p == ']') {
+            --brackets;
+            ++p;
+        } else if (*p == ':') {
+            ++p;
+        } else if (*p == '?') {
+            strcat(cmd, "?");
+            ++p;
+        } else {
+            const char *start = p;
+            int skip = brackets > 0 && form == FORM_SHORT;
+            char *q;
+
+            while (*p && !strchr("[]:?", *p)) {
+                ++p;
+            }
+
+            if (skip) {
+                continue;
+            }
+
+            if (!first) {
+                strcat(cmd, ":");
+            }
+            first = 0;
+
+            q = cmd + strlen(cmd);
+            for (; start < p; ++start) {
+                if (*start == '#') {
+                    *q++ = form == FORM_LONG ? '2' : '1';
+                } else if (form == FORM_LONG || !islower((unsigned char)*start)) {
+                    *q++ = (char)toupper((unsigned char)*start);
+                }
+            }
+            *q = 0;
+        }
+    }
+}
+
+static int verify() {
+    int i, form;
+    int num_verified = 0;
+    int num_failed = 0;
+    char cmd[256];
+
+    for (i = 0; scpi_commands[i].pattern != NULL; i++) {
+        for (form = FORM_SHORT; form <= FORM_SHORT_WITH_OPTIONAL; form++) {
+            const scpi_command_t *expected;
+
+            make_command(scpi_commands[i].pattern, form, cmd);
+            expected = find_linear(cmd, strlen(cmd));
+
+            scpi_context.param_list.cmd = NULL;
+            strcat(cmd, "\n");
+            SCPI_Input(&scpi_context, cmd, (int)strlen(cmd));
+
+            if (scpi_context.param_list.cmd != expected) {
+                printf("MISMATCH: %s", cmd);
+                num_failed++;
+            }
+            num_verified++;
+        }
+    }
+
+    printf("verified %d command headers, %d mismatches\n", num_verified, num_failed);
+
+    return num_failed == 0;
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1E9;
+}
+
+int main() {
+    int i, j;
+    double total = 0;
+    int num_commands = 0;
+
+    SCPI_Init(&scpi_context, scpi_commands, &scpi_interface, scpi_units_def,
+        "Envox", "EEZ PSU (Benchmark)", "0", "0",
+        scpi_input_buffer, sizeof(scpi_input_buffer),
+        scpi_error_queue_data, sizeof(scpi_error_queue_data) / sizeof(int16_t));
+
+    printf("SCPI dispatch benchmark, command index %s\n", USE_COMMAND_INDEX ? "ON" : "OFF");
+
+    if (!verify()) {
+        return 1;
+    }
+
+    for (i = 0; benchmark_commands[i]; i++) {
+        char cmd[256];
+        double start, duration;
+        size_t len;
+
+        strcpy(cmd, benchmark_commands[i]);
+        strcat(cmd, "\n");
+        len = strlen(cmd);
+
+        start = now();
+        for (j = 0; j < NUM_ITERATIONS; j++) {
+            SCPI_Input(&scpi_context, cmd, (int)len);
+        }
+        duration = now() - start;
+
+        printf("%-32s %10.0f commands/s\n", benchmark_commands[i], NUM_ITERATIONS / duration);
+
+        total += duration;
+        num_commands += NUM_ITERATIONS;
+    }
+
+    printf("%-32s %10.0f commands/s\n", "TOTAL", num_commands / total);
+
+    return 0;
+}
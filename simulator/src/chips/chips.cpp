@@ -373,7 +373,7 @@ uint8_t RtcChip::transfer(uint8_t data) {
 }
 
 uint32_t RtcChip::nowUtc() {
-    time_t now_time_t = time(0);
+    time_t now_time_t = simulator::getUtcTime();
     struct tm *now_tm = gmtime(&now_time_t);
     return datetime::makeTime(1900 + now_tm->tm_year, now_tm->tm_mon + 1, now_tm->tm_mday, now_tm->tm_hour, now_tm->tm_min, now_tm->tm_sec);
 }
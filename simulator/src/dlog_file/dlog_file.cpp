@@ -0,0 +1,634 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dlog_file.h"
+
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// must be the same as in dlog.cpp
+#define MAGIC1  0x2D5A4545L
+#define MAGIC2  0x474F4C44L
+#define VERSION 1
+#define VERSION_COMPRESSED 2
+
+#define FLAG_JITTER      0x0001
+#define FLAG_ADC_DATA    0x0002
+#define FLAG_PRE_TRIGGER 0x0004
+
+#define HEADER_SIZE 28
+#define ADC_RECORD_SIZE 8
+#define COMPRESSED_BLOCK_SIZE 256
+
+/// Number of samples decoded at once when the whole file is processed.
+#define SAMPLES_BLOCK_SIZE 1024
+
+namespace eez {
+namespace psu {
+namespace simulator {
+namespace dlog_file {
+
+static uint16_t getUint16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t getUint32(const uint8_t *p) {
+    return getUint16(p) | ((uint32_t)getUint16(p + 2) << 16);
+}
+
+static float getFloat(const uint8_t *p) {
+    uint32_t bits = getUint32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Reader::Reader() : m_data(0), m_size(0), m_mapped(false), m_error(0) {
+}
+
+Reader::~Reader() {
+    close();
+}
+
+bool Reader::open(const char *filePath) {
+    close();
+
+    int fd = ::open(filePath, O_RDONLY);
+    if (fd == -1) {
+        m_error = "can't open file";
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1) {
+        ::close(fd);
+        m_error = "can't get file size";
+        return false;
+    }
+
+    if (fileStat.st_size < HEADER_SIZE) {
+        ::close(fd);
+        m_error = "file is too short";
+        return false;
+    }
+
+    void *data = mmap(0, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        m_error = "can't map file";
+        return false;
+    }
+
+    // file is read from the start to the end
+    madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+
+    m_data = (const uint8_t *)data;
+    m_size = fileStat.st_size;
+    m_mapped = true;
+
+    if (!parseHeader()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool Reader::open(const uint8_t *data, size_t size) {
+    close();
+
+    m_data = data;
+    m_size = size;
+
+    if (!parseHeader()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void Reader::close() {
+    if (m_mapped) {
+        munmap((void *)m_data, m_size);
+        m_mapped = false;
+    }
+    m_data = 0;
+    m_size = 0;
+}
+
+bool Reader::parseHeader() {
+    m_error = 0;
+
+    if (m_size < HEADER_SIZE) {
+        m_error = "file is too short";
+        return false;
+    }
+
+    m_header.magic1 = getUint32(m_data);
+    m_header.magic2 = getUint32(m_data + 4);
+    m_header.version = getUint16(m_data + 8);
+    m_header.flags = getUint16(m_data + 10);
+    m_header.columns = getUint32(m_data + 12);
+    m_header.period = getFloat(m_data + 16);
+    m_header.time = getFloat(m_data + 20);
+    m_header.startTime = getUint32(m_data + 24);
+
+    if (m_header.magic1 != MAGIC1 || m_header.magic2 != MAGIC2) {
+        m_error = "not a data logging file";
+        return false;
+    }
+
+    if (m_header.version != VERSION && m_header.version != VERSION_COMPRESSED) {
+        m_error = "unsupported file version";
+        return false;
+    }
+
+    m_numColumns = 0;
+    if (m_header.flags & FLAG_JITTER) {
+        m_columns[m_numColumns].type = COLUMN_JITTER;
+        m_columns[m_numColumns].channelIndex = -1;
+        ++m_numColumns;
+    }
+    for (int i = 0; i < MAX_CHANNELS; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            if (m_header.columns & (1 << (4 * i + j))) {
+                m_columns[m_numColumns].type = (ColumnType)(COLUMN_VOLTAGE + j);
+                m_columns[m_numColumns].channelIndex = i;
+                ++m_numColumns;
+            }
+        }
+    }
+
+    size_t offset = HEADER_SIZE;
+
+    m_numPreTriggerSamples = 0;
+    m_firstSampleTime = 0;
+    m_adcStartTime = 0;
+
+    if (m_header.flags & FLAG_ADC_DATA) {
+        for (int i = 0; i < MAX_CHANNELS; ++i) {
+            if (m_header.columns & (0xF << (4 * i))) {
+                if (offset + 3 * 8 > m_size) {
+                    m_error = "file is too short";
+                    return false;
+                }
+                for (int j = 0; j < 3; ++j) {
+                    m_adcScale[i][j] = getFloat(m_data + offset);
+                    m_adcOffset[i][j] = getFloat(m_data + offset + 4);
+                    offset += 8;
+                }
+            } else {
+                for (int j = 0; j < 3; ++j) {
+                    m_adcScale[i][j] = NAN;
+                    m_adcOffset[i][j] = NAN;
+                }
+            }
+        }
+
+        if (offset + 4 > m_size) {
+            m_error = "file is too short";
+            return false;
+        }
+        m_adcStartTime = getUint32(m_data + offset);
+        offset += 4;
+    } else if (m_header.flags & FLAG_PRE_TRIGGER) {
+        if (offset + 8 > m_size) {
+            m_error = "file is too short";
+            return false;
+        }
+        m_numPreTriggerSamples = getUint32(m_data + offset);
+        m_firstSampleTime = getFloat(m_data + offset + 4);
+        offset += 8;
+    }
+
+    m_samplesOffset = offset;
+    rewind();
+
+    return true;
+}
+
+bool Reader::isCompressed() const {
+    return m_header.version == VERSION_COMPRESSED;
+}
+
+bool Reader::isAdcData() const {
+    return (m_header.flags & FLAG_ADC_DATA) != 0;
+}
+
+void Reader::getColumnName(int i, char *name, size_t size) const {
+    const Column &column = m_columns[i];
+    if (column.type == COLUMN_JITTER) {
+        snprintf(name, size, "jitter");
+    } else {
+        snprintf(name, size, "%c%d", "UIP"[column.type - COLUMN_VOLTAGE], column.channelIndex + 1);
+    }
+}
+
+double Reader::getSampleTime(uint64_t sampleIndex) const {
+    if (sampleIndex < m_numPreTriggerSamples) {
+        return m_firstSampleTime + (double)sampleIndex * m_header.period;
+    }
+    return (double)(sampleIndex - m_numPreTriggerSamples) * m_header.period;
+}
+
+void Reader::rewind() {
+    m_offset = m_samplesOffset;
+    m_sampleIndex = 0;
+    m_lastAdcTime = m_adcStartTime;
+    m_adcTime = 0;
+    m_truncated = false;
+}
+
+bool Reader::readSample(float *values) {
+    size_t sampleSize = m_numColumns * 4;
+    if (m_offset + sampleSize > m_size) {
+        m_truncated = m_offset < m_size;
+        return false;
+    }
+
+    const uint8_t *p = m_data + m_offset;
+    for (int i = 0; i < m_numColumns; ++i) {
+        values[i] = getFloat(p + i * 4);
+    }
+
+    m_offset += sampleSize;
+    return true;
+}
+
+bool Reader::readCompressedSample(float *values) {
+    // see the description of the format in dlog.cpp
+    if (m_sampleIndex % COMPRESSED_BLOCK_SIZE == 0) {
+        memset(m_previousValues, 0, sizeof(m_previousValues));
+    }
+
+    size_t offset = m_offset;
+
+    int maskSize = (m_numColumns + 7) / 8;
+    if (offset + maskSize > m_size) {
+        m_truncated = offset < m_size;
+        return false;
+    }
+    const uint8_t *mask = m_data + offset;
+    offset += maskSize;
+
+    uint32_t bits[MAX_COLUMNS];
+    for (int i = 0; i < m_numColumns; ++i) {
+        bits[i] = m_previousValues[i];
+        if (mask[i / 8] & (1 << (i % 8))) {
+            uint32_t value = 0;
+            for (int shift = 0; ; shift += 7) {
+                if (offset == m_size || shift > 28) {
+                    m_truncated = true;
+                    return false;
+                }
+                uint8_t b = m_data[offset++];
+                value |= (uint32_t)(b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    break;
+                }
+            }
+            int32_t delta = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+            bits[i] += (uint32_t)delta;
+        }
+    }
+
+    for (int i = 0; i < m_numColumns; ++i) {
+        m_previousValues[i] = bits[i];
+        memcpy(&values[i], &bits[i], sizeof(float));
+    }
+
+    m_offset = offset;
+    return true;
+}
+
+size_t Reader::readSamples(float *values, size_t maxSamples) {
+    if (isAdcData()) {
+        return 0;
+    }
+
+    size_t n;
+    for (n = 0; n < maxSamples; ++n) {
+        bool result = isCompressed() ? readCompressedSample(values) : readSample(values);
+        if (!result) {
+            break;
+        }
+        values += m_numColumns;
+        ++m_sampleIndex;
+    }
+
+    return n;
+}
+
+bool Reader::readAdcRecord(AdcRecord &record) {
+    if (!isAdcData()) {
+        return false;
+    }
+
+    if (m_offset + ADC_RECORD_SIZE > m_size) {
+        m_truncated = m_offset < m_size;
+        return false;
+    }
+
+    const uint8_t *p = m_data + m_offset;
+    m_offset += ADC_RECORD_SIZE;
+
+    // micros() wraps around every ~72 minutes
+    uint32_t time = getUint32(p);
+    m_adcTime += (uint32_t)(time - m_lastAdcTime);
+    m_lastAdcTime = time;
+
+    record.time = m_adcTime;
+    record.data = (int16_t)getUint16(p + 4);
+    record.channelIndex = p[6];
+    record.type = p[7];
+
+    if (record.type <= ADC_DATA_I_MON_RANGE_LOW && record.channelIndex < MAX_CHANNELS) {
+        record.value = m_adcScale[record.channelIndex][record.type] * record.data +
+            m_adcOffset[record.channelIndex][record.type];
+    } else {
+        record.value = NAN;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void resetStatistics(Statistics &stats) {
+    stats.count = 0;
+    stats.min = NAN;
+    stats.max = NAN;
+    stats.sum = 0;
+}
+
+void updateStatistics(Statistics &stats, const float *values, size_t n) {
+    // Values are processed in LANES independent lanes without branches,
+    // so the compiler can keep each lane in one element of the vector register.
+    static const size_t LANES = 8;
+
+    float minLanes[LANES];
+    float maxLanes[LANES];
+    float sumLanes[LANES];
+    uint32_t countLanes[LANES];
+    for (size_t j = 0; j < LANES; ++j) {
+        minLanes[j] = INFINITY;
+        maxLanes[j] = -INFINITY;
+        sumLanes[j] = 0;
+        countLanes[j] = 0;
+    }
+
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t j = 0; j < LANES; ++j) {
+            float value = values[i + j];
+            bool isValid = value == value;
+            float minValue = isValid ? value : INFINITY;
+            float maxValue = isValid ? value : -INFINITY;
+            minLanes[j] = minValue < minLanes[j] ? minValue : minLanes[j];
+            maxLanes[j] = maxValue > maxLanes[j] ? maxValue : maxLanes[j];
+            sumLanes[j] += isValid ? value : 0;
+            countLanes[j] += isValid;
+        }
+    }
+
+    for (; i < n; ++i) {
+        float value = values[i];
+        if (value == value) {
+            minLanes[0] = value < minLanes[0] ? value : minLanes[0];
+            maxLanes[0] = value > maxLanes[0] ? value : maxLanes[0];
+            sumLanes[0] += value;
+            ++countLanes[0];
+        }
+    }
+
+    for (size_t j = 0; j < LANES; ++j) {
+        if (countLanes[j] == 0) {
+            continue;
+        }
+        if (stats.count == 0 || minLanes[j] < stats.min) {
+            stats.min = minLanes[j];
+        }
+        if (stats.count == 0 || maxLanes[j] > stats.max) {
+            stats.max = maxLanes[j];
+        }
+        stats.sum += sumLanes[j];
+        stats.count += countLanes[j];
+    }
+}
+
+bool getStatistics(Reader &reader, Statistics *stats) {
+    if (reader.isAdcData()) {
+        return false;
+    }
+
+    int numColumns = reader.getNumColumns();
+    for (int i = 0; i < numColumns; ++i) {
+        resetStatistics(stats[i]);
+    }
+
+    static float samples[SAMPLES_BLOCK_SIZE * MAX_COLUMNS];
+    static float column[SAMPLES_BLOCK_SIZE];
+
+    reader.rewind();
+    size_t n;
+    while ((n = reader.readSamples(samples, SAMPLES_BLOCK_SIZE)) > 0) {
+        for (int i = 0; i < numColumns; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                column[j] = samples[j * numColumns + i];
+            }
+            updateStatistics(stats[i], column, n);
+        }
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool writeAdcDataCsv(Reader &reader, FILE *fp) {
+    fprintf(fp, "time,channel,type,data,value\n");
+
+    AdcRecord record;
+    while (reader.readAdcRecord(record)) {
+        if (record.type == ADC_DATA_GAP) {
+            fprintf(fp, "%.6f,,GAP,%d,\n", record.time * 1E-6, (int)record.data);
+        } else {
+            static const char *typeNames[] = { "U", "I_HIGH", "I_LOW" };
+            fprintf(fp, "%.6f,%d,%s,%d,%g\n", record.time * 1E-6, record.channelIndex + 1,
+                record.type <= ADC_DATA_I_MON_RANGE_LOW ? typeNames[record.type] : "?",
+                (int)record.data, record.value);
+        }
+    }
+
+    return !ferror(fp);
+}
+
+bool writeCsv(Reader &reader, FILE *fp) {
+    reader.rewind();
+
+    if (reader.isAdcData()) {
+        return writeAdcDataCsv(reader, fp);
+    }
+
+    int numColumns = reader.getNumColumns();
+
+    fprintf(fp, "time");
+    for (int i = 0; i < numColumns; ++i) {
+        char name[16];
+        reader.getColumnName(i, name, sizeof(name));
+        fprintf(fp, ",%s", name);
+    }
+    fprintf(fp, "\n");
+
+    static float samples[SAMPLES_BLOCK_SIZE * MAX_COLUMNS];
+    uint64_t sampleIndex = 0;
+    size_t n;
+    while ((n = reader.readSamples(samples, SAMPLES_BLOCK_SIZE)) > 0) {
+        for (size_t i = 0; i < n; ++i, ++sampleIndex) {
+            fprintf(fp, "%.6f", reader.getSampleTime(sampleIndex));
+            for (int j = 0; j < numColumns; ++j) {
+                float value = samples[i * numColumns + j];
+                if (value == value) {
+                    fprintf(fp, ",%g", value);
+                } else {
+                    // missed sample
+                    fprintf(fp, ",");
+                }
+            }
+            fprintf(fp, "\n");
+        }
+    }
+
+    return !ferror(fp);
+}
+
+static void putUint32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static void putUint64(uint8_t *p, uint64_t value) {
+    putUint32(p, (uint32_t)value);
+    putUint32(p + 4, (uint32_t)(value >> 32));
+}
+
+static void putDouble(uint8_t *p, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putUint64(p, bits);
+}
+
+static bool copyFile(FILE *src, FILE *dst) {
+    static uint8_t buffer[SAMPLES_BLOCK_SIZE * 4];
+
+    fseek(src, 0, SEEK_SET);
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), src)) > 0) {
+        if (fwrite(buffer, 1, n, dst) != n) {
+            return false;
+        }
+    }
+
+    return !ferror(src);
+}
+
+bool writeColumnar(Reader &reader, FILE *fp) {
+    if (reader.isAdcData()) {
+        return false;
+    }
+
+    int numColumns = reader.getNumColumns();
+
+    static float samples[SAMPLES_BLOCK_SIZE * MAX_COLUMNS];
+    static uint8_t column[SAMPLES_BLOCK_SIZE * 4];
+
+    // The file is decoded only once. Instead of keeping the whole log in
+    // memory, each column is collected in its own temporary file, which is
+    // then appended to the output after the header.
+    FILE *columnFiles[MAX_COLUMNS];
+    for (int i = 0; i < numColumns; ++i) {
+        columnFiles[i] = tmpfile();
+        if (!columnFiles[i]) {
+            for (int k = 0; k < i; ++k) {
+                fclose(columnFiles[k]);
+            }
+            return false;
+        }
+    }
+
+    bool result = true;
+
+    uint64_t numSamples = 0;
+    reader.rewind();
+    size_t n;
+    while (result && (n = reader.readSamples(samples, SAMPLES_BLOCK_SIZE)) > 0) {
+        numSamples += n;
+        for (int i = 0; i < numColumns; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                uint32_t bits;
+                memcpy(&bits, &samples[j * numColumns + i], sizeof(bits));
+                putUint32(column + j * 4, bits);
+            }
+            if (fwrite(column, 4, n, columnFiles[i]) != n) {
+                result = false;
+                break;
+            }
+        }
+    }
+
+    if (result) {
+        uint8_t header[40];
+        memcpy(header, "EEZDLOGC", 8);
+        putUint32(header + 8, numColumns);
+        putUint32(header + 12, reader.getNumPreTriggerSamples());
+        putUint64(header + 16, numSamples);
+        putDouble(header + 24, reader.getSampleTime(0));
+        putDouble(header + 32, reader.getHeader().period);
+        fwrite(header, 1, sizeof(header), fp);
+
+        for (int i = 0; i < numColumns; ++i) {
+            const Column &columnInfo = reader.getColumn(i);
+            uint8_t info[4] = { (uint8_t)columnInfo.type, (uint8_t)columnInfo.channelIndex, 0, 0 };
+            fwrite(info, 1, sizeof(info), fp);
+        }
+
+        for (int i = 0; i < numColumns && result; ++i) {
+            result = copyFile(columnFiles[i], fp);
+        }
+    }
+
+    for (int i = 0; i < numColumns; ++i) {
+        fclose(columnFiles[i]);
+    }
+
+    return result && !ferror(fp);
+}
+
+}
+}
+}
+} // namespace eez::psu::simulator::dlog_file
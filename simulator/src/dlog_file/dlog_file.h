@@ -0,0 +1,190 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+
+namespace eez {
+namespace psu {
+namespace simulator {
+/// Host side reader of the data logging files written by the firmware
+/// (see dlog.cpp), i.e. version 1 and 2 (compressed) files, with or
+/// without the pre-trigger samples, and ADC data files.
+namespace dlog_file {
+
+/// There are 4 bits per channel in the header columns.
+static const int MAX_CHANNELS = 8;
+static const int MAX_COLUMNS = MAX_CHANNELS * 3 + 1;
+
+struct Header {
+    uint32_t magic1;
+    uint32_t magic2;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t columns;
+    float period;
+    float time;
+    /// UTC, seconds since 1.1.1970.
+    uint32_t startTime;
+};
+
+enum ColumnType {
+    COLUMN_JITTER,
+    COLUMN_VOLTAGE,
+    COLUMN_CURRENT,
+    COLUMN_POWER
+};
+
+struct Column {
+    ColumnType type;
+    /// Zero based, -1 for COLUMN_JITTER.
+    int channelIndex;
+};
+
+enum AdcDataType {
+    ADC_DATA_U_MON,
+    ADC_DATA_I_MON_RANGE_HIGH,
+    ADC_DATA_I_MON_RANGE_LOW,
+    ADC_DATA_GAP = 0xFF
+};
+
+struct AdcRecord {
+    /// Microseconds from the start of logging.
+    uint64_t time;
+    int16_t data;
+    uint8_t channelIndex;
+    uint8_t type;
+    /// Data converted to volts or amperes, NaN for ADC_DATA_GAP.
+    float value;
+};
+
+class Reader {
+public:
+    Reader();
+    ~Reader();
+
+    /// Memory maps the file and parses the header.
+    bool open(const char *filePath);
+    /// Parses the file already in memory, data must be valid until close.
+    bool open(const uint8_t *data, size_t size);
+    void close();
+
+    /// Description of the last open or read error.
+    const char *getError() const { return m_error; }
+
+    const Header &getHeader() const { return m_header; }
+    bool isCompressed() const;
+    bool isAdcData() const;
+
+    int getNumColumns() const { return m_numColumns; }
+    const Column &getColumn(int i) const { return m_columns[i]; }
+    /// For example "U1", "I2", "P1" or "jitter".
+    void getColumnName(int i, char *name, size_t size) const;
+
+    uint32_t getNumPreTriggerSamples() const { return m_numPreTriggerSamples; }
+    /// Time of the sample in seconds, relative to the trigger.
+    double getSampleTime(uint64_t sampleIndex) const;
+
+    /// Restarts reading from the first sample or record.
+    void rewind();
+
+    /// Reads at most maxSamples samples, getNumColumns() values each, and
+    /// returns the number of samples read, 0 at the end of file.
+    size_t readSamples(float *values, size_t maxSamples);
+
+    /// Reads the next record of the ADC data file.
+    bool readAdcRecord(AdcRecord &record);
+
+    /// True if the file ends in the middle of the sample or record,
+    /// e.g. logging was interrupted by the power down.
+    bool isTruncated() const { return m_truncated; }
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+    bool m_mapped;
+    const char *m_error;
+
+    Header m_header;
+    int m_numColumns;
+    Column m_columns[MAX_COLUMNS];
+    uint32_t m_numPreTriggerSamples;
+    float m_firstSampleTime;
+
+    // ADC data conversion, value = scale * data + offset
+    float m_adcScale[MAX_CHANNELS][3];
+    float m_adcOffset[MAX_CHANNELS][3];
+    uint32_t m_adcStartTime;
+
+    size_t m_samplesOffset;
+    size_t m_offset;
+    uint64_t m_sampleIndex;
+    uint32_t m_previousValues[MAX_COLUMNS];
+    uint32_t m_lastAdcTime;
+    uint64_t m_adcTime;
+    bool m_truncated;
+
+    bool parseHeader();
+    bool readSample(float *values);
+    bool readCompressedSample(float *values);
+};
+
+/// Statistics of one column, NaN values (missed samples) are not counted.
+struct Statistics {
+    uint64_t count;
+    float min;
+    float max;
+    double sum;
+
+    double getMean() const { return count > 0 ? sum / count : NAN; }
+};
+
+void resetStatistics(Statistics &stats);
+/// Adds n contiguous values of one column.
+void updateStatistics(Statistics &stats, const float *values, size_t n);
+/// Reads all the samples and computes the statistics of each column.
+bool getStatistics(Reader &reader, Statistics *stats);
+
+/// Writes all the samples or ADC records as CSV, first column is the time.
+bool writeCsv(Reader &reader, FILE *fp);
+
+/// Writes all the samples in the columnar binary format, little endian:
+///
+///     char magic[8];                  "EEZDLOGC"
+///     uint32_t numColumns;
+///     uint32_t numPreTriggerSamples;
+///     uint64_t numSamples;
+///     double firstSampleTime;         seconds, relative to the trigger
+///     double period;                  seconds
+///     uint8_t type, channelIndex, reserved[2];   for each column, see Column
+///
+/// followed by numSamples floats for each column. Time of the sample i is
+/// firstSampleTime + i * period for the pre-trigger samples, and
+/// (i - numPreTriggerSamples) * period for the rest, i.e. the first sample
+/// after the pre-trigger ones is logged at the trigger (see getSampleTime).
+/// ADC data files are not supported.
+bool writeColumnar(Reader &reader, FILE *fp);
+
+}
+}
+}
+} // namespace eez::psu::simulator::dlog_file
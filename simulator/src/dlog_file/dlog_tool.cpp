@@ -0,0 +1,178 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Command line tool for the data logging files (see "make dlog_tool"):
+ *
+ *     dlog_tool info <file.dlog>
+ *     dlog_tool stats <file.dlog>
+ *     dlog_tool csv <file.dlog> [<output.csv>]
+ *     dlog_tool columnar <file.dlog> <output>
+ *
+ * Output is written to stdout if output file is not given.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dlog_file.h"
+
+using namespace eez::psu::simulator::dlog_file;
+
+static void printUsage() {
+    fprintf(stderr,
+        "Usage:\n"
+        "    dlog_tool info <file.dlog>\n"
+        "    dlog_tool stats <file.dlog>\n"
+        "    dlog_tool csv <file.dlog> [<output.csv>]\n"
+        "    dlog_tool columnar <file.dlog> <output>\n");
+}
+
+static void printInfo(Reader &reader) {
+    const Header &header = reader.getHeader();
+
+    time_t startTime = header.startTime;
+    char startTimeStr[32];
+    strftime(startTimeStr, sizeof(startTimeStr), "%Y-%m-%d %H:%M:%S", gmtime(&startTime));
+
+    printf("version: %d%s\n", header.version, reader.isCompressed() ? " (compressed)" : "");
+    printf("mode: %s\n", reader.isAdcData() ? "ADC" : "periodic");
+    printf("start time: %s UTC\n", startTimeStr);
+    if (!reader.isAdcData()) {
+        printf("period: %g s\n", header.period);
+    }
+    printf("duration: %g s\n", header.time);
+
+    printf("columns:");
+    for (int i = 0; i < reader.getNumColumns(); ++i) {
+        char name[16];
+        reader.getColumnName(i, name, sizeof(name));
+        printf(" %s", name);
+    }
+    printf("\n");
+
+    if (reader.isAdcData()) {
+        uint64_t numRecords = 0;
+        uint64_t numLost = 0;
+        AdcRecord record;
+        while (reader.readAdcRecord(record)) {
+            if (record.type == ADC_DATA_GAP) {
+                numLost += record.data;
+            } else {
+                ++numRecords;
+            }
+        }
+        printf("records: %llu\n", (unsigned long long)numRecords);
+        printf("lost records: %llu\n", (unsigned long long)numLost);
+    } else {
+        static float samples[1024 * MAX_COLUMNS];
+        uint64_t numSamples = 0;
+        size_t n;
+        while ((n = reader.readSamples(samples, 1024)) > 0) {
+            numSamples += n;
+        }
+        printf("samples: %llu\n", (unsigned long long)numSamples);
+        printf("pre-trigger samples: %u\n", (unsigned)reader.getNumPreTriggerSamples());
+    }
+
+    if (reader.isTruncated()) {
+        printf("file is truncated\n");
+    }
+}
+
+static bool printStatistics(Reader &reader) {
+    Statistics stats[MAX_COLUMNS];
+    if (!getStatistics(reader, stats)) {
+        fprintf(stderr, "Statistics are not supported for ADC data\n");
+        return false;
+    }
+
+    printf("column,count,min,max,mean\n");
+    for (int i = 0; i < reader.getNumColumns(); ++i) {
+        char name[16];
+        reader.getColumnName(i, name, sizeof(name));
+        printf("%s,%llu,%g,%g,%g\n", name, (unsigned long long)stats[i].count,
+            stats[i].min, stats[i].max, stats[i].getMean());
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+
+    const char *command = argv[1];
+
+    Reader reader;
+    if (!reader.open(argv[2])) {
+        fprintf(stderr, "%s: %s\n", argv[2], reader.getError());
+        return 1;
+    }
+
+    if (strcmp(command, "info") == 0) {
+        printInfo(reader);
+        return 0;
+    }
+
+    if (strcmp(command, "stats") == 0) {
+        return printStatistics(reader) ? 0 : 1;
+    }
+
+    if (strcmp(command, "csv") == 0 || strcmp(command, "columnar") == 0) {
+        bool columnar = strcmp(command, "columnar") == 0;
+
+        if (columnar && argc < 4) {
+            printUsage();
+            return 1;
+        }
+
+        if (columnar && reader.isAdcData()) {
+            fprintf(stderr, "Columnar output is not supported for ADC data\n");
+            return 1;
+        }
+
+        FILE *fp = stdout;
+        if (argc >= 4) {
+            fp = fopen(argv[3], columnar ? "wb" : "w");
+            if (!fp) {
+                fprintf(stderr, "%s: can't create file\n", argv[3]);
+                return 1;
+            }
+        }
+
+        bool result = columnar ? writeColumnar(reader, fp) : writeCsv(reader, fp);
+
+        if (fp != stdout) {
+            result = fclose(fp) == 0 && result;
+        }
+
+        if (!result) {
+            fprintf(stderr, "Write error\n");
+            return 1;
+        }
+
+        return 0;
+    }
+
+    printUsage();
+    return 1;
+}
@@ -27,10 +27,10 @@ namespace arduino {
 class EthernetClient {
 public:
     EthernetClient();
-    EthernetClient(bool valid);
+    EthernetClient(int id);
 
     operator bool();
-    bool operator==(EthernetClient &other) { return true; }
+    bool operator==(EthernetClient &other) { return id == other.id; }
 
     bool connected();
 
@@ -42,7 +42,8 @@ public:
     void stop();
 
 private:
-    bool valid;
+    /// client index in the ethernet_platform, -1 if not valid
+    int id;
 };
 
 }
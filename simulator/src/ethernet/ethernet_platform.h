@@ -22,16 +22,23 @@ namespace eez {
 namespace psu {
 namespace ethernet_platform {
 
+/// Max. number of connected clients, there is one more then in the firmware,
+/// so the firmware can send the error message to the client it has to reject.
+static const int MAX_CLIENTS = ETHERNET_MAX_CLIENTS + 1;
+
 bool bind(int port);
-bool client_available();
 
-bool connected();
+/// Accepts new client or finds connected client with the data available.
+/// Returns client index or -1 if there is no such client.
+int client_available();
+
+bool connected(int client);
 
-int available();
-int read(char *buffer, int buffer_size);
-int write(const char *buffer, int buffer_size);
+int available(int client);
+int read(int client, char *buffer, int buffer_size);
+int write(int client, const char *buffer, int buffer_size);
 
-void stop();
+void stop(int client);
 
 }
 }
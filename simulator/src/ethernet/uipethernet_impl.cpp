@@ -63,7 +63,7 @@ IPAddress SimulatorEthernet::dnsServerIP() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-EthernetServer::EthernetServer(int port_) : port(port_), client(true) {
+EthernetServer::EthernetServer(int port_) : port(port_) {
 }
 
 void EthernetServer::begin() {
@@ -72,42 +72,44 @@ void EthernetServer::begin() {
 
 EthernetClient EthernetServer::available() {
     if (!bind_result) return EthernetClient();
-    return client;
+    return EthernetClient(ethernet_platform::client_available());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-EthernetClient::EthernetClient() : valid(false) {
+EthernetClient::EthernetClient() : id(-1) {
 }
 
-EthernetClient::EthernetClient(bool valid_) : valid(valid_) {
+EthernetClient::EthernetClient(int id_) : id(id_) {
 }
 
 bool EthernetClient::connected() {
-    return ethernet_platform::connected();
+    return id != -1 && ethernet_platform::connected(id);
 }
 
 EthernetClient::operator bool() {
-    return valid && ethernet_platform::client_available();
+    return connected();
 }
 
 size_t EthernetClient::available() {
-    return ethernet_platform::available();
+    return id != -1 ? ethernet_platform::available(id) : 0;
 }
 
 size_t EthernetClient::read(uint8_t* buffer, size_t buffer_size) {
-    return ethernet_platform::read((char *)buffer, (int)buffer_size);
+    return id != -1 ? ethernet_platform::read(id, (char *)buffer, (int)buffer_size) : 0;
 }
 
 size_t EthernetClient::write(const char *buffer, size_t buffer_size) {
-    return ethernet_platform::write(buffer, (int)buffer_size);
+    return id != -1 ? ethernet_platform::write(id, buffer, (int)buffer_size) : 0;
 }
 
 void EthernetClient::flush() {
 }
 
 void EthernetClient::stop() {
-    ethernet_platform::stop();
+    if (id != -1) {
+        ethernet_platform::stop(id);
+    }
 }
 
 }
@@ -24,7 +24,37 @@
 
 using namespace eez::psu;
 
-int main() {
+static void usage() {
+    printf("Usage: eez_psu_sim [--time-scale=<scale>|max]\n");
+}
+
+static bool parseArgs(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--time-scale=", 13) == 0) {
+            const char *value = arg + 13;
+            if (strcmp(value, "max") == 0) {
+                simulator::setTimeScale(0);
+            } else {
+                float scale = (float)atof(value);
+                if (scale != 0 && (scale < SIM_TIME_SCALE_MIN || scale > SIM_TIME_SCALE_MAX)) {
+                    return false;
+                }
+                simulator::setTimeScale(scale);
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!parseArgs(argc, argv)) {
+        usage();
+        return 1;
+    }
+
     simulator::init();
     boot();
     main_loop();
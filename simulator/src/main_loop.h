@@ -18,7 +18,5 @@
 
 #pragma once
 
-#define TICK_TIMEOUT 1
-
 int main_loop();
 void main_loop_exit();
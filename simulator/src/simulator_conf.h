@@ -32,3 +32,17 @@
 
 #define SIM_FRONT_PANEL_LARGE_MODE_MIN_WIDTH 2560
 
+// time scale 0 (or MAXimum in SIMUlator:TIME:SCALe) is fast forward mode,
+// see simulator::setTimeScale
+#define SIM_TIME_SCALE_MIN 0.001f
+#define SIM_TIME_SCALE_DEF 1.0f
+#define SIM_TIME_SCALE_MAX 1000000.0f
+
+// main loop is executed at least this often (microseconds, simulator time),
+// also when there is no deadline (see simulator::getTimeToNextTick)
+#define SIM_MAX_TICK_PERIOD 100000
+
+// ethernet client which doesn't read the output is closed if its socket
+// is not writable for this long (milliseconds, real time)
+#define SIM_CLIENT_WRITE_TIMEOUT 5000
+
@@ -23,6 +23,8 @@
 #endif
 
 #include "main_loop.h"
+#include "simulator_timer.h"
+#include "scheduler.h"
 
 // for home directory (see getConfFilePath)
 #ifdef _WIN32
@@ -53,8 +55,37 @@ void init() {
     }
 }
 
+static void updateNextTick(uint32_t deadline, uint32_t &timeout, uint32_t now) {
+    int32_t diff = (int32_t)(deadline - now);
+    if (diff < 0) {
+        diff = 0;
+    }
+    if ((uint32_t)diff < timeout) {
+        timeout = diff;
+    }
+}
+
+uint32_t getTimeToNextTick() {
+    uint32_t now = micros();
+    uint32_t timeout = SIM_MAX_TICK_PERIOD;
+
+    uint32_t deadline;
+    if (scheduler::getNextDeadline(deadline)) {
+        updateNextTick(deadline, timeout, now);
+    }
+    if (timer::getDeadline(deadline)) {
+        updateNextTick(deadline, timeout, now);
+    }
+
+    return timeout;
+}
+
 void tick() {
+    // in the fast forward mode there is nothing to do until the next deadline
+    advanceTime(getTimeToNextTick());
+
     chips::tick();
+    timer::tick();
     psu::tick();
 #if OPTION_DISPLAY
     front_panel::tick();
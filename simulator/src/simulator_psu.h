@@ -32,6 +32,8 @@
 #include <string.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
 
 #define PSTR(U) U
 #define strcpy_P strcpy
@@ -45,9 +47,6 @@
 
 extern void eez_psu_init();
 
-#define interrupts() 0
-#define noInterrupts() 0
-
 namespace eez {
 namespace psu {
 /// Firmware simulator.
@@ -56,11 +55,27 @@ namespace simulator {
 void init();
 void tick();
 
+/// Returns the simulator time, in microseconds, until the main loop has to
+/// be executed again, i.e. until the next scheduler or timer deadline,
+/// 0 if it is already due and at most SIM_MAX_TICK_PERIOD.
+uint32_t getTimeToNextTick();
+
 void setTemperature(int sensor, float value);
 float getTemperature(int sensor);
 
 char *getConfFilePath(const char *file_name);
 
+/// Sets the speed of the simulator clock relative to the real time.
+/// Time scale 0 is fast forward mode: clock jumps to the next deadline
+/// (see getTimeToNextTick) on each main loop pass, and it is advanced
+/// by delay, regardless of the real time.
+void setTimeScale(float scale);
+float getTimeScale();
+/// Advances the simulator clock, only in the fast forward mode.
+void advanceTime(uint32_t microseconds);
+/// Current simulator time as UTC seconds, used by the RTC chip.
+time_t getUtcTime();
+
 void exit();
 
 }
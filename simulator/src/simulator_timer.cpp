@@ -0,0 +1,188 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "psu.h"
+#include "simulator_timer.h"
+#include "thread.h"
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+namespace eez {
+namespace psu {
+namespace simulator {
+namespace timer {
+
+#define WAIT_INFINITE 0xFFFFFFFF
+
+static bool g_threadStarted;
+static bool g_armed;
+// simulator time, in microseconds
+static uint32_t g_deadline;
+static TimerCallback g_callback;
+
+#ifdef _WIN32
+static CRITICAL_SECTION g_mutex;
+static CONDITION_VARIABLE g_condition;
+#else
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_condition = PTHREAD_COND_INITIALIZER;
+#endif
+
+static void lock() {
+#ifdef _WIN32
+    EnterCriticalSection(&g_mutex);
+#else
+    pthread_mutex_lock(&g_mutex);
+#endif
+}
+
+static void unlock() {
+#ifdef _WIN32
+    LeaveCriticalSection(&g_mutex);
+#else
+    pthread_mutex_unlock(&g_mutex);
+#endif
+}
+
+static void notify() {
+#ifdef _WIN32
+    WakeConditionVariable(&g_condition);
+#else
+    pthread_cond_signal(&g_condition);
+#endif
+}
+
+/// Waits for the notify or the timeout (real time), mutex must be locked.
+static void wait(uint32_t timeoutUs) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&g_condition, &g_mutex, timeoutUs == WAIT_INFINITE ? INFINITE : (timeoutUs + 999) / 1000);
+#else
+    if (timeoutUs == WAIT_INFINITE) {
+        pthread_cond_wait(&g_condition, &g_mutex);
+    } else {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t nsec = ts.tv_nsec + (uint64_t)timeoutUs * 1000;
+        ts.tv_sec += (time_t)(nsec / 1000000000);
+        ts.tv_nsec = (long)(nsec % 1000000000);
+        pthread_cond_timedwait(&g_condition, &g_mutex, &ts);
+    }
+#endif
+}
+
+/// Disarms the timer and returns the callback if the timer is expired,
+/// mutex must be locked.
+static TimerCallback takeExpired() {
+    if (g_armed && (int32_t)(micros() - g_deadline) >= 0) {
+        g_armed = false;
+        return g_callback;
+    }
+    return 0;
+}
+
+static void execute(TimerCallback callback) {
+    noInterrupts();
+    callback();
+    interrupts();
+}
+
+static THREAD_PROC(timerThread) {
+    lock();
+
+    while (true) {
+        TimerCallback callback = takeExpired();
+        if (callback) {
+            // callback can start the timer again
+            unlock();
+            execute(callback);
+            lock();
+            continue;
+        }
+
+        float timeScale = getTimeScale();
+        if (!g_armed || timeScale == 0) {
+            wait(WAIT_INFINITE);
+        } else {
+            wait((uint32_t)((int32_t)(g_deadline - micros()) / timeScale));
+        }
+    }
+
+    return 0;
+}
+
+void start(uint32_t timeoutUs, TimerCallback callback) {
+    if (!g_threadStarted) {
+#ifdef _WIN32
+        InitializeCriticalSection(&g_mutex);
+        InitializeConditionVariable(&g_condition);
+#endif
+        eez_thread_create(timerThread, 0);
+        g_threadStarted = true;
+    }
+
+    lock();
+    g_deadline = micros() + timeoutUs;
+    g_callback = callback;
+    g_armed = true;
+    notify();
+    unlock();
+}
+
+void stop() {
+    if (!g_threadStarted) {
+        return;
+    }
+
+    lock();
+    g_armed = false;
+    unlock();
+}
+
+void tick() {
+    if (!g_threadStarted) {
+        return;
+    }
+
+    lock();
+    TimerCallback callback = takeExpired();
+    unlock();
+
+    if (callback) {
+        execute(callback);
+    }
+}
+
+bool getDeadline(uint32_t &deadline) {
+    if (!g_threadStarted) {
+        return false;
+    }
+
+    lock();
+    bool armed = g_armed;
+    deadline = g_deadline;
+    unlock();
+
+    return armed;
+}
+
+}
+}
+}
+} // namespace eez::psu::simulator::timer
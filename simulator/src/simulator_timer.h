@@ -0,0 +1,47 @@
+/*
+ * EEZ PSU Firmware
+ * Copyright (C) 2018-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace eez {
+namespace psu {
+namespace simulator {
+/// Simulation of the hardware timer compare interrupt, i.e. one shot
+/// high resolution timer. Callback is executed from the timer thread while
+/// the interrupts are disabled (see arduino::noInterrupts). In the fast
+/// forward mode simulator clock is not related to the real time, so then
+/// expired timer is executed from the main loop (see tick).
+namespace timer {
+
+typedef void (*TimerCallback)();
+
+/// Starts the timer, callback is executed after the timeout (simulator time).
+/// Previously started timer is replaced.
+void start(uint32_t timeoutUs, TimerCallback callback);
+void stop();
+
+/// Executes the callback if the timer is expired.
+void tick();
+
+/// Returns false if the timer is not armed.
+bool getDeadline(uint32_t &deadline);
+
+}
+}
+}
+} // namespace eez::psu::simulator::timer